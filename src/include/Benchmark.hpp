@@ -0,0 +1,34 @@
+#pragma once
+
+#include <functional>
+
+// 微基准测试，通过 lvglsim -b <名称> 运行后直接退出，-b list 列出所有项目
+
+typedef struct {
+    int iterations;
+    double avg_us;
+    double min_us;
+    double p50_us;
+    double p99_us;
+} benchmark_stat_t;
+
+// 先预热 warmup 次，再运行 iterations 次并统计每次耗时
+benchmark_stat_t benchmark_measure(const std::function<void()> & func, int iterations, int warmup = 10);
+void benchmark_print(const char * label, const benchmark_stat_t & stat);
+
+int run_benchmark(const char * name);
+
+// 各模块的基准测试
+int benchmark_preprocess();
+int benchmark_yolo_postprocess();
+int benchmark_nms();
+int benchmark_executor();
+int benchmark_thread_pool();
+int benchmark_trace();
+int benchmark_frame_ring();
+int benchmark_face_gallery();
+int benchmark_face_gallery_ann();
+int benchmark_face_gallery_precision();
+int benchmark_face_gallery_store();
+int benchmark_npu_scheduler();
+int benchmark_pipeline();
@@ -1,35 +1,44 @@
 #pragma once
 
+#include "Frame.hpp"
+#include "FrameSource.hpp"
+#include "V4l2Capture.hpp"
 #include "opencv2/opencv.hpp"
-#include <atomic>
-#include <condition_variable>
-#include <memory>
-#include <thread>
+#include <string>
 
 // #define CAMERA_WIDTH 3840
 // #define CAMERA_HEIGHT 2160
 /* 1280x720 */
 #define CAMERA_WIDTH 1280
 #define CAMERA_HEIGHT 720
-
-class Camera {
+#define CAMERA_FPS 30
+
+#define CAMERA_DEVICE "/dev/video21"
+// 采集后端: v4l2(默认，失败时回退) / opencv
+#define CAMERA_BACKEND_ENV "CAMERA_BACKEND"
+// V4L2 缓冲区数量
+#define CAMERA_BUFFER_COUNT_ENV "CAMERA_BUFFER_COUNT"
+
+typedef struct {
+    std::string device{CAMERA_DEVICE};
+    int width{CAMERA_WIDTH};
+    int height{CAMERA_HEIGHT};
+    int fps{CAMERA_FPS};
+} camera_config_t;
+
+class Camera : public FrameSource {
   private:
-    cv::VideoCapture capture_;
-
-    std::queue<std::shared_ptr<cv::Mat>> frame_queue_;
+    camera_config_t config_;
 
-    std::mutex frame_queue_mutex_;
-    std::condition_variable frame_queue_cond_;
+    V4l2Capture v4l2_;
+    cv::VideoCapture capture_; // V4L2 打开失败或指定 opencv 后端时使用
 
-    std::atomic_bool is_running_;
-    std::thread capture_thread_;
-    std::function<void()> capture_thread_fn_;
+  protected:
+    // 从当前采集后端读取一帧
+    bool read_frame(Frame & frame) override;
+    void open_stream() override;
+    void close_stream() override;
 
   public:
-    Camera();
-
-    void start();
-    void stop();
-
-    std::shared_ptr<cv::Mat> get_frame();
-};
\ No newline at end of file
+    explicit Camera(const camera_config_t & config = camera_config_t(), int stream_id = 0);
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Camera.hpp"
+#include "FileSource.hpp"
+#include "ImageProcess.hpp"
+#include "RknnPool.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 摄像头列表，逗号分隔，每项为 设备[:宽x高[@帧率]]，例如 /dev/video21,/dev/video23:1920x1080@30
+// 不以 /dev/ 开头的项作为视频文件或网络流(FileSource)打开，例如 /data/gate.mp4,rtsp://host/live
+// 未设置时只打开 CAMERA_DEVICE
+#define CAMERA_MANAGER_DEVICES_ENV "CAMERA_DEVICES"
+// 定期打印各路统计的间隔(毫秒)，未设置时只在停止时打印
+#define CAMERA_MANAGER_REPORT_INTERVAL_ENV "CAMERA_REPORT_INTERVAL_MS"
+// 每路保留的最近延迟样本数
+#define CAMERA_MANAGER_LATENCY_SAMPLES 256
+// next_frame 等待新帧的超时时间
+#define CAMERA_MANAGER_WAIT_MS 200
+// 界面显示、推流和报警使用的一路
+#define CAMERA_MANAGER_PRIMARY_STREAM 0
+
+typedef struct {
+    int stream_id;
+    frame_ring_stats_t capture; // 本次启动以来的采集统计
+    uint64_t submitted;         // 送入推理的帧数
+    uint64_t completed;         // 取到推理结果的帧数
+    double capture_fps;
+    double result_fps;
+    double latency_p50_ms; // 从采集到取到结果
+    double latency_p99_ms;
+} camera_stream_stats_t;
+
+/**
+ * @brief 多路摄像头管理
+ *
+ * 按配置打开多路摄像头，轮流从各路取帧送入同一个 SecurityRknnPool：
+ * 每次从上一次取帧的下一路开始查找，每路一次只取一帧，帧率高的一路不会挤占其他路。
+ * 每路帧序号独立，推理结果进入 SecurityRknnPool 中该路自己的结果队列。
+ * 主路结果由界面取走，其他路的结果通过 drain_results 交给各路回调。
+ */
+class CameraManager {
+  public:
+    explicit CameraManager(const std::vector<camera_config_t> & configs);
+
+    // 从 CAMERA_DEVICES 读取配置
+    static std::vector<camera_config_t> load_config();
+
+    int size();
+    FrameSource & get_source(int stream_id);
+
+    // 按各路实际分辨率创建预处理，model_size 为检测模型输入尺寸，已创建时不再重复创建
+    void init_image_process(int model_size);
+    ImageProcess & get_image_process(int stream_id);
+
+    void start();
+    void stop();
+
+    // 轮流取出下一帧，超时或已停止时返回 false
+    bool next_frame(Frame & frame, int timeout_ms = CAMERA_MANAGER_WAIT_MS);
+
+    // 记录一路取到的结果，用于统计吞吐和延迟
+    void record_result(const Frame & frame);
+    // 取出主路以外已完成的结果交给回调，没有设置回调的一路直接丢弃
+    void drain_results(SecurityRknnPool & pool);
+    // 需在 start 之前设置，回调在调用 drain_results 的线程中执行
+    void set_result_callback(int stream_id, std::function<void(Frame)> callback);
+
+    camera_stream_stats_t get_stats(int stream_id);
+    void print_stats();
+    // 按 CAMERA_REPORT_INTERVAL_MS 定期打印
+    void report_if_due();
+
+  private:
+    struct Stream {
+        std::unique_ptr<FrameSource> source;
+        std::unique_ptr<ImageProcess> image_process;
+        std::function<void(Frame)> result_callback;
+
+        frame_ring_stats_t capture_base; // 启动时的采集统计，用于计算本次启动以来的数据
+        uint64_t submitted{0};
+        uint64_t completed{0};
+        std::deque<double> latencies_ms;
+    };
+
+    std::vector<std::unique_ptr<Stream>> streams_;
+
+    std::mutex frame_mutex_;
+    std::condition_variable frame_cond_;
+    uint64_t frame_signal_{0}; // 任意一路写入新帧时加一
+    int next_stream_{0};
+    bool is_running_{false};
+
+    std::mutex stats_mutex_;
+    std::chrono::steady_clock::time_point start_time_;
+    std::chrono::steady_clock::time_point last_report_time_;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+// 各队列的线程数
+#define EXECUTOR_IO_THREADS 2
+#define EXECUTOR_UI_THREADS 1
+#define EXECUTOR_NPU_THREADS 1
+
+// IO: 传感器轮询、取帧等会阻塞的操作
+// UI: OLED、报警提示音等外设显示，单线程保证顺序执行
+// NPU: 推理池之外需要提交给 NPU 的零散任务(人脸录入等)
+enum class ExecutorQueue {
+    IO = 0,
+    UI,
+    NPU,
+    COUNT,
+};
+
+typedef struct {
+    const char * name;
+    size_t threads;
+    size_t pending;   // 等待执行的任务数
+    size_t running;   // 正在执行的任务数
+    size_t submitted; // 累计提交的任务数
+    size_t completed; // 累计完成的任务数
+} executor_queue_metrics_t;
+
+typedef struct {
+    size_t threads_created; // 进程启动以来所有 ThreadPool 创建的线程数
+    executor_queue_metrics_t queues[(int)ExecutorQueue::COUNT];
+} executor_metrics_t;
+
+/**
+ * @brief 进程级常驻执行器
+ *
+ * 替代流水线中按帧/按事件创建的 std::thread 和 std::async，所有线程在第一次使用时一次性创建。
+ * post 提交的任务抛出的异常会被捕获并打印，不会导致线程退出。
+ */
+class Executor {
+  public:
+    static Executor & instance();
+
+    Executor(const Executor &)             = delete;
+    Executor & operator=(const Executor &) = delete;
+
+    void post(ExecutorQueue queue, std::function<void()> task);
+
+    executor_metrics_t metrics();
+    void print_metrics();
+
+  private:
+    struct Queue {
+        const char * name;
+        std::unique_ptr<ThreadPool> pool;
+        std::atomic<size_t> running{0};
+        std::atomic<size_t> submitted{0};
+        std::atomic<size_t> completed{0};
+    };
+
+    Queue queues_[(int)ExecutorQueue::COUNT];
+
+    Executor();
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Facenet 输出的特征维数
+#define FACE_GALLERY_DIM 128
+// 特征矩阵按缓存行对齐，每行 FACE_GALLERY_DIM 个元素在各精度下都是缓存行的整数倍
+#define FACE_GALLERY_ALIGNMENT 64
+// 图库中特征的存储精度: fp32(默认)、fp16、int8(每行一个对称缩放系数)
+#define FACE_GALLERY_PRECISION_ENV "FACE_GALLERY_PRECISION"
+
+enum class FaceEmbeddingPrecision {
+    FP32,
+    FP16,
+    INT8,
+};
+
+// 读取 FACE_GALLERY_PRECISION，未设置或无法识别时为 FP32
+FaceEmbeddingPrecision face_embedding_precision_from_env();
+const char * face_embedding_precision_name(FaceEmbeddingPrecision precision);
+size_t face_embedding_row_bytes(FaceEmbeddingPrecision precision);
+
+// 按行连续存放的特征，scales 为 int8 每行的缩放系数，其他精度为 1
+typedef struct {
+    FaceEmbeddingPrecision precision;
+    const uint8_t * data;
+    const float * scales;
+} face_embedding_matrix_t;
+
+// 查询特征，按存储精度预先转换好，检索时每行不再转换查询
+typedef struct {
+    alignas(FACE_GALLERY_ALIGNMENT) float fp32[FACE_GALLERY_DIM];
+    alignas(FACE_GALLERY_ALIGNMENT) int8_t int8[FACE_GALLERY_DIM];
+    float scale; // int8 的缩放系数
+} face_query_t;
+
+// 归一化为单位向量，模长为 0 时返回 false
+bool face_embedding_normalize(const float * embedding, float * normalized);
+float face_embedding_dot(const float * a, const float * b);
+float face_embedding_dot_fp16(const float * a, const uint16_t * b);
+int32_t face_embedding_dot_int8(const int8_t * a, const int8_t * b);
+
+// 把单位向量按精度写入 row，返回该行的缩放系数
+float face_embedding_encode(FaceEmbeddingPrecision precision, const float * normalized, uint8_t * row);
+void face_query_init(FaceEmbeddingPrecision precision, const float * normalized, face_query_t & query);
+// 用矩阵中的一行作为查询，用于行与行之间的比较
+void face_query_from_row(const face_embedding_matrix_t & matrix, int row, face_query_t & query);
+
+// 查询与第 row 行的余弦相似度，直接在压缩后的数据上计算
+inline float face_embedding_score(const face_embedding_matrix_t & matrix, const face_query_t & query, int row)
+{
+    switch(matrix.precision) {
+        case FaceEmbeddingPrecision::FP16:
+            return face_embedding_dot_fp16(query.fp32,
+                                           (const uint16_t *)(matrix.data + (size_t)row * FACE_GALLERY_DIM * 2));
+        case FaceEmbeddingPrecision::INT8:
+            return face_embedding_dot_int8(query.int8, (const int8_t *)(matrix.data + (size_t)row * FACE_GALLERY_DIM)) *
+                   query.scale * matrix.scales[row];
+        default:
+            return face_embedding_dot(query.fp32, (const float *)(matrix.data + (size_t)row * FACE_GALLERY_DIM * 4));
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "FaceEmbedding.hpp"
+#include "FaceHnsw.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+// 余弦相似度超过该值认为是同一人，单位向量下与原来的欧氏距离 0.6 等价(d^2 = 2 - 2cos)
+#define FACE_GALLERY_MATCH_THRESHOLD 0.82f
+#define FACE_GALLERY_INITIAL_CAPACITY 64
+// 检索方式: exact 逐行扫描(默认)，hnsw 使用近似最近邻索引
+#define FACE_GALLERY_INDEX_ENV "FACE_GALLERY_INDEX"
+// HNSW 查询时的候选数，默认 FACE_HNSW_EF_SEARCH
+#define FACE_GALLERY_HNSW_EF_ENV "FACE_GALLERY_HNSW_EF"
+// 身份数达到该值才走 HNSW，规模较小时逐行扫描已经足够快且结果精确
+#define FACE_GALLERY_HNSW_MIN_SIZE 10000
+
+enum class FaceGalleryIndex {
+    EXACT,
+    HNSW,
+};
+
+// 读取 FACE_GALLERY_INDEX，未设置或无法识别时为 EXACT
+FaceGalleryIndex face_gallery_index_from_env();
+
+typedef struct {
+    int id;        // 最相似的身份(录入顺序)，图库为空时为 -1
+    float score;   // 余弦相似度
+    float margin;  // 与第二相似身份的分差，只有一个身份时为 score + 1
+    bool is_match; // score 是否超过 FACE_GALLERY_MATCH_THRESHOLD
+} face_match_t;
+
+/**
+ * @brief 人脸特征图库
+ *
+ * 录入时把特征归一化为单位向量，按行存入一块对齐的连续矩阵，查询时归一化后逐行点积即为余弦相似度，
+ * 有 NEON 时使用 NEON 计算。查询可以在多个推理线程中同时进行，录入时独占。
+ * 特征可以按 fp16 或 int8 存储，内存为 fp32 的 1/2 或 1/4，检索直接在压缩后的数据上计算。
+ * 使用 HNSW 时录入同时插入索引，身份数达到 FACE_GALLERY_HNSW_MIN_SIZE 后查询走索引，结果为近似最近邻。
+ */
+class FaceGallery {
+  public:
+    explicit FaceGallery(FaceGalleryIndex index = face_gallery_index_from_env(),
+                         FaceEmbeddingPrecision precision = face_embedding_precision_from_env());
+    ~FaceGallery();
+
+    FaceGallery(const FaceGallery &)             = delete;
+    FaceGallery & operator=(const FaceGallery &) = delete;
+
+    // embedding 为 FACE_GALLERY_DIM 维，返回新身份的 id，特征全零时返回 -1
+    int add(const float * embedding);
+    // 删除后 id 不再出现在检索结果中，其他身份的 id 不变
+    bool remove(int id);
+    // 未删除的身份数
+    int size();
+    void clear();
+
+    // 返回最相似的身份
+    face_match_t search(const float * embedding);
+    // 按相似度从高到低返回至多 k 个身份，返回实际数量，margin 为与下一名的分差
+    int search_top_k(const float * embedding, int k, face_match_t * results);
+
+  private:
+    FaceEmbeddingPrecision precision_;
+    size_t row_bytes_;
+    uint8_t * data_{nullptr};
+    std::vector<float> scales_;
+    int size_{0};
+    int capacity_{0};
+    int removed_count_{0};
+    std::vector<uint8_t> is_removed_;
+    std::unique_ptr<FaceHnswIndex> hnsw_;
+    int hnsw_ef_{FACE_HNSW_EF_SEARCH};
+    std::shared_mutex mutex_;
+
+    // 需持有写锁
+    void reserve(int capacity);
+    // 以下需持有读锁
+    face_embedding_matrix_t get_matrix() const;
+    // 按相似度从高到低取至多 keep 个未删除的身份
+    int collect_top(const face_query_t & query, int keep, face_match_t * top);
+};
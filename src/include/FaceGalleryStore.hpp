@@ -0,0 +1,99 @@
+#pragma once
+
+#include "FaceGallery.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 图库文件路径
+#define FACE_GALLERY_PATH_ENV "FACE_GALLERY_PATH"
+#define FACE_GALLERY_DEFAULT_PATH "/home/elf/Desktop/deep_learning_security_system/src/assets/face_gallery.bin"
+#define FACE_GALLERY_FILE_MAGIC "FACEGAL"
+#define FACE_GALLERY_FILE_VERSION 1
+#define FACE_GALLERY_LABEL_SIZE 48
+// 失效记录(被删除的身份和删除记录本身)达到该数量且多于有效身份时，在后台压缩文件
+#define FACE_GALLERY_COMPACT_MIN_DEAD 256
+
+typedef struct {
+    char magic[8]; // FACE_GALLERY_FILE_MAGIC
+    uint32_t version;
+    uint32_t dim;         // FACE_GALLERY_DIM
+    uint32_t record_size; // sizeof(face_gallery_record_t)
+    uint32_t reserved[11];
+} face_gallery_file_header_t;
+
+enum FaceGalleryRecordType : uint32_t {
+    FACE_GALLERY_RECORD_ADD    = 1,
+    FACE_GALLERY_RECORD_REMOVE = 2,
+};
+
+// 定长记录，文件头之后依次追加
+typedef struct {
+    uint32_t crc;  // 除 crc 外整条记录的 CRC32，断电时写了一半的记录校验不通过
+    uint32_t type; // FaceGalleryRecordType
+    int32_t id;    // 持久 id，删除记录为被删除的身份
+    uint32_t reserved;
+    int64_t timestamp; // 录入时间，秒
+    char label[FACE_GALLERY_LABEL_SIZE];
+    float embedding[FACE_GALLERY_DIM]; // 单位向量，删除记录不使用
+} face_gallery_record_t;
+
+/**
+ * @brief 人脸图库持久化
+ *
+ * 文件为文件头加定长记录的追加日志。启动时只读映射整个文件，逐条校验 CRC 后直接加入 FaceGallery，
+ * 不需要解析；末尾校验不通过的记录是写入时断电留下的，截掉后继续追加。
+ * 每次录入追加一条记录并 fdatasync 后才返回，录入成功的人脸重启后一定还在。
+ * 删除也是追加一条删除记录，失效记录过多时在 IO 队列中把有效记录写入临时文件再 rename 替换，不阻塞录入和启动。
+ * FaceGallery 的行号按录入顺序分配，压缩后会变化，持久 id 不变。传入的 gallery 须为空，之后只通过本类修改。
+ */
+class FaceGalleryStore {
+  public:
+    explicit FaceGalleryStore(FaceGallery & gallery, std::string path = path_from_env());
+    ~FaceGalleryStore();
+
+    FaceGalleryStore(const FaceGalleryStore &)             = delete;
+    FaceGalleryStore & operator=(const FaceGalleryStore &) = delete;
+
+    // 加载文件中的身份，文件不存在时创建；失败时图库仍可使用，但录入不会保存
+    bool open();
+    // 加入图库并写入文件，返回持久 id，特征全零时返回 -1。label 为空时使用 face_<id>
+    int enroll(const float * embedding, const char * label = nullptr);
+    bool remove(int id);
+    // gallery 中 row 对应的持久 id 和标签，row 无效时返回 -1 和空串
+    int get_id(int row);
+    std::string get_label(int row);
+
+    // 把有效记录写入新文件并替换原文件，录入可以同时进行
+    bool compact();
+
+    static std::string path_from_env();
+
+  private:
+    FaceGallery & gallery_;
+    std::string path_;
+
+    std::mutex mutex_;
+    int fd_{-1};
+    uint64_t file_size_{0};
+    int next_id_{0};
+    std::vector<int> ids_;              // gallery 行号 -> 持久 id
+    std::vector<std::string> labels_;   // gallery 行号 -> 标签
+    std::unordered_map<int, int> rows_; // 未删除的持久 id -> gallery 行号
+    int dead_records_{0};
+
+    bool is_compacting_{false};
+    std::condition_variable compact_cond_;
+
+    // 调用者已置 is_compacting_，不持有 mutex_
+    bool rewrite();
+
+    // 以下需持有 mutex_
+    int add_to_gallery(const face_gallery_record_t & record);
+    bool append(face_gallery_record_t & record);
+    void compact_if_needed();
+    bool create_file();
+};
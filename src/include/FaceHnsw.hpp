@@ -0,0 +1,70 @@
+#pragma once
+
+#include "FaceEmbedding.hpp"
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+// 每个节点在第 1 层及以上保留的邻居数，第 0 层为两倍
+#define FACE_HNSW_M 16
+// 插入时每层搜索的候选数
+#define FACE_HNSW_EF_CONSTRUCTION 100
+// 查询时第 0 层搜索的候选数，越大召回越高、越慢
+#define FACE_HNSW_EF_SEARCH 64
+
+// (余弦相似度, 节点 id)
+typedef std::pair<float, int> face_hnsw_result_t;
+
+/**
+ * @brief 人脸特征 HNSW 近似最近邻索引
+ *
+ * 不保存特征本身，特征存放在 FaceGallery 的连续矩阵中，每次调用传入矩阵，节点 id 即矩阵行号。
+ * 相似度为单位向量点积，与图库使用相同的存储精度。删除只做标记，被删节点仍参与图的遍历，但不会出现在结果中。
+ * 插入和删除需要外部加写锁，查询可以在多个线程中同时进行。
+ */
+class FaceHnswIndex {
+  public:
+    explicit FaceHnswIndex(int m = FACE_HNSW_M, int ef_construction = FACE_HNSW_EF_CONSTRUCTION);
+
+    // id 必须等于已插入的节点数
+    void insert(const face_embedding_matrix_t & matrix, int id);
+    void remove(int id);
+    void clear();
+
+    // 返回至多 k 个未删除的节点，按相似度从高到低
+    int search(const face_embedding_matrix_t & matrix, const face_query_t & query, int k, int ef,
+               face_hnsw_result_t * results) const;
+
+  private:
+    int m_;
+    int m0_;
+    int ef_construction_;
+    double level_mult_;
+    std::mt19937 rng_;
+
+    int entry_point_{-1};
+    int max_level_{-1};
+    std::vector<int> levels_;
+    std::vector<uint8_t> is_deleted_;
+    // 第 0 层邻居，每个节点 1 + m0_ 个 int: 邻居数 + 邻居
+    std::vector<int> links0_;
+    // 第 1 层及以上的邻居，每层 1 + m_ 个 int
+    std::vector<std::vector<int>> upper_links_;
+
+    int random_level();
+    int * get_links(int id, int level);
+    const int * get_links(int id, int level) const;
+    int max_links(int level) const;
+
+    // 从 entry 开始在 level 层贪心下降到局部最优
+    int greedy_search(const face_embedding_matrix_t & matrix, const face_query_t & query, int entry,
+                      float & entry_score, int level) const;
+    // 返回至多 ef 个候选，按相似度从高到低
+    std::vector<face_hnsw_result_t> search_layer(const face_embedding_matrix_t & matrix, const face_query_t & query,
+                                                 int entry, float entry_score, int ef, int level) const;
+    // 启发式选邻居: 候选比已选邻居更接近基准点才保留，使邻居分布在不同方向
+    std::vector<int> select_neighbors(const face_embedding_matrix_t & matrix,
+                                      const std::vector<face_hnsw_result_t> & candidates, int max_count) const;
+    void connect(const face_embedding_matrix_t & matrix, int id, int neighbor, int level);
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "FrameSource.hpp"
+#include <chrono>
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+
+// 文件回放节奏: realtime(默认，按时间戳) / fast(尽快解码，不丢帧)
+#define FILE_SOURCE_PACING_ENV "FILE_SOURCE_PACING"
+// 设置为 0 时读完文件即结束，默认循环播放
+#define FILE_SOURCE_LOOP_ENV "FILE_SOURCE_LOOP"
+
+/**
+ * @brief 视频文件或网络流帧来源
+ *
+ * 用 libavformat/libavcodec 解码 MP4 等文件或 RTSP 流，转换为 BGR 后像摄像头一样输出帧，
+ * 用于在没有摄像头时复现现场负载和测量流水线的最大吞吐。
+ * realtime 模式按帧时间戳控制输出节奏，帧缓冲策略与摄像头相同；
+ * fast 模式尽快解码，帧缓冲满时等待消费者，不丢帧，此时吞吐由下游决定。
+ * 网络流本身就是实时的，不再额外控制节奏。
+ */
+class FileSource : public FrameSource {
+  public:
+    FileSource(const std::string & path, bool is_realtime, bool is_loop, int stream_id = 0);
+    // 按 FILE_SOURCE_PACING / FILE_SOURCE_LOOP 配置
+    explicit FileSource(const std::string & path, int stream_id = 0);
+    ~FileSource();
+
+    bool is_opened();
+
+  protected:
+    bool read_frame(Frame & frame) override;
+    void open_stream() override;
+
+  private:
+    typedef std::chrono::steady_clock clock;
+
+    std::string path_;
+    bool is_realtime_;
+    bool is_loop_;
+
+    AVFormatContext * format_ctx_ = nullptr;
+    AVCodecContext * codec_ctx_   = nullptr;
+    SwsContext * sws_ctx_         = nullptr;
+    AVPacket * packet_            = nullptr;
+    AVFrame * frame_              = nullptr;
+    int stream_index_             = -1;
+    bool is_draining_             = false; // 已读到文件末尾，正在取出解码器中剩余的帧
+
+    // realtime 模式下第一帧的时间戳和输出时间
+    int64_t first_pts_{AV_NOPTS_VALUE};
+    clock::time_point first_time_;
+
+    int open_input();
+    void close_input();
+    // 解码出下一帧到 frame_，读完且不循环时返回 false
+    bool decode_next();
+    void wait_for_pts(int64_t pts);
+};
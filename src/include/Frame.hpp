@@ -0,0 +1,23 @@
+#pragma once
+
+#include "opencv2/opencv.hpp"
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief 采集到的一帧图像
+ *
+ * sequence 在 Camera 取到图像时按采集顺序分配(从 1 开始)，每路摄像头独立计数，推理结果按该序号恢复顺序。
+ * stream_id 为摄像头编号，单路时为 0。
+ * timestamp_us 为采集时的 steady_clock(CLOCK_MONOTONIC) 时间。
+ * image 可能直接引用驱动缓冲区，此时 dma_fd 为该缓冲区导出的 DMABUF fd，最后一个引用释放时归还驱动。
+ * 因此不能把 *image 浅拷贝成独立的 cv::Mat 交给其他线程: 拷贝不持有引用，缓冲区归还后会被下一帧覆盖。
+ * 需要在 Frame 之外使用时传递 image 本身，或 clone()。
+ */
+struct Frame {
+    std::shared_ptr<cv::Mat> image;
+    uint64_t sequence{0};
+    int stream_id{0};
+    int64_t timestamp_us{0};
+    int dma_fd{-1};
+};
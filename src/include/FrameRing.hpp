@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Frame.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 默认缓存帧数，V4L2 零拷贝时每帧占用一个驱动缓冲区，需要小于 V4L2_CAPTURE_BUFFER_COUNT
+#define FRAME_RING_CAPACITY 3
+
+enum class FrameRingPolicy {
+    BLOCK,       // 满时采集线程等待，不丢帧，消费者慢时会拖慢采集
+    DROP_OLDEST, // 满时覆盖最旧的帧
+    LATEST_ONLY, // 只保留最新一帧
+};
+
+typedef struct {
+    uint64_t captured;  // 写入的帧数
+    uint64_t dropped;   // 被覆盖或清空、没有被取走的帧数
+    uint64_t delivered; // 被取走的帧数
+} frame_ring_stats_t;
+
+/**
+ * @brief 固定容量的帧环形缓冲区
+ *
+ * 采集线程 push，推理线程 pop，二者通过它解耦，消费者变慢不会影响采集节奏。
+ * close 之后 push 直接返回 false，pop 取完剩余帧后返回 false，用于停止时唤醒等待的线程。
+ */
+class FrameRing {
+  public:
+    explicit FrameRing(size_t capacity = FRAME_RING_CAPACITY, FrameRingPolicy policy = FrameRingPolicy::DROP_OLDEST);
+
+    bool push(Frame frame);
+    // 阻塞直到有帧，关闭且为空时返回 false
+    bool pop(Frame & frame);
+    // 不阻塞，没有帧时返回 false
+    bool try_pop(Frame & frame);
+
+    void close();
+    // 丢弃剩余帧并重新打开
+    void reset();
+
+    size_t size();
+    size_t capacity();
+    FrameRingPolicy policy();
+    frame_ring_stats_t stats();
+
+  private:
+    std::vector<Frame> slots_;
+    FrameRingPolicy policy_;
+    size_t head_{0}; // 最旧一帧的位置
+    size_t count_{0};
+    bool is_closed_{false};
+    frame_ring_stats_t stats_{};
+
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+
+    Frame take_oldest_locked();
+};
+
+// 解析策略名称: block / drop_oldest / latest_only，无法识别时返回 false
+bool frame_ring_policy_from_string(const char * name, FrameRingPolicy & policy);
+const char * frame_ring_policy_name(FrameRingPolicy policy);
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Frame.hpp"
+#include "FrameRing.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+// 帧缓冲策略: block / drop_oldest(默认) / latest_only
+#define CAMERA_FRAME_POLICY_ENV "CAMERA_FRAME_POLICY"
+// 帧缓冲容量，默认 FRAME_RING_CAPACITY
+#define CAMERA_FRAME_RING_SIZE_ENV "CAMERA_FRAME_RING_SIZE"
+
+/**
+ * @brief 帧来源
+ *
+ * 采集线程循环调用 read_frame 读取一帧，分配序号后写入 FrameRing，消费者通过 get_frame 取帧。
+ * 摄像头、视频文件等来源只需实现 read_frame，以及需要时在 open_stream/close_stream 中开启和关闭采集。
+ */
+class FrameSource {
+  public:
+    FrameSource(int stream_id, const std::string & name, FrameRingPolicy policy, size_t capacity);
+    virtual ~FrameSource() = default;
+
+    FrameSource(const FrameSource &)             = delete;
+    FrameSource & operator=(const FrameSource &) = delete;
+
+    void start();
+    void stop();
+
+    // 取出一帧，帧序号在采集时分配，多个调用方之间保持采集顺序
+    // 采集线程退出(出错或读完)后返回 image 为空的帧
+    Frame get_frame();
+    // 不阻塞地取出一帧，没有帧时返回 false
+    bool try_get_frame(Frame & frame);
+
+    frame_ring_stats_t get_stats();
+
+    // 每写入一帧以及采集线程退出时在采集线程中调用，需在 start 之前设置
+    void set_frame_callback(std::function<void()> callback);
+
+    int get_stream_id();
+    int get_width();
+    int get_height();
+    const std::string & get_name();
+
+    // 按 CAMERA_FRAME_POLICY / CAMERA_FRAME_RING_SIZE 配置帧缓冲
+    static FrameRingPolicy policy_from_env();
+    static size_t capacity_from_env();
+
+  protected:
+    int stream_id_;
+    std::string name_;
+    int width_{0};
+    int height_{0};
+
+    // 读取一帧，不需要设置序号和 stream_id，返回 false 时采集线程退出
+    virtual bool read_frame(Frame & frame) = 0;
+    // 启动采集线程之前调用
+    virtual void open_stream()
+    {}
+    // 采集线程退出、缓存的帧释放之后调用
+    virtual void close_stream()
+    {}
+
+  private:
+    // 采集线程只管写入，消费者慢时按策略丢帧，不会拖慢采集
+    FrameRing frame_ring_;
+    uint64_t frame_sequence_{0}; // 最近一帧的序号，只在采集线程中修改
+
+    std::atomic_bool is_running_{false};
+    std::thread capture_thread_;
+    std::function<void()> frame_callback_;
+
+    void capture_loop();
+};
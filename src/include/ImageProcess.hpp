@@ -3,13 +3,23 @@
 #include "mutex"
 #include "PostProcess.hpp"
 #include <opencv2/opencv.hpp>
+#include <vector>
 
 class ImageProcess {
 public:
   ImageProcess(int width, int height, int target_size);
+  // 源图尺寸变化时重新计算缩放和查找表，同一对象可以依次处理不同大小的人脸
+  void reset(int width, int height);
   std::unique_ptr<cv::Mat> convert(const cv::Mat &src);
+  // 单次遍历完成缩放、填充和 BGR->RGB，直接写入模型输入内存(RGB888, 每行 dst_stride 字节)
+  int convert(const cv::Mat &src, void *dst, int dst_stride);
   const letterbox_t &get_letter_box();
+  // 水平插值默认在有 NEON 时使用 NEON，关闭后使用标量实现，基准测试用来对比两者
+  static bool is_neon_available();
+  static void set_neon_enabled(bool is_enabled);
   void image_post_process(cv::Mat &image, retinaface_result &results, cv::Scalar &color);
+  // colors[i] 为 results.object[i] 的颜色
+  void image_post_process(cv::Mat &image, retinaface_result &results, const cv::Scalar *colors);
   void image_post_process(cv::Mat &image, yolo_result_list &results, cv::Scalar &color);
 private:
   double scale_;
@@ -18,4 +28,11 @@ private:
   cv::Size new_size_;
   int target_size_;
   letterbox_t letterbox_;
+  int src_width_;
+  int src_height_;
+  // 双线性缩放查找表: 源像素坐标和 8 位定点权重，构造和 reset 时计算
+  std::vector<int> x_ofs_;
+  std::vector<uint16_t> x_alpha_;
+  std::vector<int> y_ofs_;
+  std::vector<uint16_t> y_beta_;
 };
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "rknn_api.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 推理后端选择，通过环境变量 INFERENCE_BACKEND 配置: rknn / replay
+#define INFERENCE_BACKEND_ENV "INFERENCE_BACKEND"
+// 回放数据目录，文件名为 <模型文件名>.replay
+#define INFERENCE_REPLAY_DIR_ENV "INFERENCE_REPLAY_DIR"
+#define INFERENCE_REPLAY_DIR_DEFAULT "./replay"
+// 回放后端每次 run 的模拟耗时(微秒)
+#define INFERENCE_REPLAY_LATENCY_ENV "INFERENCE_REPLAY_LATENCY_US"
+// 设置后 RKNN 后端会把输出张量录制到该目录，供回放后端使用
+#define INFERENCE_RECORD_DIR_ENV "INFERENCE_RECORD_DIR"
+// 每个模型最多录制的帧数
+#define INFERENCE_RECORD_FRAMES_ENV "INFERENCE_RECORD_FRAMES"
+#define INFERENCE_RECORD_FRAMES_DEFAULT 100
+
+#define REPLAY_FILE_MAGIC "RKRP"
+#define REPLAY_FILE_VERSION 1
+
+/**
+ * @brief 推理后端抽象接口
+ *
+ * 接口形式与 rknn_api 保持一致，模型代码只依赖该接口，
+ * 从而可以在没有 RK3588 的 x86 机器上使用回放后端运行整条流水线。
+ */
+class InferenceBackend {
+  public:
+    virtual ~InferenceBackend() = default;
+
+    // 从模型数据创建上下文，model_path 仅用于定位录制/回放文件
+    virtual int init(void * model, uint32_t size, const char * model_path) = 0;
+    // 复制一个已初始化的上下文(共享权重)
+    virtual int dup(InferenceBackend * src) = 0;
+    virtual int destroy() = 0;
+
+    virtual int set_core_mask(rknn_core_mask core_mask) = 0;
+    virtual int query(rknn_query_cmd cmd, void * info, uint32_t size) = 0;
+
+    virtual int inputs_set(uint32_t n_inputs, rknn_input inputs[]) = 0;
+    virtual int run() = 0;
+    // 非阻塞启动推理，之后必须调用 wait 等待完成；默认同步执行
+    virtual int run_async()
+    {
+        return run();
+    }
+    virtual int wait()
+    {
+        return RKNN_SUCC;
+    }
+    virtual int outputs_get(uint32_t n_outputs, rknn_output outputs[]) = 0;
+    virtual int outputs_release(uint32_t n_outputs, rknn_output outputs[]) = 0;
+
+    // 零拷贝输入输出: 创建常驻 tensor 内存并绑定到上下文，run 直接读写该内存
+    virtual rknn_tensor_mem * create_mem(uint32_t size) = 0;
+    virtual int destroy_mem(rknn_tensor_mem * mem) = 0;
+    virtual int set_input_mem(rknn_tensor_mem * mem, rknn_tensor_attr * attr) = 0;
+    virtual int set_output_mem(rknn_tensor_mem * mem, rknn_tensor_attr * attr) = 0;
+    virtual int mem_sync(rknn_tensor_mem * mem, rknn_mem_sync_mode mode) = 0;
+
+    virtual const char * name() = 0;
+    // 是否需要读取模型文件
+    virtual bool require_model_data()
+    {
+        return true;
+    }
+};
+
+/**
+ * @brief 输出张量录制器
+ *
+ * 文件格式: 文件头 + 输入/输出 tensor 属性 + 若干帧，每帧按输出顺序保存
+ * replay_tensor_header_t 和原始数据。同一模型的多个上下文共享一个录制器。
+ */
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    rknn_input_output_num io_num;
+} replay_file_header_t;
+
+typedef struct {
+    uint32_t index;
+    uint32_t is_float;
+    uint32_t size;
+} replay_tensor_header_t;
+
+class ReplayRecorder {
+  public:
+    static std::shared_ptr<ReplayRecorder> open(const char * model_path, InferenceBackend * backend);
+    ~ReplayRecorder();
+    void append(uint32_t n_outputs, rknn_output outputs[]);
+
+  private:
+    FILE * fp_{nullptr};
+    int frames_{0};
+    int max_frames_{INFERENCE_RECORD_FRAMES_DEFAULT};
+    std::mutex mutex_;
+};
+
+#if USE_RKNN_RUNTIME
+// RK3588 NPU 后端，直接转发到 librknnrt
+class RknnBackend : public InferenceBackend {
+  public:
+    ~RknnBackend() override;
+
+    int init(void * model, uint32_t size, const char * model_path) override;
+    int dup(InferenceBackend * src) override;
+    int destroy() override;
+    int set_core_mask(rknn_core_mask core_mask) override;
+    int query(rknn_query_cmd cmd, void * info, uint32_t size) override;
+    int inputs_set(uint32_t n_inputs, rknn_input inputs[]) override;
+    int run() override;
+    int run_async() override;
+    int wait() override;
+    int outputs_get(uint32_t n_outputs, rknn_output outputs[]) override;
+    int outputs_release(uint32_t n_outputs, rknn_output outputs[]) override;
+    rknn_tensor_mem * create_mem(uint32_t size) override;
+    int destroy_mem(rknn_tensor_mem * mem) override;
+    int set_input_mem(rknn_tensor_mem * mem, rknn_tensor_attr * attr) override;
+    int set_output_mem(rknn_tensor_mem * mem, rknn_tensor_attr * attr) override;
+    int mem_sync(rknn_tensor_mem * mem, rknn_mem_sync_mode mode) override;
+    const char * name() override;
+
+  private:
+    rknn_context ctx_{0};
+    std::shared_ptr<ReplayRecorder> recorder_;
+    // 录制时需要在 run 之后读取绑定的输出内存
+    std::vector<rknn_tensor_mem *> output_mems_;
+    std::vector<rknn_tensor_attr> output_mem_attrs_;
+
+    // 推理完成后录制零拷贝输出
+    int record_outputs();
+};
+#endif
+
+struct ReplayTensor {
+    replay_tensor_header_t header;
+    std::vector<uint8_t> data;
+};
+
+// 录制数据，同一模型的多个上下文共享
+struct ReplayData {
+    rknn_input_output_num io_num;
+    std::vector<rknn_tensor_attr> input_attrs;
+    std::vector<rknn_tensor_attr> output_attrs;
+    // frames[帧][输出]
+    std::vector<std::vector<ReplayTensor>> frames;
+};
+
+/**
+ * @brief CPU 回放后端
+ *
+ * 按顺序循环返回录制的输出张量，run 按配置的延迟休眠以模拟 NPU 耗时，
+ * 输出结果与调度顺序无关(每个上下文独立计数)，便于回归测试。
+ */
+class ReplayBackend : public InferenceBackend {
+  public:
+    ReplayBackend();
+
+    int init(void * model, uint32_t size, const char * model_path) override;
+    int dup(InferenceBackend * src) override;
+    int destroy() override;
+    int set_core_mask(rknn_core_mask core_mask) override;
+    int query(rknn_query_cmd cmd, void * info, uint32_t size) override;
+    int inputs_set(uint32_t n_inputs, rknn_input inputs[]) override;
+    int run() override;
+    int run_async() override;
+    int wait() override;
+    int outputs_get(uint32_t n_outputs, rknn_output outputs[]) override;
+    int outputs_release(uint32_t n_outputs, rknn_output outputs[]) override;
+    rknn_tensor_mem * create_mem(uint32_t size) override;
+    int destroy_mem(rknn_tensor_mem * mem) override;
+    int set_input_mem(rknn_tensor_mem * mem, rknn_tensor_attr * attr) override;
+    int set_output_mem(rknn_tensor_mem * mem, rknn_tensor_attr * attr) override;
+    int mem_sync(rknn_tensor_mem * mem, rknn_mem_sync_mode mode) override;
+    const char * name() override;
+    bool require_model_data() override;
+
+  private:
+    std::shared_ptr<ReplayData> data_;
+    size_t frame_index_{0};
+    size_t current_frame_{0};
+    uint32_t latency_us_{0};
+    // run_async 启动的模拟推理在该时间完成
+    std::chrono::steady_clock::time_point run_deadline_;
+    // want_float 与录制格式不一致时的转换缓冲区
+    std::vector<std::vector<uint8_t>> convert_buffers_;
+    // 绑定的输出内存，run 时把当前帧写入
+    std::vector<rknn_tensor_mem *> output_mems_;
+    std::vector<rknn_tensor_attr> output_mem_attrs_;
+
+    // 按 want_float 取出当前帧的输出张量
+    int get_output_tensor(uint32_t index, bool want_float, void ** buf, uint32_t * size);
+};
+
+// 按环境变量创建推理后端
+std::unique_ptr<InferenceBackend> create_inference_backend();
+
+// 根据模型路径生成录制/回放文件路径
+std::string get_replay_file_path(const char * dir, const char * model_path);
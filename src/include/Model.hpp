@@ -1,72 +1,98 @@
 #pragma once
 
 #include "Common.hpp"
+#include "ImageProcess.hpp"
+#include "InferenceBackend.hpp"
+#include "NpuScheduler.hpp"
+#include "PostProcess.hpp"
 #include "rknn_api.h"
 #include <vector>
 #include <memory>
-#include <mutex>
 
 #define RETINA_FACE_MODEL_PATH "/home/elf/Desktop/deep_learning_security_system/src/assets/model/retina_face.rknn"
 #define FACENET_MODEL_PATH "/home/elf/Desktop/deep_learning_security_system/src/assets/model/facenet.rknn"
 #define YOLO11_MODEL_PATH "/home/elf/Desktop/deep_learning_security_system/src/assets/model/yolo11s.rknn"
 #define YOLO11_LABEL_PATH "/home/elf/Desktop/deep_learning_security_system/src/assets/model/coco_80_labels_list.txt"
 
-#define NPU_CORE_NUM 3
-
-class Facenet {
+// 模型公共部分：上下文初始化、tensor 属性查询和常驻输入输出内存
+// 推理接口不加锁，同一上下文同一时刻只能由持有 NpuLease 的线程使用
+class BaseModel {
   public:
-    Facenet();
-    ~Facenet();
-    int inference(void * image_buf, std::vector<float> & out_fp32, letterbox_t letter_box);
-    rknn_context * get_rknn_context();
-    int init(rknn_context * ctx_in, bool is_copy);
+    // want_float 为 true 时输出内存为 float32，否则保持模型原生输出类型
+    BaseModel(const char * model_path, std::unique_ptr<InferenceBackend> backend, bool want_float);
+    virtual ~BaseModel();
+    InferenceBackend * get_backend();
+    const char * get_model_path();
+    // init 时由 NpuScheduler 分配
+    rknn_core_mask get_core_mask();
+    int init(InferenceBackend * backend_in, bool is_copy);
     int deinit();
+    // 用全零输入推理一次，把首次推理的初始化开销提前到启动阶段
+    int warm_up();
     int get_model_width();  // 获取模型宽度
     int get_model_height(); // 获取模型高度
 
-  private:
+    // 分两步推理: submit 预处理写入输入内存后非阻塞启动推理并立即返回，调用者可以在 NPU 运行期间
+    // 做不依赖输出的 CPU 工作；wait_outputs 等待推理完成并同步输出内存，两步之间需持有同一个 NpuLease
+    int submit(const cv::Mat & image, ImageProcess & image_process);
+    int wait_outputs();
+
+  protected:
+    const char * model_path_;
+    std::unique_ptr<InferenceBackend> backend_;
     rknn_app_context_t app_ctx_;
-    rknn_context ctx_{0};
-    std::unique_ptr<rknn_input[]> inputs_;
+    bool want_float_;
+    rknn_core_mask core_mask_{RKNN_NPU_CORE_AUTO};
+    // 每个上下文独占的输入输出内存，预处理直接写入 input_mem_
+    rknn_tensor_mem * input_mem_{nullptr};
+    int input_stride_{0}; // 输入内存每行字节数
+    std::vector<rknn_tensor_mem *> output_mems_;
+    // 指向 output_mems_ 的输出描述，供后处理使用
     std::unique_ptr<rknn_output[]> outputs_;
-    std::mutex outputs_lock_;
+    int64_t run_start_ns_{0};
+
+    int init_io_mem();
+    void release_io_mem();
+    // 模型初始化完成后分配后处理需要的资源
+    virtual int init_post_process()
+    {
+        return 0;
+    }
+    // 预处理写入输入内存、推理并同步输出内存，结果在 outputs_ 中
+    int run_inference(const cv::Mat & image, ImageProcess & image_process);
 };
 
-class Retinaface {
+class Facenet : public BaseModel {
   public:
-    Retinaface();
-    ~Retinaface();
-    int inference(void * image_buf, retinaface_result * results, letterbox_t letter_box);
-    rknn_context * get_rknn_context();
-    int init(rknn_context * ctx_in, bool is_copy);
-    int deinit();
-    int get_model_width();  // 获取模型宽度
-    int get_model_height(); // 获取模型高度
+    explicit Facenet(std::unique_ptr<InferenceBackend> backend);
+    int inference(const cv::Mat & image, ImageProcess & image_process, std::vector<float> & out_fp32);
+    // submit 之后调用，等待推理完成并输出归一化后的特征
+    int get_result(std::vector<float> & out_fp32);
+};
+
+class Retinaface : public BaseModel {
+  public:
+    explicit Retinaface(std::unique_ptr<InferenceBackend> backend);
+    int inference(const cv::Mat & image, ImageProcess & image_process, retinaface_result * results);
+
+  protected:
+    int init_post_process() override;
 
   private:
-    rknn_app_context_t app_ctx_;
-    rknn_context ctx_{0};
-    std::unique_ptr<rknn_input[]> inputs_;
-    std::unique_ptr<rknn_output[]> outputs_;
-    std::mutex outputs_lock_;
+    retinaface_decoder_t decoder_;
 };
 
-class Yolo11 {
+class Yolo11 : public BaseModel {
  public:
-  Yolo11();
-  ~Yolo11();
-  int inference(void *image_buf, yolo_result_list *results,
-                letterbox_t letter_box);
-  rknn_context *get_rknn_context();
-  int init(rknn_context *ctx_in, bool is_copy);
-  int deinit();
-  int get_model_width(); // 获取模型宽度
-  int get_model_height(); // 获取模型高度
+  explicit Yolo11(std::unique_ptr<InferenceBackend> backend);
+  int inference(const cv::Mat &image, ImageProcess &image_process,
+                yolo_result_list *results);
+  // submit 之后调用，等待推理完成并后处理
+  int get_result(ImageProcess &image_process, yolo_result_list *results);
+
+protected:
+  int init_post_process() override;
 
- private:
-  rknn_app_context_t app_ctx_;
-  rknn_context ctx_{0};
-  std::unique_ptr<rknn_input[]> inputs_;
-  std::unique_ptr<rknn_output[]> outputs_;
-  std::mutex outputs_lock_;
-};
\ No newline at end of file
+private:
+  yolo_workspace_t workspace_;
+};
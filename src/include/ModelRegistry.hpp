@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// 只读映射的模型文件
+typedef struct {
+    void * data;
+    size_t size;
+} model_file_t;
+
+/**
+ * @brief 模型文件注册表
+ *
+ * 每个模型文件只 mmap 一次，映射在最后一个使用者释放时解除。
+ * 同一文件被多次加载(多个线程池、页面重新激活)时复用已有映射，不再重复读取文件。
+ * 同一模型的其他上下文通过 rknn_dup_context 复制，不需要模型数据。
+ */
+class ModelRegistry {
+  public:
+    static ModelRegistry & instance();
+
+    // 映射失败返回 nullptr
+    std::shared_ptr<const model_file_t> acquire(const char * path);
+
+  private:
+    ModelRegistry() = default;
+
+    ModelRegistry(const ModelRegistry &)             = delete;
+    ModelRegistry & operator=(const ModelRegistry &) = delete;
+
+    std::mutex mutex_;
+    std::map<std::string, std::weak_ptr<const model_file_t>> files_;
+};
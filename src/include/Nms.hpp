@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+typedef struct {
+    float x1;
+    float y1;
+    float x2;
+    float y2;
+    float score;
+    int class_id; // 只在同类别之间抑制
+    int index;    // 调用方的候选框下标
+} nms_candidate_t;
+
+/**
+ * @brief 非极大值抑制，YOLO 和 RetinaFace 后处理共用
+ *
+ * 候选框按分数稳定排序后依次与已保留的同类别框比较，保留 top_k 个后提前结束。
+ * 候选框较多时把已保留的框放入均匀网格，只与覆盖区域相同的框计算 IoU。
+ * IoU 按像素计算(宽高 +1)，与原来的实现保持一致。
+ * 内部缓冲区在多帧之间复用，每个模型上下文持有一个实例，不能多线程共用。
+ */
+class Nms {
+  public:
+    explicit Nms(int capacity = 0);
+
+    void clear();
+    void push(const nms_candidate_t & candidate);
+    int size() const;
+
+    // 返回保留的数量，keep 中按分数从高到低存放保留框的 index
+    int run(float iou_threshold, int top_k, int * keep);
+
+    // 网格边长，0 表示按候选框平均尺寸自动计算
+    void set_grid_cell_size(float cell_size);
+    // 候选框数量达到该值才使用网格，0 表示总是使用，-1 表示不使用
+    void set_grid_min_count(int min_count);
+
+  private:
+    std::vector<nms_candidate_t> candidates_;
+    std::vector<int> order_;
+    std::vector<int> kept_;
+    float grid_cell_size_{0};
+    int grid_min_count_;
+
+    // 网格: 每个格子一个链表，保存覆盖该格子的已保留框
+    float grid_x0_;
+    float grid_y0_;
+    float grid_cell_;
+    int grid_w_;
+    int grid_h_;
+    std::vector<int> cell_heads_;
+    std::vector<int> entry_next_;
+    std::vector<int> entry_kept_;
+
+    bool is_suppressed(const nms_candidate_t & candidate, float iou_threshold);
+    bool is_suppressed_grid(const nms_candidate_t & candidate, float iou_threshold);
+    void init_grid();
+    void insert_grid(int kept_index);
+};
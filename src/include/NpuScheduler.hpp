@@ -0,0 +1,150 @@
+#pragma once
+
+#include "rknn_api.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define NPU_CORE_NUM 3
+// 使用三核合并模式(RKNN_NPU_CORE_0_1_2)的模型文件名，逗号分隔，如 yolo11s.rknn
+#define NPU_MULTI_CORE_MODELS_ENV "NPU_MULTI_CORE_MODELS"
+// 每隔多少毫秒打印一次各核心利用率，不设置时不打印
+#define NPU_REPORT_INTERVAL_ENV "NPU_REPORT_INTERVAL_MS"
+// 空闲列表为空时先自旋重试的次数，之后阻塞等待归还
+#define NPU_LEASE_SPIN_COUNT 64
+
+typedef struct {
+    int contexts;       // 绑定到该核心的上下文数，三核模式的上下文在每个核心都计入
+    int tasks;          // 已分配到该核心、还没完成的任务数
+    uint64_t runs;      // 统计周期内的推理次数
+    double utilization; // 统计周期内核心上有推理在运行的时间占比
+} npu_core_stats_t;
+
+/**
+ * @brief NPU 核心调度
+ *
+ * 上下文初始化时由 assign_core 选择核心，推理时由 NpuContextGroup 选择所在核心任务最少的空闲上下文，
+ * 所有推理池共享同一份核心负载，YOLO 和人脸模型混合运行时不会集中到同一个核心。
+ */
+class NpuScheduler {
+  public:
+    static NpuScheduler & instance();
+
+    NpuScheduler(const NpuScheduler &)             = delete;
+    NpuScheduler & operator=(const NpuScheduler &) = delete;
+
+    // 配置为三核模式的模型返回 RKNN_NPU_CORE_0_1_2，其余绑定到上下文最少的核心
+    rknn_core_mask assign_core(const char * model_path);
+    // 上下文销毁时归还
+    void release_core(rknn_core_mask core_mask);
+
+    // 任务分配到 core_mask 对应的核心，用于选择上下文，不加锁
+    void begin_task(rknn_core_mask core_mask);
+    void end_task(rknn_core_mask core_mask);
+    // core_mask 对应核心上的任务数之和
+    int get_load(rknn_core_mask core_mask);
+
+    // 包住 rknn_run，用于统计利用率
+    void begin_run(rknn_core_mask core_mask);
+    void end_run(rknn_core_mask core_mask);
+
+    // 利用率按上次 reset_window 以来的时间计算
+    void get_stats(npu_core_stats_t stats[NPU_CORE_NUM]);
+    void reset_window();
+    // 打印后开始新的统计周期
+    void print_stats();
+    void report_if_due();
+
+  private:
+    struct Core {
+        int contexts{0};
+        std::atomic<int> tasks{0};
+        int running{0};
+        uint64_t runs{0};         // 统计周期内的推理次数
+        int64_t busy_ns{0};       // 统计周期内的忙碌时间
+        int64_t busy_since_ns{0}; // running 从 0 变为 1 的时间
+    };
+
+    std::mutex mutex_;
+    Core cores_[NPU_CORE_NUM];
+    int64_t window_start_ns_;
+    int64_t last_report_ns_;
+    std::vector<std::string> multi_core_models_;
+
+    NpuScheduler();
+};
+
+/**
+ * @brief 同一模型可互换的一组上下文
+ *
+ * 绑定到同一核心的空闲上下文放在一个无锁空闲栈中，acquire 从负载最小的核心对应的栈中取出上下文，
+ * 取出后由调用者独占，release 时放回，同一上下文不会被两个线程同时使用。
+ * 全部上下文都被占用时先自旋重试，再进入互斥锁等待，取不到空闲上下文时的等待时间记录在 TraceStage::NPU_LEASE_WAIT。
+ */
+class NpuContextGroup {
+  public:
+    explicit NpuContextGroup(std::vector<rknn_core_mask> core_masks);
+
+    int acquire();
+    // 不等待，没有空闲上下文时返回 -1
+    int try_acquire();
+    void release(int context_id);
+
+  private:
+    // 栈顶为 (版本号 << 32) | (上下文序号 + 1)，0 表示空栈，版本号避免 ABA
+    struct FreeList {
+        rknn_core_mask core_mask;
+        std::atomic<uint64_t> head{0};
+    };
+
+    std::vector<rknn_core_mask> core_masks_;
+    std::vector<int> list_ids_;                    // 每个上下文所在的空闲栈
+    std::unique_ptr<std::atomic<uint32_t>[]> next_; // 栈中下一个上下文的序号 + 1
+    std::unique_ptr<FreeList[]> free_lists_;
+    int free_list_count_{0};
+
+    std::atomic<int> waiters_{0};
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cond_;
+
+    int try_pop();
+    int pop(FreeList & free_list);
+    void push(int context_id);
+};
+
+// 作用域内独占 NpuContextGroup 中的一个上下文
+class NpuLease {
+  public:
+    explicit NpuLease(NpuContextGroup & group) : group_(group), context_id_(group.acquire())
+    {}
+    // 只取空闲的上下文，取不到时 owns_context() 为 false。已持有上下文的线程再取一个时使用，
+    // 阻塞等待可能与同样持有上下文的其他线程互相等待
+    NpuLease(NpuContextGroup & group, std::try_to_lock_t) : group_(group), context_id_(group.try_acquire())
+    {}
+    ~NpuLease()
+    {
+        if(context_id_ >= 0) {
+            group_.release(context_id_);
+        }
+    }
+
+    NpuLease(const NpuLease &)             = delete;
+    NpuLease & operator=(const NpuLease &) = delete;
+
+    int context_id() const
+    {
+        return context_id_;
+    }
+    bool owns_context() const
+    {
+        return context_id_ >= 0;
+    }
+
+  private:
+    NpuContextGroup & group_;
+    int context_id_;
+};
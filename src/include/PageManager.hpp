@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Camera.hpp"
+#include "CameraManager.hpp"
 #include "FFmpeg.hpp"
 #include "RknnPool.hpp"
 #include "ImageProcess.hpp"
@@ -28,8 +29,8 @@ class PageManager {
     }
 
     // 初始化所有页面
-    void init(Camera & camera, FaceRknnPool & face_rknn_pool, ImageProcess & image_process);
-    void init(Camera & camera, SecurityRknnPool & security_rknn_pool, ImageProcess & image_process, FFmpeg & ffmpeg);
+    void init(FrameSource & camera, FaceRknnPool & face_rknn_pool);
+    void init(CameraManager & camera_manager, SecurityRknnPool & security_rknn_pool, FFmpeg & ffmpeg);
 
     // 切换到指定页面
     void switchToPage(PageType pageType);
@@ -1,12 +1,39 @@
 #pragma once
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 #include "Common.hpp"
+#include "Nms.hpp"
 #include "rknn_api.h"
 
+// 由 BOX_PRIORS_320/640 预先计算的先验框常量
+typedef struct {
+  float cx;
+  float cy;
+  float w;
+  float h;
+  float var_w; // w * VARIANCES[0]
+  float var_h; // h * VARIANCES[0]
+} retinaface_prior_t;
+
+/**
+ * @brief RetinaFace 解码器
+ *
+ * 每个模型上下文一份，先验框常量和筛选缓冲区在初始化时分配，每帧只解码通过阈值的先验框。
+ */
+typedef struct {
+  int num_priors;
+  std::vector<retinaface_prior_t> priors;
+  std::vector<int> indices; // 通过阈值的先验框下标
+  Nms nms;
+} retinaface_decoder_t;
+
+int init_retinaface_decoder(rknn_app_context_t *app_ctx, retinaface_decoder_t *decoder);
+
 int retinaface_post_process(rknn_app_context_t *app_ctx, rknn_output *outputs,
-                 letterbox_t *letter_box, retinaface_result *results);
+                 letterbox_t *letter_box, retinaface_decoder_t *decoder,
+                 retinaface_result *results);
 
 const char *coco_cls_to_name(int cls_id);
 
@@ -14,7 +41,31 @@ int init_yolo_post_process(const char *label_path);
 
 void deinit_yolo_post_process();
 
+/**
+ * @brief YOLO 后处理工作区
+ *
+ * 每个模型上下文一份，候选框直接写入按网格总数预分配的数组，后处理过程中不再分配内存。
+ */
+typedef struct {
+  int capacity; // 所有分支的网格总数，即候选框数量上限
+  int count;
+  std::vector<float> boxes; // x, y, w, h
+  std::vector<float> probs;
+  std::vector<int> class_ids;
+  Nms nms;
+  // int8 DFL softmax 查找表: dfl_lut[d] = exp(-d * dfl_lut_scale)
+  float dfl_lut_scale;
+  float dfl_lut[256];
+} yolo_workspace_t;
+
+int init_yolo_workspace(rknn_app_context_t *app_ctx, yolo_workspace_t *workspace);
+
+// 阈值筛选并解码候选框，结果在 workspace 中，返回候选框数量
+int yolo_generate_candidates(rknn_app_context_t *app_ctx, rknn_output *outputs,
+                             float conf_threshold, yolo_workspace_t *workspace);
+
 int yolo_post_process(rknn_app_context_t *app_ctx, rknn_output *outputs,
                  letterbox_t *letter_box, float conf_threshold,
-                 float nms_threshold, yolo_result_list *results);
+                 float nms_threshold, yolo_workspace_t *workspace,
+                 yolo_result_list *results);
                       
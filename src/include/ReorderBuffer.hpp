@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Frame.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+
+// 缺帧后最多缓存多少个后续结果，超过后放弃等待缺的帧
+#define REORDER_BUFFER_WINDOW 10
+// 缺帧最长等待时间
+#define REORDER_BUFFER_TIMEOUT_MS 100
+
+typedef struct {
+    uint64_t released; // 按顺序输出的帧数
+    uint64_t skipped;  // 没有结果的帧数(丢弃、录入等)
+    uint64_t missing;  // 等待超时或超出窗口而放弃的帧数
+    uint64_t late;     // 放弃之后才到达、被丢弃的结果数
+} reorder_stats_t;
+
+/**
+ * @brief 推理结果重排序缓冲区
+ *
+ * 线程池按完成顺序返回结果，这里按提交顺序重新排列后输出，保证显示和编码的帧序单调。
+ * 提交时调用 submit 登记序号，完成时调用 push，不会产生结果的帧调用 skip。
+ * 队首的帧迟迟没有完成时，等待超过 timeout_ms 或后续结果超过 window 个就放弃该帧，
+ * 之后才到达的结果计为 late 并丢弃。
+ */
+class ReorderBuffer {
+  public:
+    explicit ReorderBuffer(int window = REORDER_BUFFER_WINDOW, int timeout_ms = REORDER_BUFFER_TIMEOUT_MS);
+
+    void submit(uint64_t sequence);
+    void push(Frame frame);
+    void skip(uint64_t sequence);
+
+    // 取出下一帧，is_wait 为 true 时阻塞直到有帧可以输出
+    bool pop(Frame & frame, bool is_wait = false);
+    // 查看下一帧但不取出
+    bool front(Frame & frame);
+    // 丢弃所有结果，尚未完成的帧之后到达时计为 late
+    void clear();
+
+    reorder_stats_t stats();
+
+  private:
+    typedef std::chrono::steady_clock clock;
+
+    struct Pending {
+        uint64_t sequence;
+        clock::time_point submit_time;
+    };
+
+    int window_;
+    std::chrono::milliseconds timeout_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Pending> order_;      // 已提交、还未输出的帧，按提交顺序
+    std::map<uint64_t, Frame> done_; // 已完成但前面还有帧未完成，image 为空表示 skip
+    std::deque<Frame> ready_;        // 可以输出的帧
+    reorder_stats_t stats_{};
+
+    // 记录完成的帧，序号不在 order_ 中(已放弃或已清空)时返回 false
+    bool complete(Frame frame);
+    void release(clock::time_point now);
+};
+
+/**
+ * @brief 随推理任务一起交给线程池的序号凭证
+ *
+ * 线程池按 DROP_OLDEST 丢弃的任务不会执行，凭证随任务析构时跳过该序号，重排序缓冲区不必等到超时才放弃。
+ * 任务开始执行时调用 release，之后由任务自己 push 或 skip。
+ */
+class ReorderTicket {
+  public:
+    ReorderTicket(ReorderBuffer & buffer, uint64_t sequence) : buffer_(&buffer), sequence_(sequence)
+    {}
+    ReorderTicket(ReorderTicket && other) : buffer_(other.buffer_), sequence_(other.sequence_)
+    {
+        other.buffer_ = nullptr;
+    }
+    ~ReorderTicket()
+    {
+        if(buffer_ != nullptr) {
+            buffer_->skip(sequence_);
+        }
+    }
+
+    ReorderTicket(const ReorderTicket &)             = delete;
+    ReorderTicket & operator=(const ReorderTicket &) = delete;
+
+    void release()
+    {
+        buffer_ = nullptr;
+    }
+
+  private:
+    ReorderBuffer * buffer_;
+    uint64_t sequence_;
+};
@@ -1,73 +1,147 @@
 #pragma once
 
+#include "FaceGallery.hpp"
+#include "FaceGalleryStore.hpp"
+#include "Frame.hpp"
 #include "ImageProcess.hpp"
-#include "ThreadPool.hpp"
+#include "ModelRegistry.hpp"
+#include "NpuScheduler.hpp"
+#include "RknnPoolLifecycle.hpp"
+#include "StealingThreadPool.hpp"
 #include "Model.hpp"
+#include "ReorderBuffer.hpp"
 #include <atomic>
 #include <cstdint>
 #include <memory>
 #include <opencv2/opencv.hpp>
 
 #define RKNN_POOL_SIZE 10
+// 等待推理的帧数上限，NPU 处理不过来时丢弃最早的帧，避免延迟无限增长
+#define RKNN_POOL_QUEUE_CAPACITY (RKNN_POOL_SIZE * 2)
+// SecurityRknnPool 同时接入的摄像头路数上限，每路的结果单独排序
+#define RKNN_POOL_MAX_STREAMS 8
+// 参与识别的人脸框最短边(像素)，更小的人脸特征不可靠，只画框不识别
+#define FACE_RECOGNITION_MIN_SIZE 40
+// 每帧最多识别的人脸数，按面积从大到小选取
+#define FACE_RECOGNITION_MAX_FACES 8
+
+// 一张人脸的识别结果
+typedef struct {
+    int index;     // 在 retinaface_result.object 中的序号
+    int id;        // 匹配到的持久 id，未匹配时为 -1
+    float score;   // 与最相似身份的余弦相似度
+    bool is_match; // score 是否超过匹配阈值
+} face_identity_t;
 
 class FaceRknnPool {
   private:
     int thread_num_{RKNN_POOL_SIZE};
-    std::unique_ptr<ThreadPool> thread_pool_;
-    std::queue<std::shared_ptr<cv::Mat>> image_results_;
+    // 线程池析构时会执行完剩余任务，结果缓冲区需要比线程池后析构
+    ReorderBuffer image_results_; // 按采集顺序输出推理结果
+    std::unique_ptr<StealingThreadPool> thread_pool_;
     std::vector<std::shared_ptr<Retinaface>> retinaface_models_;
     std::vector<std::shared_ptr<Facenet>> facenet_models_;
-    std::mutex id_mutex_;
-    std::mutex image_results_mutex_;
-    std::condition_variable image_results_cv_;
+    // 按核心负载分配上下文，随模型一起加载和释放
+    std::unique_ptr<NpuContextGroup> retinaface_group_;
+    std::unique_ptr<NpuContextGroup> facenet_group_;
     int retinaface_model_size_;
     int facenet_model_size_;
-    uint32_t id_{0};
 
     std::atomic_bool is_face_recognition_{false};
 
-    std::vector<std::vector<float>> facenet_feature_vector_;
+    // 已录入的人脸特征，释放模型时保留
+    FaceGallery face_gallery_;
+    // 第一次加载时从文件恢复，之后每次录入追加到文件
+    FaceGalleryStore face_store_{face_gallery_};
+    std::once_flag face_store_once_;
+
+    // 每个 Facenet 上下文一个预处理对象，持有该上下文时使用，按人脸大小 reset，不再每张人脸重新分配
+    std::vector<std::unique_ptr<ImageProcess>> facenet_image_processes_;
 
-    bool face_recognition(int mode_id, cv::Mat & image, retinaface_result & results,
-                          bool is_generate_face_feature = false);
+    // 选出足够大的人脸并裁剪到图像范围内，按面积从大到小排列，返回数量
+    int select_faces(const cv::Mat & image, const retinaface_result & results, int * indices, cv::Rect * rects,
+                     int max_count);
+    // 识别 results 中的所有人脸，结果按面积从大到小写入 identities，返回识别的人脸数
+    int recognize_faces(cv::Mat & image, retinaface_result & results,
+                        face_identity_t identities[FACE_RECOGNITION_MAX_FACES]);
+    // 录入面积最大的人脸
+    bool enroll_face(cv::Mat & image, retinaface_result & results);
 
     uint64_t pre_show_oled_timestamp_{0};
 
+    // 加载时创建、释放时销毁，add_inference_task 和 load/unload 通过 pool_mutex_ 互斥
+    std::mutex pool_mutex_;
+    // 释放后仍保留模型文件映射，重新激活时不再重新映射和预读
+    std::shared_ptr<const model_file_t> retinaface_file_;
+    std::shared_ptr<const model_file_t> facenet_file_;
+    std::unique_ptr<RknnPoolLifecycle> lifecycle_;
+
+    void load();
+    void unload();
+
   public:
     FaceRknnPool();
     ~FaceRknnPool();
-    void add_inference_task(std::shared_ptr<cv::Mat> src, ImageProcess & retinaface_image_process,
+
+    // 页面显示时调用，在后台加载并预热所有上下文，就绪前提交的任务直接丢弃
+    void activate();
+    // 页面隐藏时调用，空闲超过 RKNN_POOL_IDLE_RELEASE_MS 后释放模型和工作线程
+    void release_after_idle();
+    bool is_ready();
+    void wait_ready();
+
+    void add_inference_task(Frame frame, ImageProcess & retinaface_image_process,
                             bool is_generate_face_feature = false);
-    std::shared_ptr<cv::Mat> get_image_result_from_queue();
-    int get_model_id();
+    // 取出下一个结果，保留序号和采集时间
+    bool get_result(Frame & frame, bool is_wait = false);
     int get_retinaface_model_size();
     int get_facenet_model_size();
     int get_facenet_feature_vector_size();
     void clean_image_results();
     void change_face_recognition_status(bool status);
+    reorder_stats_t get_reorder_stats();
 };
 
 class SecurityRknnPool {
   private:
     int thread_num_{1};
-    std::unique_ptr<ThreadPool> thread_pool_;
-    std::queue<std::shared_ptr<cv::Mat>> image_results_;
+    // 线程池析构时会执行完剩余任务，结果缓冲区需要比线程池后析构
+    ReorderBuffer image_results_[RKNN_POOL_MAX_STREAMS]; // 每路按采集顺序输出推理结果
+    std::unique_ptr<StealingThreadPool> thread_pool_;
     std::vector<std::shared_ptr<Yolo11>> models_;
-    std::mutex id_mutex_;
-    std::mutex image_results_mutex_;
-    uint32_t id_{0};
+    std::unique_ptr<NpuContextGroup> group_;
     int yolo_model_size_;
 
-    char time_str_[20];
+    // 叠加时间、推理并绘制检测框
+    void process_frame(cv::Mat & original_img, ImageProcess & image_process);
+    void draw_timestamp(cv::Mat & original_img);
+
+    // 加载时创建、释放时销毁，add_inference_task 和 load/unload 通过 pool_mutex_ 互斥
+    std::mutex pool_mutex_;
+    // 释放后仍保留模型文件映射，重新激活时不再重新映射和预读
+    std::shared_ptr<const model_file_t> yolo_file_;
+    std::unique_ptr<RknnPoolLifecycle> lifecycle_;
+
+    void load();
+    void unload();
 
   public:
     SecurityRknnPool();
     ~SecurityRknnPool();
 
+    // 页面显示时调用，在后台加载并预热所有上下文，就绪前提交的任务直接丢弃
+    void activate();
+    // 页面隐藏时调用，空闲超过 RKNN_POOL_IDLE_RELEASE_MS 后释放模型和工作线程
+    void release_after_idle();
+    bool is_ready();
+    void wait_ready();
+
     std::atomic_bool is_person{false};
 
-    void add_inference_task(std::shared_ptr<cv::Mat> src, ImageProcess & image_process);
-    std::shared_ptr<cv::Mat> get_image_result_from_queue(bool is_pop = false);
-    int get_model_id();
+    // 结果放入 frame.stream_id 对应的队列
+    void add_inference_task(Frame frame, ImageProcess & image_process);
+    // 取出一路的下一个结果，保留序号和采集时间
+    bool get_result(int stream_id, Frame & frame, bool is_wait = false);
+    reorder_stats_t get_reorder_stats(int stream_id = 0);
     int get_yolo_model_size();
 };
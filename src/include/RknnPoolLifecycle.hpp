@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// 页面隐藏后推理池保持加载的时间(毫秒)，超时后释放 NPU 内存和工作线程，小于 0 表示加载后常驻
+#define RKNN_POOL_IDLE_RELEASE_ENV "RKNN_POOL_IDLE_RELEASE_MS"
+#define RKNN_POOL_IDLE_RELEASE_MS 30000
+
+/**
+ * @brief 推理池按页面显示/隐藏加载和释放
+ *
+ * activate 在 IO 队列中调用 load 加载模型，release_after_idle 后空闲超过 RKNN_POOL_IDLE_RELEASE_MS
+ * 由内部线程调用 unload 释放；超时前再次 activate 会取消释放，释放过程中 activate 会在释放完成后重新加载。
+ * load 和 unload 不会并发执行。
+ */
+class RknnPoolLifecycle {
+  public:
+    RknnPoolLifecycle(const char * name, std::function<void()> load, std::function<void()> unload);
+    // 等待正在进行的加载完成，不调用 unload
+    ~RknnPoolLifecycle();
+
+    RknnPoolLifecycle(const RknnPoolLifecycle &)             = delete;
+    RknnPoolLifecycle & operator=(const RknnPoolLifecycle &) = delete;
+
+    void activate();
+    void release_after_idle();
+    bool is_ready();
+    void wait_ready();
+
+    static int idle_release_ms_from_env();
+
+  private:
+    enum class State {
+        RELEASED,
+        LOADING,
+        READY,
+        UNLOADING,
+    };
+
+    const char * name_;
+    std::function<void()> load_;
+    std::function<void()> unload_;
+    int idle_release_ms_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    State state_{State::RELEASED};
+    bool is_active_{false};
+    bool is_release_pending_{false};
+    bool is_stop_{false};
+    bool is_ever_ready_{false};
+    std::chrono::steady_clock::time_point release_deadline_;
+    std::thread release_thread_;
+
+    // 需持有 mutex_
+    void start_load();
+    void load_task();
+    void release_loop();
+};
@@ -2,13 +2,24 @@
 
 // 声明一个静态方法，我可以传入回调函数，当状态变化时触发回调函数
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
+#include <mutex>
+#include <thread>
 
 class SR501 {
   private:
     SR501();
     static std::atomic<bool> is_running;
+    // exit() 时静态对象析构，joinable 的 std::thread 直接析构会 terminate，先停止并回收轮询线程
+    struct ListenThread {
+        std::thread thread;
+        ~ListenThread();
+    };
+    static ListenThread listen_thread;
+    static std::mutex listen_mutex;
+    static std::condition_variable listen_cond;
   public:
     static void listen_state(std::function<void(bool state)> fn);
     static void stop_listen_state();
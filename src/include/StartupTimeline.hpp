@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+/**
+ * @brief 启动时间线
+ *
+ * 记录启动过程中各事件距进程启动的时间，用来确认显示、主页面和各推理池分别在什么时候就绪。
+ * 推理池在对应页面第一次显示时才加载，第一次就绪时记录并打印一次时间线。
+ * 模型加载的详细耗时(每个上下文的 model_init / model_warm_up)记录在耗时追踪中。
+ */
+void startup_mark(const std::string & event);
+// 打印目前为止记录的所有事件
+void startup_report();
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+
+// 设置为 0 关闭耗时追踪，默认开启
+#define TRACE_ENABLE_ENV "TRACE_ENABLE"
+// 设置后定期把 Chrome trace JSON 写入该文件，并打印各阶段耗时统计
+#define TRACE_DUMP_PATH_ENV "TRACE_DUMP_PATH"
+#define TRACE_REPORT_INTERVAL_ENV "TRACE_REPORT_INTERVAL_MS"
+#define TRACE_REPORT_INTERVAL_DEFAULT 10000
+
+// 每个线程保存最近的 span 数量，必须是 2 的幂
+#define TRACE_RING_SIZE 4096
+
+enum class TraceStage {
+    CAMERA_CAPTURE = 0,
+    PREPROCESS,
+    NPU_RUN,
+    NPU_OUTPUT,
+    YOLO_POST_PROCESS,
+    RETINAFACE_POST_PROCESS,
+    IMAGE_POST_PROCESS,
+    ENCODE_SEND_FRAME,
+    ENCODE_WRITE_FRAME,
+    MODEL_INIT,
+    MODEL_WARM_UP,
+    NPU_LEASE_WAIT,
+    COUNT,
+};
+
+typedef struct {
+    const char * name;
+    int count; // 统计窗口内的样本数
+    double avg_us;
+    double p50_us;
+    double p99_us;
+    double max_us;
+} trace_stat_t;
+
+/**
+ * @brief 流水线各阶段耗时追踪
+ *
+ * 每个线程第一次记录时分配一个环形缓冲区，之后只有本线程写入，不加锁。
+ * 读取时按槽位序号校验，跳过正在被覆盖的槽位，因此统计和导出可以在任意线程随时进行。
+ * 各阶段的 p50/p99 基于所有线程环形缓冲区中仍保留的最近样本计算。
+ */
+bool trace_enabled();
+int64_t trace_now_ns();
+void trace_record(TraceStage stage, int64_t start_ns, int64_t end_ns);
+
+void trace_get_stats(trace_stat_t stats[(int)TraceStage::COUNT]);
+void trace_print_stats();
+// 导出为 Chrome trace JSON(chrome://tracing 或 Perfetto 打开)
+int trace_dump_chrome(const char * path);
+
+// 按环境变量配置定期导出，由主循环所在线程周期调用
+void trace_report_if_due();
+
+// 作用域追踪: 构造时记录开始时间，析构时写入 span
+class TraceScope {
+  public:
+    explicit TraceScope(TraceStage stage) : stage_(stage), start_ns_(trace_enabled() ? trace_now_ns() : 0)
+    {}
+    ~TraceScope()
+    {
+        if(start_ns_ != 0) {
+            trace_record(stage_, start_ns_, trace_now_ns());
+        }
+    }
+
+    TraceScope(const TraceScope &)             = delete;
+    TraceScope & operator=(const TraceScope &) = delete;
+
+  private:
+    TraceStage stage_;
+    int64_t start_ns_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(stage) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(stage)
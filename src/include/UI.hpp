@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Camera.hpp"
+#include "CameraManager.hpp"
 #include "FFmpeg.hpp"
 #include "Lvgl.hpp"
 #include "RknnPool.hpp"
@@ -8,9 +9,15 @@
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 
 #define ACCESS_CONTROL_PAGE_DELAY_TIME 7000
 #define SECURITY_CAMERA_PAGE_AUTO_RECORD_DELAY_TIME 2
+// 检测到人员后报警提示的显示时间(毫秒)，期间不重复报警
+#define SECURITY_CAMERA_PAGE_ALERT_DURATION_MS 2000
+// 模型在后台加载时页面处理线程检查是否就绪的间隔
+#define PAGE_MODEL_WAIT_INTERVAL_MS 100
 
 class MainPage : public BasePage {
   private:
@@ -28,9 +35,11 @@ class MainPage : public BasePage {
 // 访问控制页面
 class AccessControlPage : public BasePage {
   private:
-    Camera & camera_;
+    FrameSource & camera_;
     FaceRknnPool & face_rknn_pool_;
-    ImageProcess & image_process_;
+    // 模型就绪后才知道输入尺寸，第一次使用时创建
+    std::unique_ptr<ImageProcess> image_process_;
+    std::once_flag image_process_once_;
     LvTimer * display_timer;
     std::atomic_bool processing_active = false;
     std::mutex capture_frame_mutex_;
@@ -53,9 +62,11 @@ class AccessControlPage : public BasePage {
     void setup_face_counter_display();
     void setup_face_registration_button();
     void initialize_display_timer();
+    // 需在 face_rknn_pool_ 就绪后调用
+    ImageProcess & get_image_process();
 
   public:
-    AccessControlPage(Camera & camera, FaceRknnPool & face_rknn_pool, ImageProcess & image_process);
+    AccessControlPage(FrameSource & camera, FaceRknnPool & face_rknn_pool);
 
     void show() override;
     void hide() override;
@@ -67,8 +78,7 @@ class AccessControlPage : public BasePage {
 // 安防监控页面
 class SecurityCameraPage : public BasePage {
   private:
-    Camera & camera_;
-    ImageProcess & image_process_;
+    CameraManager & camera_manager_;
     SecurityRknnPool & security_rknn_pool_;
     FFmpeg & ffmpeg_;
 
@@ -80,9 +90,13 @@ class SecurityCameraPage : public BasePage {
     std::atomic_bool alert_processing_ = false;
     uint64_t recording_start_timestamp_ = 0;
 
-    std::mutex video_sync_mutex_;
-    std::condition_variable sync_condition_;
-    bool stream_processing_turn_ = false; // true表示轮到流处理线程取帧
+    // 处理线程交给显示定时器的最新一帧，定时器取走后置空
+    std::mutex display_mutex_;
+    std::shared_ptr<cv::Mat> display_image_;
+    // 缩放后的显示图像，只在 LVGL 线程中访问，LVGL 在下次刷新前一直引用这块内存
+    cv::Mat display_mat_;
+    // 处理线程运行期间持有，页面快速隐藏再显示时新线程等上一个线程停止摄像头后再开始
+    std::mutex processing_mutex_;
 
     // 私有方法：创建UI组件和处理逻辑
     void create_navigation_button();
@@ -96,8 +110,7 @@ class SecurityCameraPage : public BasePage {
     void stop_manual_recording();
 
   public:
-    SecurityCameraPage(Camera & camera, ImageProcess & image_process, SecurityRknnPool & security_rknn_pool,
-                       FFmpeg & ffmpeg);
+    SecurityCameraPage(CameraManager & camera_manager, SecurityRknnPool & security_rknn_pool, FFmpeg & ffmpeg);
     void show() override;
     void hide() override;
 };
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Frame.hpp"
+#include <cstdint>
+#include <memory>
+
+// 向驱动申请的缓冲区数量
+#define V4L2_CAPTURE_BUFFER_COUNT 8
+// 驱动中至少保留的缓冲区数，流水线持有的帧过多时改为复制后立即归还，避免采集停顿
+#define V4L2_CAPTURE_MIN_QUEUED 2
+// 等待一帧的超时时间
+#define V4L2_CAPTURE_TIMEOUT_MS 2000
+
+/**
+ * @brief V4L2 采集
+ *
+ * 使用 mmap 缓冲区并通过 VIDIOC_EXPBUF 导出 DMABUF fd。
+ * 驱动输出 BGR24 时，返回的 Frame 直接引用驱动缓冲区，最后一个引用释放时自动 VIDIOC_QBUF 归还；
+ * 输出 NV12/YUYV 时转换为 BGR，转换目标从内部缓冲池复用，不会每帧分配内存。
+ * 帧可能在 V4l2Capture 析构之后才释放，缓冲区由共享状态持有，最后一帧释放时才解除映射。
+ */
+class V4l2Capture {
+  public:
+    V4l2Capture();
+    ~V4l2Capture();
+
+    V4l2Capture(const V4l2Capture &)             = delete;
+    V4l2Capture & operator=(const V4l2Capture &) = delete;
+
+    int open(const char * device, int width, int height, int fps, int buffer_count = V4L2_CAPTURE_BUFFER_COUNT);
+    void close();
+    bool is_opened();
+
+    int start();
+    int stop();
+
+    // 阻塞读取一帧，成功返回 0
+    int read(Frame & frame);
+
+    int get_width();
+    int get_height();
+    // 驱动实际使用的像素格式(V4L2_PIX_FMT_*)
+    uint32_t get_pixel_format();
+    // 是否直接引用驱动缓冲区
+    bool is_zero_copy();
+
+    struct State;
+
+  private:
+    std::shared_ptr<State> state_;
+};
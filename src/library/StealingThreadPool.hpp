@@ -0,0 +1,305 @@
+#ifndef STEALING_THREAD_POOL_H
+#define STEALING_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// 工作线程取不到任务时休眠前的让出次数
+#define STEALING_THREAD_POOL_SPIN 16
+
+enum class TaskPriority {
+    NORMAL,
+    HIGH, // 优先通道，不受容量限制，也不会被丢弃
+};
+
+enum class OverflowPolicy {
+    BLOCK,       // 队列满时阻塞提交线程
+    DROP_OLDEST, // 队列满时丢弃最早提交的普通任务，其 future 得到 broken_promise
+};
+
+/**
+ * @brief 工作窃取线程池
+ *
+ * 每个工作线程一个双端队列，提交时轮流放入各队列，空闲线程从其他队列窃取任务，
+ * 避免所有线程争用同一把锁。高优先级任务放在共享的优先通道中，工作线程总是先检查该通道。
+ * capacity 为 0 表示不限制普通任务数量，否则按 policy 处理溢出。
+ * 接口与 ThreadPool 保持一致，析构时会执行完队列中剩余的任务。
+ */
+class StealingThreadPool {
+  public:
+    explicit StealingThreadPool(size_t threads, size_t capacity = 0,
+                                OverflowPolicy policy = OverflowPolicy::BLOCK);
+    ~StealingThreadPool();
+
+    StealingThreadPool(const StealingThreadPool &)             = delete;
+    StealingThreadPool & operator=(const StealingThreadPool &) = delete;
+
+    template <class F, class... Args>
+    auto enqueue(F && f, Args &&... args) -> std::future<typename std::result_of<F(Args...)>::type>
+    {
+        return enqueue(TaskPriority::NORMAL, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    template <class F, class... Args>
+    auto enqueue(TaskPriority priority, F && f, Args &&... args)
+        -> std::future<typename std::result_of<F(Args...)>::type>
+    {
+        using return_type = typename std::result_of<F(Args...)>::type;
+
+        auto task = std::make_shared<std::packaged_task<return_type()>>(
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+        std::future<return_type> res = task->get_future();
+
+        push(priority, [task]() { (*task)(); });
+        return res;
+    }
+
+    size_t size() const
+    {
+        return workers_.size();
+    }
+    // 等待执行的任务数(包括优先通道)
+    size_t pending() const
+    {
+        int64_t pending = pending_.load();
+        return pending > 0 ? pending : 0;
+    }
+    // 因容量限制被丢弃的任务数
+    size_t dropped() const
+    {
+        return dropped_.load();
+    }
+    // 被其他线程窃取执行的任务数
+    size_t stolen() const
+    {
+        return stolen_.load();
+    }
+
+  private:
+    struct Task {
+        uint64_t sequence;
+        std::function<void()> func;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::atomic<size_t> count{0}; // 不加锁判断队列是否为空
+    };
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    WorkQueue priority_queue_;
+
+    size_t capacity_;
+    OverflowPolicy policy_;
+
+    std::atomic<uint64_t> sequence_{0};
+    std::atomic<size_t> next_queue_{0};
+    std::atomic<int64_t> pending_{0};
+    std::atomic<int64_t> normal_pending_{0}; // 普通任务数，受 capacity 限制
+    std::atomic<size_t> dropped_{0};
+    std::atomic<size_t> stolen_{0};
+
+    // 空闲线程休眠和提交线程等待空位
+    std::mutex sleep_mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable space_cv_;
+    std::atomic<size_t> idle_{0};
+    std::atomic<bool> stop_{false};
+
+    void push(TaskPriority priority, std::function<void()> func);
+    bool drop_oldest();
+    bool pop(size_t index, Task & task);
+    void worker_loop(size_t index);
+};
+
+inline StealingThreadPool::StealingThreadPool(size_t threads, size_t capacity, OverflowPolicy policy)
+    : capacity_(capacity), policy_(policy)
+{
+    if(threads == 0) {
+        throw std::invalid_argument("StealingThreadPool needs at least one thread");
+    }
+
+    for(size_t i = 0; i < threads; i++) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+    for(size_t i = 0; i < threads; i++) {
+        workers_.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+inline StealingThreadPool::~StealingThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    space_cv_.notify_all();
+    for(auto & worker : workers_) {
+        worker.join();
+    }
+}
+
+inline void StealingThreadPool::push(TaskPriority priority, std::function<void()> func)
+{
+    Task task{sequence_++, std::move(func)};
+    bool is_normal  = priority == TaskPriority::NORMAL;
+    bool is_bounded = is_normal && capacity_ > 0;
+
+    if(is_bounded && policy_ == OverflowPolicy::BLOCK) {
+        // 在锁内占用名额，避免多个提交线程同时通过检查
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        space_cv_.wait(lock, [this]() { return stop_ || normal_pending_.load() < (int64_t)capacity_; });
+        normal_pending_++;
+    } else if(is_normal) {
+        // 队列满: 丢弃最早的一个任务再放入新任务
+        if(normal_pending_++ >= (int64_t)capacity_ && is_bounded) {
+            drop_oldest();
+        }
+    }
+    if(stop_) {
+        throw std::runtime_error("enqueue on stopped StealingThreadPool");
+    }
+
+    if(is_normal) {
+        auto & queue = *queues_[next_queue_++ % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+        queue.count++;
+    } else {
+        std::lock_guard<std::mutex> lock(priority_queue_.mutex);
+        priority_queue_.tasks.push_back(std::move(task));
+        priority_queue_.count++;
+    }
+
+    // 入队后再计数，工作线程可能先取走任务使计数暂时为负，不影响休眠判断
+    pending_++;
+
+    // 只有存在休眠线程时才加锁通知，提交路径上没有全局锁。
+    // 工作线程在锁内先增加 idle_ 再检查 pending_，因此不会错过通知
+    if(idle_.load() > 0) {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+        }
+        work_cv_.notify_one();
+    }
+}
+
+inline bool StealingThreadPool::drop_oldest()
+{
+    // 比较各队列队首的序号，找到最早提交的任务
+    for(;;) {
+        WorkQueue * oldest_queue = nullptr;
+        uint64_t oldest_sequence = UINT64_MAX;
+        for(auto & queue : queues_) {
+            if(queue->count.load() == 0) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            if(!queue->tasks.empty() && queue->tasks.front().sequence < oldest_sequence) {
+                oldest_sequence = queue->tasks.front().sequence;
+                oldest_queue    = queue.get();
+            }
+        }
+        if(oldest_queue == nullptr) {
+            return false;
+        }
+
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(oldest_queue->mutex);
+            // 扫描期间队首可能已被取走，重新查找
+            if(oldest_queue->tasks.empty() || oldest_queue->tasks.front().sequence != oldest_sequence) {
+                continue;
+            }
+            task = std::move(oldest_queue->tasks.front());
+            oldest_queue->tasks.pop_front();
+            oldest_queue->count--;
+        }
+        pending_--;
+        normal_pending_--;
+        dropped_++;
+        // task 在这里析构，packaged_task 未执行，future 得到 broken_promise
+        return true;
+    }
+}
+
+inline bool StealingThreadPool::pop(size_t index, Task & task)
+{
+    if(priority_queue_.count.load() > 0) {
+        std::lock_guard<std::mutex> lock(priority_queue_.mutex);
+        if(!priority_queue_.tasks.empty()) {
+            task = std::move(priority_queue_.tasks.front());
+            priority_queue_.tasks.pop_front();
+            priority_queue_.count--;
+            return true;
+        }
+    }
+
+    // 先取自己的队列，再依次从其他队列窃取，都从队首取以保持提交顺序
+    for(size_t i = 0; i < queues_.size(); i++) {
+        auto & queue = *queues_[(index + i) % queues_.size()];
+        if(queue.count.load() == 0) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queue.count--;
+            normal_pending_--;
+            if(i != 0) {
+                stolen_++;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void StealingThreadPool::worker_loop(size_t index)
+{
+    int spin = 0;
+    for(;;) {
+        Task task;
+        if(pop(index, task)) {
+            spin = 0;
+            pending_--;
+            if(capacity_ > 0 && policy_ == OverflowPolicy::BLOCK) {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+                space_cv_.notify_one();
+            }
+            task.func();
+            continue;
+        }
+
+        // 休眠前先让出几次 CPU，连续提交时可以省去一次唤醒
+        if(spin < STEALING_THREAD_POOL_SPIN && !stop_) {
+            spin++;
+            std::this_thread::yield();
+            continue;
+        }
+        spin = 0;
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        idle_++;
+        work_cv_.wait(lock, [this]() { return stop_ || pending_.load() > 0; });
+        idle_--;
+        if(stop_ && pending_.load() <= 0) {
+            return;
+        }
+    }
+}
+
+#endif
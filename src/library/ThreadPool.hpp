@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <queue>
+#include <atomic>
 #include <memory>
 #include <thread>
 #include <mutex>
@@ -18,7 +19,20 @@ public:
     auto enqueue(F&& f, Args&&... args) 
         -> std::future<typename std::result_of<F(Args...)>::type>;
     ~ThreadPool();
+    // number of worker threads owned by this pool
+    size_t size() const { return workers.size(); }
+    // tasks waiting in the queue (not yet picked up by a worker)
+    size_t pending();
+    // worker threads created by all pools since process start
+    static size_t threads_created() { return created_count().load(); }
 private:
+    static std::atomic<size_t> & created_count()
+    {
+        static std::atomic<size_t> count(0);
+        return count;
+    }
+
+
     // need to keep track of threads so we can join them
     std::vector< std::thread > workers;
     // the task queue
@@ -34,6 +48,7 @@ private:
 inline ThreadPool::ThreadPool(size_t threads)
     :   stop(false)
 {
+    created_count() += threads;
     for(size_t i = 0;i<threads;++i)
         workers.emplace_back(
             [this]
@@ -83,6 +98,12 @@ auto ThreadPool::enqueue(F&& f, Args&&... args)
     return res;
 }
 
+inline size_t ThreadPool::pending()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    return tasks.size();
+}
+
 // the destructor joins all threads
 inline ThreadPool::~ThreadPool()
 {
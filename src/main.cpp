@@ -7,10 +7,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "Benchmark.hpp"
 #include "Camera.hpp"
+#include "CameraManager.hpp"
 #include "FFmpeg.hpp"
 #include "Font.hpp"
+#include "NpuScheduler.hpp"
 #include "RknnPool.hpp"
+#include "StartupTimeline.hpp"
+#include "Trace.hpp"
 #include "PageManager.hpp"
 #include "lvgl/lvgl.h"
 #include "lvgl/src/display/lv_display.h"
@@ -21,6 +26,7 @@ uint16_t display_width;
 uint16_t display_height;
 bool is_fullscreen_mode;
 bool is_maximized_mode;
+static const char * benchmark_name = nullptr;
 
 static void setup_application_config(int argc, char ** argv);
 
@@ -113,7 +119,9 @@ void run_main_event_loop(void)
 
     /* 处理LVGL任务循环 */
     while(1) {
-        sleep_time = lv_timer_handler(); /* 返回到下次定时器执行的时间 */
+        sleep_time = lv_timer_handler();          /* 返回到下次定时器执行的时间 */
+        trace_report_if_due();                    /* 按 TRACE_DUMP_PATH 定期导出耗时追踪 */
+        NpuScheduler::instance().report_if_due(); /* 按 NPU_REPORT_INTERVAL_MS 定期打印各核心利用率 */
         usleep(sleep_time * 1000);
     }
 }
@@ -134,7 +142,7 @@ static void setup_application_config(int argc, char ** argv)
     display_height = atoi(getenv("LV_SIM_WINDOW_HEIGHT") ?: "480");
 
     /* 解析命令行选项 */
-    while((option = getopt(argc, argv, "fmw:h:")) != -1) {
+    while((option = getopt(argc, argv, "fmw:h:b:")) != -1) {
         switch(option) {
             case 'f':
                 is_fullscreen_mode = true;
@@ -152,6 +160,7 @@ static void setup_application_config(int argc, char ** argv)
                 break;
             case 'w': display_width = atoi(optarg); break;
             case 'h': display_height = atoi(optarg); break;
+            case 'b': benchmark_name = optarg; break;
             case ':': fprintf(stderr, "选项 -%c 需要参数。\n", optopt); exit(1);
             case '?': fprintf(stderr, "未知选项 -%c。\n", optopt); exit(1);
         }
@@ -163,6 +172,11 @@ int main(int argc, char ** argv)
     // 初始化应用程序配置
     setup_application_config(argc, argv);
 
+    // 运行基准测试后直接退出，不初始化显示和硬件
+    if(benchmark_name != nullptr) {
+        return run_benchmark(benchmark_name);
+    }
+
     lv_init();
 
     // 根据编译配置初始化显示器
@@ -171,26 +185,27 @@ int main(int argc, char ** argv)
 #elif LV_USE_LINUX_DRM
     initialize_drm_display();
 #endif
+    startup_mark("main: display ready");
 
-    // 创建硬件接口实例
-    Camera camera_module;
+    // 创建硬件接口实例，摄像头按 CAMERA_DEVICES 配置打开，第一路同时用于人脸识别
+    CameraManager camera_manager{CameraManager::load_config()};
+    FrameSource & camera_module = camera_manager.get_source(CAMERA_MANAGER_PRIMARY_STREAM);
     FFmpeg stream_encoder;
     FaceRknnPool face_ai_pool;
     SecurityRknnPool security_ai_pool;
-    
-    // 初始化图像处理器
-    ImageProcess face_image_processor{CAMERA_WIDTH, CAMERA_HEIGHT, face_ai_pool.get_retinaface_model_size()};
-    ImageProcess object_image_processor{CAMERA_WIDTH, CAMERA_HEIGHT, security_ai_pool.get_yolo_model_size()};
+    // 两个推理池在对应页面显示时才加载模型，页面隐藏一段时间后释放
 
     // 获取页面管理器单例
     auto & ui_manager = PageManager::getInstance();
 
     // 初始化人脸识别模块
-    ui_manager.init(camera_module, face_ai_pool, face_image_processor);
+    ui_manager.init(camera_module, face_ai_pool);
     // 初始化安防监控模块
-    ui_manager.init(camera_module, security_ai_pool, object_image_processor, stream_encoder);
+    ui_manager.init(camera_manager, security_ai_pool, stream_encoder);
 
     ui_manager.switchToPage(PageManager::PageType::MAIN_PAGE);
+    startup_mark("main: main page shown");
+    startup_report();
 
     run_main_event_loop();
 
@@ -0,0 +1,96 @@
+#include "Benchmark.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+typedef struct {
+    const char * name;
+    const char * description;
+    int (*func)();
+} benchmark_case_t;
+
+static const benchmark_case_t benchmark_cases[] = {
+    {"preprocess", "letterbox + BGR->RGB: OpenCV vs fused kernel", benchmark_preprocess},
+    {"yolo", "YOLO11 int8 candidate scan and DFL decode", benchmark_yolo_postprocess},
+    {"nms", "NMS on synthetic dense detections: O(n^2) vs sorted/grid", benchmark_nms},
+    {"executor", "task dispatch latency: std::thread/std::async vs executor", benchmark_executor},
+    {"threadpool", "multi-producer contention: ThreadPool vs StealingThreadPool", benchmark_thread_pool},
+    {"trace", "TRACE_SCOPE overhead with a concurrent stats reader", benchmark_trace},
+    {"framering", "camera frame ring policies with a slow consumer", benchmark_frame_ring},
+    {"gallery", "5000-identity face search: euclidean scan vs contiguous cosine gallery", benchmark_face_gallery},
+    {"ann", "face search on 10k-1M identities: exact scan vs HNSW recall and latency", benchmark_face_gallery_ann},
+    {"precision", "50k-identity face search with fp32/fp16/int8 storage vs fp32", benchmark_face_gallery_precision},
+    {"store", "50k-identity gallery file: enroll, reopen, torn-write recovery, compact", benchmark_face_gallery_store},
+    {"npu", "mixed YOLO/face load: round-robin vs least-loaded NPU core dispatch", benchmark_npu_scheduler},
+    {"pipeline", "SecurityRknnPool / FaceRknnPool max FPS on $BENCHMARK_VIDEO", benchmark_pipeline},
+};
+
+benchmark_stat_t benchmark_measure(const std::function<void()> & func, int iterations, int warmup)
+{
+    for(int i = 0; i < warmup; i++) {
+        func();
+    }
+
+    std::vector<double> times(iterations);
+    for(int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        auto end = std::chrono::steady_clock::now();
+        times[i] = std::chrono::duration<double, std::micro>(end - start).count();
+    }
+
+    benchmark_stat_t stat;
+    memset(&stat, 0, sizeof(stat));
+    stat.iterations = iterations;
+    if(iterations == 0) {
+        return stat;
+    }
+
+    double sum = 0;
+    for(double t : times) {
+        sum += t;
+    }
+    std::sort(times.begin(), times.end());
+
+    stat.avg_us = sum / iterations;
+    stat.min_us = times[0];
+    stat.p50_us = times[iterations / 2];
+    stat.p99_us = times[std::min(iterations - 1, iterations * 99 / 100)];
+    return stat;
+}
+
+void benchmark_print(const char * label, const benchmark_stat_t & stat)
+{
+    printf("  %-32s n=%-6d avg=%9.1fus min=%9.1fus p50=%9.1fus p99=%9.1fus\n", label, stat.iterations, stat.avg_us,
+           stat.min_us, stat.p50_us, stat.p99_us);
+}
+
+int run_benchmark(const char * name)
+{
+    bool is_all = strcmp(name, "all") == 0;
+
+    if(strcmp(name, "list") == 0) {
+        for(auto & benchmark_case : benchmark_cases) {
+            printf("%-16s %s\n", benchmark_case.name, benchmark_case.description);
+        }
+        return 0;
+    }
+
+    int ret     = 0;
+    bool is_run = false;
+    for(auto & benchmark_case : benchmark_cases) {
+        if(is_all || strcmp(name, benchmark_case.name) == 0) {
+            printf("[%s] %s\n", benchmark_case.name, benchmark_case.description);
+            ret |= benchmark_case.func();
+            is_run = true;
+        }
+    }
+
+    if(!is_run) {
+        fprintf(stderr, "未知的基准测试: %s，使用 -b list 查看\n", name);
+        return 1;
+    }
+    return ret;
+}
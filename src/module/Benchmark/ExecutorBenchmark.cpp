@@ -0,0 +1,64 @@
+#include "Benchmark.hpp"
+#include "Executor.hpp"
+#include <condition_variable>
+#include <cstdio>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#define EXECUTOR_BENCHMARK_ITERATIONS 2000
+
+// 提交一个空任务并等待它开始执行，测量的是调度延迟
+int benchmark_executor()
+{
+    auto & executor = Executor::instance();
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool is_done = false;
+
+    auto wait_done = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return is_done; });
+        is_done = false;
+    };
+    auto notify_done = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_done = true;
+        cv.notify_one();
+    };
+
+    size_t threads_before = ThreadPool::threads_created();
+
+    auto thread_stat = benchmark_measure(
+        [&]() {
+            std::thread(notify_done).detach();
+            wait_done();
+        },
+        EXECUTOR_BENCHMARK_ITERATIONS);
+    auto async_stat = benchmark_measure(
+        [&]() {
+            [[maybe_unused]] auto future = std::async(std::launch::async, notify_done);
+            wait_done();
+        },
+        EXECUTOR_BENCHMARK_ITERATIONS);
+    auto executor_stat = benchmark_measure(
+        [&]() {
+            executor.post(ExecutorQueue::UI, notify_done);
+            wait_done();
+        },
+        EXECUTOR_BENCHMARK_ITERATIONS);
+
+    benchmark_print("std::thread + detach", thread_stat);
+    benchmark_print("std::async", async_stat);
+    benchmark_print("executor ui queue", executor_stat);
+    printf("  speedup %.2fx / %.2fx\n", thread_stat.avg_us / executor_stat.avg_us,
+           async_stat.avg_us / executor_stat.avg_us);
+
+    executor.print_metrics();
+
+    // 常驻执行器只在第一次使用时创建线程
+    size_t threads_created = ThreadPool::threads_created() - threads_before;
+    size_t threads_expected = EXECUTOR_IO_THREADS + EXECUTOR_UI_THREADS + EXECUTOR_NPU_THREADS;
+    return threads_created <= threads_expected ? 0 : 1;
+}
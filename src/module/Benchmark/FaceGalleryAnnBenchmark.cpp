@@ -0,0 +1,124 @@
+#include "Benchmark.hpp"
+#include "FaceGallery.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 测试的图库规模，逗号分隔，如 10000,100000,1000000
+#define FACE_GALLERY_BENCHMARK_SIZES_ENV "BENCHMARK_GALLERY_SIZES"
+#define FACE_GALLERY_BENCHMARK_DEFAULT_SIZES "10000,100000"
+#define FACE_GALLERY_BENCHMARK_QUERIES 500
+// 查询特征为已录入特征加上每维该标准差的噪声，与原特征的余弦相似度约 0.85，接近同一人不同照片
+#define FACE_GALLERY_BENCHMARK_NOISE 0.05f
+// 增量删除的比例
+#define FACE_GALLERY_BENCHMARK_REMOVE_STEP 10
+
+static std::vector<int> sizes_from_env()
+{
+    const char * env = getenv(FACE_GALLERY_BENCHMARK_SIZES_ENV);
+    std::stringstream sizes(env ? env : FACE_GALLERY_BENCHMARK_DEFAULT_SIZES);
+    std::vector<int> result;
+    std::string size;
+    while(std::getline(sizes, size, ',')) {
+        if(atoi(size.c_str()) > 0) {
+            result.push_back(atoi(size.c_str()));
+        }
+    }
+    return result;
+}
+
+static double elapsed_s(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// HNSW 的 top-1 与逐行扫描一致的比例
+static double recall_at_1(FaceGallery & exact, FaceGallery & hnsw, const std::vector<std::vector<float>> & queries)
+{
+    int hits = 0;
+    for(auto & query : queries) {
+        hits += exact.search(query.data()).id == hnsw.search(query.data()).id;
+    }
+    return (double)hits / queries.size();
+}
+
+static void run_size(int size)
+{
+    std::mt19937 rng(size);
+    std::normal_distribution<float> dist(0, 1);
+
+    FaceGallery exact(FaceGalleryIndex::EXACT);
+    FaceGallery hnsw(FaceGalleryIndex::HNSW);
+
+    std::vector<float> embeddings((size_t)size * FACE_GALLERY_DIM);
+    for(auto & value : embeddings) {
+        value = dist(rng);
+    }
+    for(int i = 0; i < size; i++) {
+        face_embedding_normalize(&embeddings[(size_t)i * FACE_GALLERY_DIM], &embeddings[(size_t)i * FACE_GALLERY_DIM]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < size; i++) {
+        exact.add(&embeddings[(size_t)i * FACE_GALLERY_DIM]);
+    }
+    double exact_build_s = elapsed_s(start);
+
+    start = std::chrono::steady_clock::now();
+    for(int i = 0; i < size; i++) {
+        hnsw.add(&embeddings[(size_t)i * FACE_GALLERY_DIM]);
+    }
+    double hnsw_build_s = elapsed_s(start);
+
+    std::uniform_int_distribution<int> pick(0, size - 1);
+    std::vector<std::vector<float>> queries(FACE_GALLERY_BENCHMARK_QUERIES);
+    std::vector<std::vector<float>> kept_queries; // 原身份不会被删除的查询
+    for(auto & query : queries) {
+        int id               = pick(rng);
+        const float * source = &embeddings[(size_t)id * FACE_GALLERY_DIM];
+        query.resize(FACE_GALLERY_DIM);
+        for(int i = 0; i < FACE_GALLERY_DIM; i++) {
+            query[i] = source[i] + dist(rng) * FACE_GALLERY_BENCHMARK_NOISE;
+        }
+        if(id % FACE_GALLERY_BENCHMARK_REMOVE_STEP != 0) {
+            kept_queries.push_back(query);
+        }
+    }
+
+    printf("  identities=%d build exact=%.2fs hnsw=%.2fs recall@1=%.3f\n", size, exact_build_s, hnsw_build_s,
+           recall_at_1(exact, hnsw, queries));
+
+    volatile int sink = 0;
+    size_t next       = 0;
+    auto exact_stat   = benchmark_measure([&]() { sink = exact.search(queries[next++ % queries.size()].data()).id; },
+                                          FACE_GALLERY_BENCHMARK_QUERIES);
+    next              = 0;
+    auto hnsw_stat    = benchmark_measure([&]() { sink = hnsw.search(queries[next++ % queries.size()].data()).id; },
+                                          FACE_GALLERY_BENCHMARK_QUERIES);
+    benchmark_print("exact scan top-1", exact_stat);
+    benchmark_print("hnsw top-1", hnsw_stat);
+
+    // 删除一部分身份后，被删除的 id 不应再返回，原身份还在的查询召回率不应明显下降
+    for(int i = 0; i < size; i += FACE_GALLERY_BENCHMARK_REMOVE_STEP) {
+        exact.remove(i);
+        hnsw.remove(i);
+    }
+    int removed_hits = 0;
+    for(auto & query : queries) {
+        removed_hits += hnsw.search(query.data()).id % FACE_GALLERY_BENCHMARK_REMOVE_STEP == 0;
+    }
+    printf("  after removing 1/%d: recall@1=%.3f removed ids returned=%d\n", FACE_GALLERY_BENCHMARK_REMOVE_STEP,
+           recall_at_1(exact, hnsw, kept_queries), removed_hits);
+}
+
+int benchmark_face_gallery_ann()
+{
+    for(int size : sizes_from_env()) {
+        run_size(size);
+    }
+    return 0;
+}
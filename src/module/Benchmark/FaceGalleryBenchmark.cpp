@@ -0,0 +1,73 @@
+#include "Benchmark.hpp"
+#include "FaceGallery.hpp"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// 按 5000 人的站点规模测试
+#define FACE_GALLERY_BENCHMARK_IDENTITIES 5000
+#define FACE_GALLERY_BENCHMARK_ITERATIONS 200
+#define FACE_GALLERY_BENCHMARK_TOP_K 5
+
+// 原来的做法: 逐个复制特征计算欧氏距离，找到第一个低于 0.6 的就返回
+static bool legacy_search(std::vector<std::vector<float>> & features, std::vector<float> & query)
+{
+    for(auto out : features) {
+        float sum = 0;
+        for(int i = 0; i < FACE_GALLERY_DIM; i++) {
+            sum += (out[i] - query[i]) * (out[i] - query[i]);
+        }
+        if(std::sqrt(sum) < 0.6) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 随机单位向量互相之间几乎正交，查询不会提前命中，两种做法都要扫描整个图库
+int benchmark_face_gallery()
+{
+    std::mt19937 rng(1);
+    std::normal_distribution<float> dist(0, 1);
+    auto random_embedding = [&]() {
+        std::vector<float> embedding(FACE_GALLERY_DIM);
+        for(auto & value : embedding) {
+            value = dist(rng);
+        }
+        face_embedding_normalize(embedding.data(), embedding.data());
+        return embedding;
+    };
+
+    FaceGallery gallery;
+    std::vector<std::vector<float>> features;
+    for(int i = 0; i < FACE_GALLERY_BENCHMARK_IDENTITIES; i++) {
+        auto embedding = random_embedding();
+        gallery.add(embedding.data());
+        features.push_back(std::move(embedding));
+    }
+    auto query = random_embedding();
+
+    volatile bool sink = false;
+    auto legacy_stat   = benchmark_measure([&]() { sink = legacy_search(features, query); },
+                                           FACE_GALLERY_BENCHMARK_ITERATIONS);
+    auto gallery_stat  = benchmark_measure([&]() { sink = gallery.search(query.data()).is_match; },
+                                           FACE_GALLERY_BENCHMARK_ITERATIONS);
+    face_match_t top[FACE_GALLERY_BENCHMARK_TOP_K];
+    auto top_k_stat = benchmark_measure(
+        [&]() { sink = gallery.search_top_k(query.data(), FACE_GALLERY_BENCHMARK_TOP_K, top) > 0; },
+        FACE_GALLERY_BENCHMARK_ITERATIONS);
+
+    benchmark_print("vector<vector> euclidean scan", legacy_stat);
+    benchmark_print("gallery top-1 cosine", gallery_stat);
+    benchmark_print("gallery top-5 cosine", top_k_stat);
+
+    // 带噪声的已录入特征应当命中原身份
+    auto probe = features[FACE_GALLERY_BENCHMARK_IDENTITIES / 2];
+    for(auto & value : probe) {
+        value += dist(rng) * 0.02f;
+    }
+    auto match = gallery.search(probe.data());
+    printf("  probe id=%d score=%.3f margin=%.3f match=%d\n", match.id, match.score, match.margin, match.is_match);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "Benchmark.hpp"
+#include "FaceGallery.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#define FACE_GALLERY_PRECISION_BENCHMARK_IDENTITIES 50000
+#define FACE_GALLERY_PRECISION_BENCHMARK_QUERIES 500
+// 同一人的查询与原特征的余弦相似度约 0.85，落在匹配阈值附近，最容易因为精度损失改变判定
+#define FACE_GALLERY_PRECISION_BENCHMARK_NOISE 0.05f
+
+// 以 fp32 为基准，比较 fp16/int8 存储的内存、检索耗时和结果差异
+int benchmark_face_gallery_precision()
+{
+    std::mt19937 rng(1);
+    std::normal_distribution<float> dist(0, 1);
+    auto random_embedding = [&]() {
+        std::vector<float> embedding(FACE_GALLERY_DIM);
+        for(auto & value : embedding) {
+            value = dist(rng);
+        }
+        face_embedding_normalize(embedding.data(), embedding.data());
+        return embedding;
+    };
+
+    std::vector<std::vector<float>> identities;
+    for(int i = 0; i < FACE_GALLERY_PRECISION_BENCHMARK_IDENTITIES; i++) {
+        identities.push_back(random_embedding());
+    }
+    // 一半是已录入身份加噪声，一半是陌生人
+    std::uniform_int_distribution<int> pick(0, FACE_GALLERY_PRECISION_BENCHMARK_IDENTITIES - 1);
+    std::vector<std::vector<float>> queries;
+    for(int i = 0; i < FACE_GALLERY_PRECISION_BENCHMARK_QUERIES; i++) {
+        auto query = identities[pick(rng)];
+        for(auto & value : query) {
+            value += dist(rng) * FACE_GALLERY_PRECISION_BENCHMARK_NOISE;
+        }
+        queries.push_back(std::move(query));
+        queries.push_back(random_embedding());
+    }
+
+    const FaceEmbeddingPrecision precisions[] = {FaceEmbeddingPrecision::FP32, FaceEmbeddingPrecision::FP16,
+                                                 FaceEmbeddingPrecision::INT8};
+    std::vector<face_match_t> reference;
+    for(auto precision : precisions) {
+        FaceGallery gallery(FaceGalleryIndex::EXACT, precision);
+        for(auto & identity : identities) {
+            gallery.add(identity.data());
+        }
+
+        std::vector<face_match_t> matches;
+        for(auto & query : queries) {
+            matches.push_back(gallery.search(query.data()));
+        }
+        if(reference.empty()) {
+            reference = matches;
+        }
+
+        int same_id    = 0;
+        int same_match = 0;
+        float max_diff = 0;
+        for(size_t i = 0; i < matches.size(); i++) {
+            same_id += matches[i].id == reference[i].id;
+            same_match += matches[i].is_match == reference[i].is_match;
+            if(matches[i].id == reference[i].id) {
+                max_diff = std::max(max_diff, std::fabs(matches[i].score - reference[i].score));
+            }
+        }
+
+        size_t next = 0;
+        auto stat   = benchmark_measure([&]() { gallery.search(queries[next++ % queries.size()].data()); },
+                                        FACE_GALLERY_PRECISION_BENCHMARK_QUERIES);
+        char label[64];
+        snprintf(label, sizeof(label), "%s top-1", face_embedding_precision_name(precision));
+        benchmark_print(label, stat);
+
+        size_t bytes = face_embedding_row_bytes(precision) * identities.size();
+        if(precision == FaceEmbeddingPrecision::INT8) {
+            bytes += sizeof(float) * identities.size();
+        }
+        printf("  %-6s gallery=%.1fMB same top-1=%.3f same decision=%.3f max score diff=%.4f\n",
+               face_embedding_precision_name(precision), bytes / 1048576.0, (double)same_id / matches.size(),
+               (double)same_match / matches.size(), max_diff);
+    }
+    return 0;
+}
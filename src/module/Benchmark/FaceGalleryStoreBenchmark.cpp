@@ -0,0 +1,100 @@
+#include "Benchmark.hpp"
+#include "FaceGalleryStore.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+// 图库文件所在目录，每次录入都会 fdatasync，在 tmpfs 上测不出磁盘的同步耗时
+#define FACE_GALLERY_STORE_BENCHMARK_DIR_ENV "BENCHMARK_GALLERY_DIR"
+#define FACE_GALLERY_STORE_BENCHMARK_DEFAULT_DIR "/tmp"
+#define FACE_GALLERY_STORE_BENCHMARK_IDENTITIES 50000
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static long long file_size(const std::string & path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? (long long)st.st_size : -1;
+}
+
+// 重新打开文件，相当于一次重启
+static void reopen(const char * label, const std::string & path)
+{
+    FaceGallery gallery(FaceGalleryIndex::EXACT);
+    FaceGalleryStore store(gallery, path);
+    auto start  = std::chrono::steady_clock::now();
+    bool is_ok  = store.open();
+    double time = elapsed_ms(start);
+    printf("  %-24s ok=%d identities=%d file=%lldKB open=%.1fms\n", label, is_ok, gallery.size(),
+           file_size(path) / 1024, time);
+}
+
+int benchmark_face_gallery_store()
+{
+    const char * dir = getenv(FACE_GALLERY_STORE_BENCHMARK_DIR_ENV);
+    std::string path = dir ? dir : FACE_GALLERY_STORE_BENCHMARK_DEFAULT_DIR;
+    path += "/face_gallery_benchmark.bin";
+    unlink(path.c_str());
+
+    std::mt19937 rng(1);
+    std::normal_distribution<float> dist(0, 1);
+    std::vector<float> embedding(FACE_GALLERY_DIM);
+
+    {
+        FaceGallery gallery(FaceGalleryIndex::EXACT);
+        FaceGalleryStore store(gallery, path);
+        if(!store.open()) {
+            return 1;
+        }
+        auto enroll_stat = benchmark_measure(
+            [&]() {
+                for(auto & value : embedding) {
+                    value = dist(rng);
+                }
+                store.enroll(embedding.data());
+            },
+            FACE_GALLERY_STORE_BENCHMARK_IDENTITIES, 0);
+        benchmark_print("enroll (append + fdatasync)", enroll_stat);
+    }
+    reopen("reopen", path);
+
+    // 末尾留下半条记录，模拟录入时断电
+    {
+        FILE * file = fopen(path.c_str(), "ab");
+        if(file != nullptr) {
+            fwrite(embedding.data(), 1, 100, file);
+            fclose(file);
+        }
+    }
+    reopen("reopen after torn write", path);
+
+    {
+        FaceGallery gallery(FaceGalleryIndex::EXACT);
+        FaceGalleryStore store(gallery, path);
+        store.open();
+        // 删除超过一半后自动在后台压缩，compact 会先等后台压缩完成
+        auto start = std::chrono::steady_clock::now();
+        for(int id = 0; id < FACE_GALLERY_STORE_BENCHMARK_IDENTITIES * 3 / 5; id++) {
+            store.remove(id);
+        }
+        printf("  remove %d identities: %.1fms\n", FACE_GALLERY_STORE_BENCHMARK_IDENTITIES * 3 / 5, elapsed_ms(start));
+        start = std::chrono::steady_clock::now();
+        store.compact();
+        printf("  compact: %.1fms\n", elapsed_ms(start));
+    }
+    reopen("reopen after compaction", path);
+
+    unlink(path.c_str());
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "Benchmark.hpp"
+#include "FrameRing.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#define FRAME_RING_BENCHMARK_FRAMES 300
+// 模拟采集周期和处理不过来的消费者
+#define FRAME_RING_BENCHMARK_CAPTURE_US 2000
+#define FRAME_RING_BENCHMARK_CONSUME_US 5000
+
+static int64_t now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static double percentile(std::vector<double> & samples, int p)
+{
+    if(samples.empty()) {
+        return 0;
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[std::min(samples.size() - 1, samples.size() * p / 100)];
+}
+
+// 采集线程按固定周期写入，消费者每帧耗时固定，统计采集间隔和取到帧时的帧龄
+static void run_policy(FrameRingPolicy policy)
+{
+    FrameRing ring(FRAME_RING_CAPACITY, policy);
+    std::vector<double> intervals;
+    std::vector<double> ages;
+
+    std::thread consumer([&]() {
+        Frame frame;
+        while(ring.pop(frame)) {
+            ages.push_back((now_us() - frame.timestamp_us) / 1000.0);
+            std::this_thread::sleep_for(std::chrono::microseconds(FRAME_RING_BENCHMARK_CONSUME_US));
+        }
+    });
+
+    auto next       = std::chrono::steady_clock::now();
+    int64_t last_us = 0;
+    for(int i = 0; i < FRAME_RING_BENCHMARK_FRAMES; i++) {
+        next += std::chrono::microseconds(FRAME_RING_BENCHMARK_CAPTURE_US);
+        std::this_thread::sleep_until(next);
+
+        Frame frame;
+        frame.sequence     = i + 1;
+        frame.timestamp_us = now_us();
+        if(last_us != 0) {
+            intervals.push_back((frame.timestamp_us - last_us) / 1000.0);
+        }
+        last_us = frame.timestamp_us;
+        ring.push(std::move(frame));
+    }
+    ring.close();
+    consumer.join();
+
+    auto stats = ring.stats();
+    printf("  %-12s captured=%-4llu dropped=%-4llu delivered=%-4llu capture interval p99=%6.2fms "
+           "frame age p50=%6.2fms p99=%6.2fms\n",
+           frame_ring_policy_name(policy), (unsigned long long)stats.captured, (unsigned long long)stats.dropped,
+           (unsigned long long)stats.delivered, percentile(intervals, 99), percentile(ages, 50),
+           percentile(ages, 99));
+}
+
+int benchmark_frame_ring()
+{
+    printf("  capture every %.1fms, consumer takes %.1fms per frame, capacity %d\n",
+           FRAME_RING_BENCHMARK_CAPTURE_US / 1000.0, FRAME_RING_BENCHMARK_CONSUME_US / 1000.0, FRAME_RING_CAPACITY);
+    run_policy(FrameRingPolicy::BLOCK);
+    run_policy(FrameRingPolicy::DROP_OLDEST);
+    run_policy(FrameRingPolicy::LATEST_ONLY);
+    return 0;
+}
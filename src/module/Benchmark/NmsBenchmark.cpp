@@ -0,0 +1,145 @@
+#include "Benchmark.hpp"
+#include "Nms.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+#define NMS_BENCHMARK_ITERATIONS 50
+#define NMS_BENCHMARK_IMAGE_SIZE 640
+#define NMS_BENCHMARK_CLASS_NUM 4
+#define NMS_BENCHMARK_IOU 0.45f
+#define NMS_BENCHMARK_TOP_K 128
+
+// 原来的实现: 按分数排序后，对每个类别扫描全部候选框
+static int reference_nms(const std::vector<nms_candidate_t> & candidates, float threshold, int top_k, int * keep)
+{
+    int count = candidates.size();
+    std::vector<int> order(count);
+    for(int i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return candidates[a].score > candidates[b].score; });
+
+    std::set<int> class_set;
+    for(auto & c : candidates) {
+        class_set.insert(c.class_id);
+    }
+
+    for(int class_id : class_set) {
+        for(int i = 0; i < count; ++i) {
+            if(order[i] == -1 || candidates[order[i]].class_id != class_id) {
+                continue;
+            }
+            const nms_candidate_t & a = candidates[order[i]];
+            for(int j = i + 1; j < count; ++j) {
+                if(order[j] == -1 || candidates[order[j]].class_id != class_id) {
+                    continue;
+                }
+                const nms_candidate_t & b = candidates[order[j]];
+
+                float w      = fmax(0.f, fmin(a.x2, b.x2) - fmax(a.x1, b.x1) + 1);
+                float h      = fmax(0.f, fmin(a.y2, b.y2) - fmax(a.y1, b.y1) + 1);
+                float i_area = w * h;
+                float u =
+                    (a.x2 - a.x1 + 1) * (a.y2 - a.y1 + 1) + (b.x2 - b.x1 + 1) * (b.y2 - b.y1 + 1) - i_area;
+                if(u > 0.f && i_area / u > threshold) {
+                    order[j] = -1;
+                }
+            }
+        }
+    }
+
+    int keep_count = 0;
+    for(int i = 0; i < count && keep_count < top_k; i++) {
+        if(order[i] != -1) {
+            keep[keep_count++] = candidates[order[i]].index;
+        }
+    }
+    return keep_count;
+}
+
+// 模拟拥挤场景: objects 个目标，每个目标周围有 per_object 个抖动的候选框
+static std::vector<nms_candidate_t> generate_candidates(int objects, int per_object)
+{
+    std::vector<nms_candidate_t> candidates;
+    for(int o = 0; o < objects; o++) {
+        float w      = 16 + rand() % 96;
+        float h      = 16 + rand() % 160;
+        float x      = rand() % (int)(NMS_BENCHMARK_IMAGE_SIZE - w);
+        float y      = rand() % (int)(NMS_BENCHMARK_IMAGE_SIZE - h);
+        int class_id = rand() % NMS_BENCHMARK_CLASS_NUM;
+        for(int k = 0; k < per_object; k++) {
+            float dx = (rand() % 17 - 8) * w / 64;
+            float dy = (rand() % 17 - 8) * h / 64;
+            nms_candidate_t c;
+            c.x1       = x + dx;
+            c.y1       = y + dy;
+            c.x2       = x + dx + w * (0.9f + (rand() % 20) / 100.f);
+            c.y2       = y + dy + h * (0.9f + (rand() % 20) / 100.f);
+            c.score    = 0.5f + (rand() % 5000) / 10000.f;
+            c.class_id = class_id;
+            c.index    = candidates.size();
+            candidates.push_back(c);
+        }
+    }
+    return candidates;
+}
+
+static int benchmark_nms_case(int objects, int per_object)
+{
+    auto candidates = generate_candidates(objects, per_object);
+
+    std::vector<int> reference_keep(NMS_BENCHMARK_TOP_K);
+    int reference_count = 0;
+    auto reference_stat = benchmark_measure(
+        [&]() {
+            reference_count = reference_nms(candidates, NMS_BENCHMARK_IOU, NMS_BENCHMARK_TOP_K, reference_keep.data());
+        },
+        NMS_BENCHMARK_ITERATIONS, 2);
+
+    Nms nms(candidates.size());
+    std::vector<int> keep(NMS_BENCHMARK_TOP_K);
+    int count = 0;
+
+    auto run_nms = [&]() {
+        nms.clear();
+        for(auto & c : candidates) {
+            nms.push(c);
+        }
+        count = nms.run(NMS_BENCHMARK_IOU, NMS_BENCHMARK_TOP_K, keep.data());
+    };
+
+    nms.set_grid_min_count(-1);
+    auto linear_stat = benchmark_measure(run_nms, NMS_BENCHMARK_ITERATIONS, 2);
+    bool is_linear_same =
+        count == reference_count && std::equal(keep.begin(), keep.begin() + count, reference_keep.begin());
+
+    nms.set_grid_min_count(0);
+    auto grid_stat = benchmark_measure(run_nms, NMS_BENCHMARK_ITERATIONS, 2);
+    bool is_grid_same =
+        count == reference_count && std::equal(keep.begin(), keep.begin() + count, reference_keep.begin());
+
+    printf(" %d objects x %d boxes = %zu candidates, %d kept\n", objects, per_object, candidates.size(),
+           reference_count);
+    benchmark_print("reference per-class O(n^2)", reference_stat);
+    benchmark_print("nms sorted + top-k", linear_stat);
+    benchmark_print("nms grid buckets", grid_stat);
+    printf("  speedup %.2fx / %.2fx, same result: %s / %s\n", reference_stat.avg_us / linear_stat.avg_us,
+           reference_stat.avg_us / grid_stat.avg_us, is_linear_same ? "yes" : "no", is_grid_same ? "yes" : "no");
+
+    return is_linear_same && is_grid_same ? 0 : 1;
+}
+
+int benchmark_nms()
+{
+    srand(0);
+    int ret = 0;
+    ret |= benchmark_nms_case(20, 20);
+    ret |= benchmark_nms_case(100, 30);
+    ret |= benchmark_nms_case(300, 30);
+    return ret;
+}
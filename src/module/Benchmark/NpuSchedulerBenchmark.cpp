@@ -0,0 +1,167 @@
+#include "Benchmark.hpp"
+#include "NpuScheduler.hpp"
+#include "RknnPool.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 每个工作线程提交的任务数
+#define NPU_BENCHMARK_TASKS 100
+// 模拟的单次推理耗时，YOLO 比人脸检测/特征提取重
+#define NPU_BENCHMARK_YOLO_US 3000
+#define NPU_BENCHMARK_RETINAFACE_US 1500
+#define NPU_BENCHMARK_FACENET_US 500
+// 租用开销测试中每个线程的租用次数
+#define NPU_BENCHMARK_LEASES 100000
+
+// 用互斥锁模拟核心串行执行，上下文锁模拟同一上下文不能同时推理
+static std::mutex npu_core_mutexes[NPU_CORE_NUM];
+
+typedef struct {
+    std::vector<rknn_core_mask> core_masks;
+    std::unique_ptr<std::mutex[]> context_mutexes;
+    std::unique_ptr<NpuContextGroup> group;
+    std::atomic<uint32_t> next_id{0};
+    int run_us;
+} sim_model_t;
+
+static void sim_model_init(sim_model_t & model, const char * path, int contexts, int run_us)
+{
+    for(int i = 0; i < contexts; i++) {
+        model.core_masks.push_back(NpuScheduler::instance().assign_core(path));
+    }
+    model.context_mutexes = std::make_unique<std::mutex[]>(contexts);
+    model.group           = std::make_unique<NpuContextGroup>(model.core_masks);
+    model.run_us          = run_us;
+}
+
+static void sim_model_deinit(sim_model_t & model)
+{
+    for(auto core_mask : model.core_masks) {
+        NpuScheduler::instance().release_core(core_mask);
+    }
+}
+
+static void sim_run(sim_model_t & model, int context_id)
+{
+    std::lock_guard<std::mutex> context_lock(model.context_mutexes[context_id]);
+    rknn_core_mask core_mask = model.core_masks[context_id];
+
+    NpuScheduler::instance().begin_run(core_mask);
+    for(int i = 0; i < NPU_CORE_NUM; i++) {
+        if(core_mask & (RKNN_NPU_CORE_0 << i)) {
+            std::lock_guard<std::mutex> core_lock(npu_core_mutexes[i]);
+            std::this_thread::sleep_for(std::chrono::microseconds(model.run_us));
+            break;
+        }
+    }
+    NpuScheduler::instance().end_run(core_mask);
+}
+
+// 原来的分配方式: 按提交顺序轮流使用上下文，不看核心是否忙
+static void run_round_robin(sim_model_t & model)
+{
+    sim_run(model, model.next_id++ % model.core_masks.size());
+}
+
+static void run_least_loaded(sim_model_t & model)
+{
+    NpuLease lease(*model.group);
+    sim_run(model, lease.context_id());
+}
+
+// 两个推理池各 RKNN_POOL_SIZE 个工作线程同时运行，人脸任务先检测再提取特征
+static void run_mixed(const char * label, void (*run)(sim_model_t &))
+{
+    sim_model_t yolo, retinaface, facenet;
+    sim_model_init(yolo, "yolo11s.rknn", RKNN_POOL_SIZE, NPU_BENCHMARK_YOLO_US);
+    sim_model_init(retinaface, "retina_face.rknn", RKNN_POOL_SIZE, NPU_BENCHMARK_RETINAFACE_US);
+    sim_model_init(facenet, "facenet.rknn", RKNN_POOL_SIZE, NPU_BENCHMARK_FACENET_US);
+
+    NpuScheduler::instance().reset_window();
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < RKNN_POOL_SIZE; i++) {
+        workers.emplace_back([&]() {
+            for(int j = 0; j < NPU_BENCHMARK_TASKS; j++) {
+                run(yolo);
+            }
+        });
+        workers.emplace_back([&]() {
+            for(int j = 0; j < NPU_BENCHMARK_TASKS; j++) {
+                run(retinaface);
+                run(facenet);
+            }
+        });
+    }
+    for(auto & worker : workers) {
+        worker.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // 每个人脸任务包含两次推理
+    int runs = RKNN_POOL_SIZE * NPU_BENCHMARK_TASKS * 3;
+    printf("  %-12s %8.1fms %8.1f runs/s\n", label, seconds * 1000, runs / seconds);
+    NpuScheduler::instance().print_stats();
+
+    sim_model_deinit(yolo);
+    sim_model_deinit(retinaface);
+    sim_model_deinit(facenet);
+}
+
+// RKNN_POOL_SIZE 个线程同时反复租用和归还，不做推理，测量每次租用的开销
+static void run_lease_contention(const char * label, sim_model_t & model, void (*lease)(sim_model_t &))
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for(int i = 0; i < RKNN_POOL_SIZE; i++) {
+        workers.emplace_back([&]() {
+            for(int j = 0; j < NPU_BENCHMARK_LEASES; j++) {
+                lease(model);
+            }
+        });
+    }
+    for(auto & worker : workers) {
+        worker.join();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("  %-28s %8.1fns per lease\n", label, ns / ((double)RKNN_POOL_SIZE * NPU_BENCHMARK_LEASES));
+}
+
+// 原来的方式: 加锁的轮转序号取模，再用上下文自己的锁防止两个任务同时使用
+static std::mutex lease_id_mutex;
+static uint32_t lease_id;
+static void lease_modulo(sim_model_t & model)
+{
+    int context_id;
+    {
+        std::lock_guard<std::mutex> lock(lease_id_mutex);
+        context_id = lease_id++ % model.core_masks.size();
+    }
+    std::lock_guard<std::mutex> context_lock(model.context_mutexes[context_id]);
+}
+
+static void lease_free_list(sim_model_t & model)
+{
+    NpuLease lease(*model.group);
+}
+
+// 用固定耗时模拟 YOLO 和人脸模型混合负载，比较按轮转和按核心负载分配上下文的吞吐和各核心利用率，
+// 再比较两种方式在高竞争下每次取得上下文的开销
+int benchmark_npu_scheduler()
+{
+    run_mixed("round-robin", run_round_robin);
+    run_mixed("least-loaded", run_least_loaded);
+
+    sim_model_t model;
+    sim_model_init(model, "yolo11s.rknn", RKNN_POOL_SIZE, 0);
+    run_lease_contention("modulo id + context mutex", model, lease_modulo);
+    run_lease_contention("lock-free free list", model, lease_free_list);
+    sim_model_deinit(model);
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include "Benchmark.hpp"
+#include "FileSource.hpp"
+#include "ImageProcess.hpp"
+#include "NpuScheduler.hpp"
+#include "RknnPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// 回放的视频文件，未设置时跳过
+#define PIPELINE_BENCHMARK_VIDEO_ENV "BENCHMARK_VIDEO"
+// 最多处理的帧数，未设置时处理整个文件
+#define PIPELINE_BENCHMARK_FRAMES_ENV "BENCHMARK_FRAMES"
+// 同时在推理中的帧数上限，不超过线程池队列容量，线程池不会丢帧
+#define PIPELINE_BENCHMARK_IN_FLIGHT RKNN_POOL_QUEUE_CAPACITY
+// 送完所有帧后等待剩余结果的最长时间
+#define PIPELINE_BENCHMARK_DRAIN_TIMEOUT_MS 5000
+
+typedef struct {
+    std::function<void(Frame)> submit;
+    std::function<bool(Frame &)> take_result;
+    std::function<reorder_stats_t()> get_stats;
+} pipeline_t;
+
+static int64_t now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 尽快解码并送入推理，随时取走已完成的结果，统计吞吐和每帧从解码完成到取到结果的延迟
+static void run_pipeline(const char * label, const char * path, int max_frames, pipeline_t & pipeline)
+{
+    FileSource source(path, false, false);
+    if(!source.is_opened()) {
+        return;
+    }
+
+    uint64_t submitted = 0;
+    std::vector<double> latencies_ms;
+
+    auto finished = [&]() {
+        auto stats = pipeline.get_stats();
+        return stats.released + stats.skipped + stats.missing;
+    };
+    auto take_results = [&]() {
+        Frame result;
+        while(pipeline.take_result(result)) {
+            latencies_ms.push_back((now_us() - result.timestamp_us) / 1000.0);
+            result = Frame();
+        }
+    };
+
+    source.start();
+    NpuScheduler::instance().reset_window();
+    int64_t start_us = now_us();
+    while(max_frames <= 0 || (int)submitted < max_frames) {
+        Frame frame = source.get_frame();
+        if(!frame.image) {
+            break;
+        }
+        while(submitted - finished() >= PIPELINE_BENCHMARK_IN_FLIGHT) {
+            take_results();
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        pipeline.submit(std::move(frame));
+        submitted++;
+        take_results();
+    }
+
+    int64_t deadline_us = now_us() + PIPELINE_BENCHMARK_DRAIN_TIMEOUT_MS * 1000;
+    while(finished() < submitted && now_us() < deadline_us) {
+        take_results();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    take_results();
+    double seconds = (now_us() - start_us) / 1e6;
+    source.stop();
+
+    auto stats = pipeline.get_stats();
+    size_t count = latencies_ms.size();
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    double p50 = count ? latencies_ms[count / 2] : 0;
+    double p99 = count ? latencies_ms[std::min(count - 1, count * 99 / 100)] : 0;
+    printf("  %-10s frames=%-6llu results=%-6zu missing=%-4llu %7.1ffps  latency p50=%7.1fms p99=%7.1fms\n", label,
+           (unsigned long long)submitted, count, (unsigned long long)stats.missing, count / seconds, p50, p99);
+    NpuScheduler::instance().print_stats();
+}
+
+int benchmark_pipeline()
+{
+    const char * path = getenv(PIPELINE_BENCHMARK_VIDEO_ENV);
+    if(path == nullptr) {
+        printf("  set %s to a recorded video to run\n", PIPELINE_BENCHMARK_VIDEO_ENV);
+        return 0;
+    }
+    const char * frames_env = getenv(PIPELINE_BENCHMARK_FRAMES_ENV);
+    int max_frames          = frames_env ? atoi(frames_env) : 0;
+
+    // 先确认文件可以解码，再加载模型
+    {
+        FileSource probe(path, false, false);
+        if(!probe.is_opened()) {
+            return 1;
+        }
+    }
+
+    {
+        SecurityRknnPool pool;
+        pool.activate();
+        pool.wait_ready();
+        std::unique_ptr<ImageProcess> image_process;
+
+        pipeline_t pipeline;
+        pipeline.submit = [&](Frame frame) {
+            if(!image_process) {
+                image_process =
+                    std::make_unique<ImageProcess>(frame.image->cols, frame.image->rows, pool.get_yolo_model_size());
+            }
+            pool.add_inference_task(std::move(frame), *image_process);
+        };
+        pipeline.take_result = [&](Frame & frame) { return pool.get_result(0, frame); };
+        pipeline.get_stats   = [&]() { return pool.get_reorder_stats(); };
+        run_pipeline("security", path, max_frames, pipeline);
+    }
+
+    {
+        FaceRknnPool pool;
+        pool.activate();
+        pool.wait_ready();
+        std::unique_ptr<ImageProcess> image_process;
+
+        pipeline_t pipeline;
+        pipeline.submit = [&](Frame frame) {
+            if(!image_process) {
+                image_process = std::make_unique<ImageProcess>(frame.image->cols, frame.image->rows,
+                                                               pool.get_retinaface_model_size());
+            }
+            pool.add_inference_task(std::move(frame), *image_process);
+        };
+        pipeline.take_result = [&](Frame & frame) { return pool.get_result(frame); };
+        pipeline.get_stats   = [&]() { return pool.get_reorder_stats(); };
+        run_pipeline("face", path, max_frames, pipeline);
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "Benchmark.hpp"
+#include "Camera.hpp"
+#include "ImageProcess.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define PREPROCESS_BENCHMARK_ITERATIONS 300
+
+// 对比原来的 convert + cvtColor 和融合后的预处理
+static int benchmark_preprocess_size(int target_size)
+{
+    cv::Mat src(CAMERA_HEIGHT, CAMERA_WIDTH, CV_8UC3);
+    for(int y = 0; y < src.rows; y++) {
+        uint8_t * row = src.ptr<uint8_t>(y);
+        for(int x = 0; x < src.cols * 3; x++) {
+            row[x] = rand() & 0xff;
+        }
+    }
+
+    ImageProcess image_process(CAMERA_WIDTH, CAMERA_HEIGHT, target_size);
+
+    cv::Mat opencv_rgb;
+    auto opencv_stat = benchmark_measure(
+        [&]() {
+            auto convert_img = image_process.convert(src);
+            opencv_rgb       = cv::Mat::zeros(target_size, target_size, convert_img->type());
+            cv::cvtColor(*convert_img, opencv_rgb, cv::COLOR_BGR2RGB);
+        },
+        PREPROCESS_BENCHMARK_ITERATIONS);
+
+    int stride = target_size * 3;
+    std::vector<uint8_t> fused_rgb(stride * target_size);
+
+    // 水平插值分别用标量和 NEON 实现，两者整数运算相同，结果应完全一致
+    ImageProcess::set_neon_enabled(false);
+    auto scalar_stat = benchmark_measure([&]() { image_process.convert(src, fused_rgb.data(), stride); },
+                                         PREPROCESS_BENCHMARK_ITERATIONS);
+    std::vector<uint8_t> scalar_rgb = fused_rgb;
+    ImageProcess::set_neon_enabled(true);
+
+    bool is_neon = ImageProcess::is_neon_available();
+    benchmark_stat_t neon_stat{};
+    bool is_same = true;
+    if(is_neon) {
+        neon_stat = benchmark_measure([&]() { image_process.convert(src, fused_rgb.data(), stride); },
+                                      PREPROCESS_BENCHMARK_ITERATIONS);
+        is_same   = fused_rgb == scalar_rgb;
+    }
+
+    // 定点插值与 OpenCV 的结果允许有少量误差
+    int max_diff = 0;
+    for(int y = 0; y < target_size; y++) {
+        const uint8_t * a = opencv_rgb.ptr<uint8_t>(y);
+        const uint8_t * b = fused_rgb.data() + y * stride;
+        for(int x = 0; x < stride; x++) {
+            max_diff = std::max(max_diff, std::abs(a[x] - b[x]));
+        }
+    }
+
+    printf(" %dx%d -> %dx%d\n", CAMERA_WIDTH, CAMERA_HEIGHT, target_size, target_size);
+    benchmark_print("opencv convert + cvtColor", opencv_stat);
+    benchmark_print("fused letterbox (scalar)", scalar_stat);
+    printf("  scalar speedup %.2fx, max pixel diff %d\n", opencv_stat.avg_us / scalar_stat.avg_us, max_diff);
+    if(is_neon) {
+        benchmark_print("fused letterbox (neon)", neon_stat);
+        printf("  neon speedup %.2fx over opencv, %.2fx over scalar, same as scalar=%d\n",
+               opencv_stat.avg_us / neon_stat.avg_us, scalar_stat.avg_us / neon_stat.avg_us, is_same);
+    } else {
+        printf("  neon not available in this build\n");
+    }
+
+    if(!is_same) {
+        return 1;
+    }
+    return max_diff <= 2 ? 0 : 1;
+}
+
+int benchmark_preprocess()
+{
+    int ret = 0;
+    ret |= benchmark_preprocess_size(320);
+    ret |= benchmark_preprocess_size(640);
+    return ret;
+}
@@ -0,0 +1,132 @@
+#include "Benchmark.hpp"
+#include "StealingThreadPool.hpp"
+#include "ThreadPool.hpp"
+#include <atomic>
+#include <cstdio>
+#include <future>
+#include <thread>
+#include <vector>
+
+#define THREAD_POOL_BENCHMARK_ITERATIONS 20
+#define THREAD_POOL_BENCHMARK_WORKERS 10
+#define THREAD_POOL_BENCHMARK_PRODUCERS 4
+#define THREAD_POOL_BENCHMARK_TASKS 5000
+
+// 多个生产线程同时提交短任务，等待全部执行完
+template <class Pool> static benchmark_stat_t measure_contention(Pool & pool)
+{
+    std::atomic<int> done{0};
+    int total = THREAD_POOL_BENCHMARK_PRODUCERS * THREAD_POOL_BENCHMARK_TASKS;
+
+    return benchmark_measure(
+        [&]() {
+            done = 0;
+            std::vector<std::thread> producers;
+            for(int p = 0; p < THREAD_POOL_BENCHMARK_PRODUCERS; p++) {
+                producers.emplace_back([&]() {
+                    for(int i = 0; i < THREAD_POOL_BENCHMARK_TASKS; i++) {
+                        pool.enqueue([&]() { done++; });
+                    }
+                });
+            }
+            for(auto & producer : producers) {
+                producer.join();
+            }
+            while(done.load() < total) {
+                std::this_thread::yield();
+            }
+        },
+        THREAD_POOL_BENCHMARK_ITERATIONS, 2);
+}
+
+// 单线程池被占用时先提交普通任务再提交高优先级任务，高优先级任务应先执行
+static bool check_priority()
+{
+    StealingThreadPool pool(1);
+    std::promise<void> gate;
+    auto gate_future = gate.get_future().share();
+    pool.enqueue([gate_future]() { gate_future.wait(); });
+
+    std::mutex mutex;
+    std::vector<int> order;
+    for(int i = 0; i < 8; i++) {
+        pool.enqueue([&, i]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(i);
+        });
+    }
+    auto high = pool.enqueue(TaskPriority::HIGH, [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(-1);
+    });
+
+    gate.set_value();
+    high.wait();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return !order.empty() && order[0] == -1;
+}
+
+// 容量为 capacity 时连续提交，应只保留最新的 capacity 个任务
+static bool check_drop_oldest(int capacity, int count)
+{
+    StealingThreadPool pool(1, capacity, OverflowPolicy::DROP_OLDEST);
+    std::promise<void> gate;
+    auto gate_future = gate.get_future().share();
+    // 先占住工作线程，等它开始执行后再提交
+    std::promise<void> started;
+    pool.enqueue(TaskPriority::HIGH, [&started, gate_future]() {
+        started.set_value();
+        gate_future.wait();
+    });
+    started.get_future().wait();
+
+    std::vector<std::future<int>> futures;
+    for(int i = 0; i < count; i++) {
+        futures.push_back(pool.enqueue([i]() { return i; }));
+    }
+    gate.set_value();
+
+    int executed = 0;
+    bool is_newest = true;
+    for(int i = 0; i < count; i++) {
+        try {
+            futures[i].get();
+            executed++;
+            is_newest &= i >= count - capacity;
+        } catch(const std::future_error &) {
+        }
+    }
+    printf("  drop-oldest: capacity=%d submitted=%d executed=%d dropped=%zu\n", capacity, count, executed,
+           pool.dropped());
+    return is_newest && executed == capacity && (int)pool.dropped() == count - capacity;
+}
+
+int benchmark_thread_pool()
+{
+    benchmark_stat_t mutex_stat;
+    benchmark_stat_t stealing_stat;
+    size_t stolen;
+    {
+        ThreadPool pool(THREAD_POOL_BENCHMARK_WORKERS);
+        mutex_stat = measure_contention(pool);
+    }
+    {
+        StealingThreadPool pool(THREAD_POOL_BENCHMARK_WORKERS);
+        stealing_stat = measure_contention(pool);
+        stolen        = pool.stolen();
+    }
+
+    printf("  %d producers x %d tasks, %d workers\n", THREAD_POOL_BENCHMARK_PRODUCERS, THREAD_POOL_BENCHMARK_TASKS,
+           THREAD_POOL_BENCHMARK_WORKERS);
+    benchmark_print("ThreadPool (single queue)", mutex_stat);
+    benchmark_print("StealingThreadPool", stealing_stat);
+    printf("  speedup %.2fx, stolen %zu\n", mutex_stat.avg_us / stealing_stat.avg_us, stolen);
+
+    bool is_priority_ok = check_priority();
+    bool is_drop_ok     = check_drop_oldest(4, 16);
+    printf("  priority lane: %s, drop-oldest: %s\n", is_priority_ok ? "ok" : "failed", is_drop_ok ? "ok" : "failed");
+
+    return is_priority_ok && is_drop_ok ? 0 : 1;
+}
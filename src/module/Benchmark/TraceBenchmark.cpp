@@ -0,0 +1,52 @@
+#include "Benchmark.hpp"
+#include "Trace.hpp"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+#define TRACE_BENCHMARK_ITERATIONS 200
+#define TRACE_BENCHMARK_SPANS 10000
+
+// 每次迭代记录 TRACE_BENCHMARK_SPANS 个 span，同时另一个线程不断读取统计，模拟线上导出
+int benchmark_trace()
+{
+    if(!trace_enabled()) {
+        printf("  trace disabled by %s\n", TRACE_ENABLE_ENV);
+        return 0;
+    }
+
+    std::atomic<bool> is_running{true};
+    std::thread reader([&]() {
+        trace_stat_t stats[(int)TraceStage::COUNT];
+        while(is_running) {
+            trace_get_stats(stats);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+
+    volatile int sink = 0;
+    auto empty_stat   = benchmark_measure(
+        [&]() {
+            for(int i = 0; i < TRACE_BENCHMARK_SPANS; i++) {
+                sink = sink + 1;
+            }
+        },
+        TRACE_BENCHMARK_ITERATIONS);
+    auto trace_stat = benchmark_measure(
+        [&]() {
+            for(int i = 0; i < TRACE_BENCHMARK_SPANS; i++) {
+                TRACE_SCOPE(TraceStage::NPU_RUN);
+                sink = sink + 1;
+            }
+        },
+        TRACE_BENCHMARK_ITERATIONS);
+
+    is_running = false;
+    reader.join();
+
+    benchmark_print("loop without trace", empty_stat);
+    benchmark_print("loop with TRACE_SCOPE", trace_stat);
+    printf("  overhead %.1fns per span\n", (trace_stat.avg_us - empty_stat.avg_us) * 1000 / TRACE_BENCHMARK_SPANS);
+    trace_print_stats();
+    return 0;
+}
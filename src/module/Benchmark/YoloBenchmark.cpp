@@ -0,0 +1,208 @@
+#include "Benchmark.hpp"
+#include "PostProcess.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define YOLO_BENCHMARK_ITERATIONS 200
+#define YOLO_BENCHMARK_MODEL_SIZE 640
+#define YOLO_BENCHMARK_DFL_LEN 16
+#define YOLO_BENCHMARK_CLASS_NUM 80
+// 分数超过阈值的网格比例
+#define YOLO_BENCHMARK_HOT_RATIO 0.02
+
+// 每个分支的输出: box, score, score_sum
+typedef struct {
+    std::vector<int8_t> box;
+    std::vector<int8_t> score;
+    std::vector<int8_t> score_sum;
+} yolo_branch_t;
+
+static int8_t quantize(float value, int32_t zp, float scale)
+{
+    float q = std::round(value / scale) + zp;
+    return (int8_t)std::min(127.f, std::max(-128.f, q));
+}
+
+// 原来的逐网格扫描 + exp DFL，作为结果和耗时的对照
+static int reference_process_i8(const int8_t * box_tensor, int32_t box_zp, float box_scale, const int8_t * score_tensor,
+                                int32_t score_zp, float score_scale, const int8_t * score_sum_tensor,
+                                int32_t score_sum_zp, float score_sum_scale, int grid_h, int grid_w, int stride,
+                                int dfl_len, float threshold, std::vector<float> & boxes, std::vector<float> & probs)
+{
+    int valid_count           = 0;
+    int grid_len              = grid_h * grid_w;
+    int8_t score_thres_i8     = (int8_t)std::min(127.f, std::max(-128.f, threshold / score_scale + score_zp));
+    int8_t score_sum_thres_i8 = (int8_t)std::min(127.f, std::max(-128.f, threshold / score_sum_scale + score_sum_zp));
+
+    for(int i = 0; i < grid_h; i++) {
+        for(int j = 0; j < grid_w; j++) {
+            int offset = i * grid_w + j;
+            if(score_sum_tensor[offset] < score_sum_thres_i8) {
+                continue;
+            }
+
+            int8_t max_score = -score_zp;
+            for(int c = 0; c < YOLO_BENCHMARK_CLASS_NUM; c++) {
+                if(score_tensor[offset] > score_thres_i8 && score_tensor[offset] > max_score) {
+                    max_score = score_tensor[offset];
+                }
+                offset += grid_len;
+            }
+            if(max_score <= score_thres_i8) {
+                continue;
+            }
+
+            offset = i * grid_w + j;
+            float box[4];
+            for(int b = 0; b < 4; b++) {
+                float exp_t[YOLO_BENCHMARK_DFL_LEN];
+                float exp_sum = 0;
+                float acc_sum = 0;
+                for(int k = 0; k < dfl_len; k++) {
+                    exp_t[k] = exp(((float)box_tensor[offset + (b * dfl_len + k) * grid_len] - box_zp) * box_scale);
+                    exp_sum += exp_t[k];
+                }
+                for(int k = 0; k < dfl_len; k++) {
+                    acc_sum += exp_t[k] / exp_sum * k;
+                }
+                box[b] = acc_sum;
+            }
+
+            float x1 = (-box[0] + j + 0.5) * stride;
+            float y1 = (-box[1] + i + 0.5) * stride;
+            float x2 = (box[2] + j + 0.5) * stride;
+            float y2 = (box[3] + i + 0.5) * stride;
+            boxes.push_back(x1);
+            boxes.push_back(y1);
+            boxes.push_back(x2 - x1);
+            boxes.push_back(y2 - y1);
+            probs.push_back(((float)max_score - score_zp) * score_scale);
+            valid_count++;
+        }
+    }
+    return valid_count;
+}
+
+int benchmark_yolo_postprocess()
+{
+    const float box_scale   = 0.08f;
+    const int32_t box_zp    = -20;
+    const float score_scale = 1.f / 255;
+    const int32_t score_zp  = -128;
+
+    rknn_app_context_t app_ctx;
+    memset(&app_ctx, 0, sizeof(app_ctx));
+    app_ctx.io_num.n_output = 9;
+    app_ctx.model_width     = YOLO_BENCHMARK_MODEL_SIZE;
+    app_ctx.model_height    = YOLO_BENCHMARK_MODEL_SIZE;
+    app_ctx.is_quant        = true;
+
+    std::vector<rknn_tensor_attr> output_attrs(9);
+    std::vector<rknn_output> outputs(9);
+    std::vector<yolo_branch_t> branches(3);
+    memset(output_attrs.data(), 0, output_attrs.size() * sizeof(rknn_tensor_attr));
+    memset(outputs.data(), 0, outputs.size() * sizeof(rknn_output));
+    app_ctx.output_attrs = output_attrs.data();
+
+    srand(0);
+    for(int i = 0; i < 3; i++) {
+        int grid     = YOLO_BENCHMARK_MODEL_SIZE / (8 << i);
+        int grid_len = grid * grid;
+        auto & branch = branches[i];
+        branch.box.resize(grid_len * 4 * YOLO_BENCHMARK_DFL_LEN);
+        branch.score.resize(grid_len * YOLO_BENCHMARK_CLASS_NUM);
+        branch.score_sum.resize(grid_len);
+
+        for(auto & v : branch.box) {
+            v = (int8_t)(rand() % 256 - 128);
+        }
+        for(auto & v : branch.score) {
+            v = quantize((rand() % 100) / 1000.f, score_zp, score_scale);
+        }
+        for(int k = 0; k < grid_len; k++) {
+            float sum = 0.2f;
+            if(rand() < RAND_MAX * YOLO_BENCHMARK_HOT_RATIO) {
+                float score = 0.5f + (rand() % 500) / 1000.f;
+                branch.score[(rand() % YOLO_BENCHMARK_CLASS_NUM) * grid_len + k] =
+                    quantize(score, score_zp, score_scale);
+                sum += score;
+            }
+            branch.score_sum[k] = quantize(sum, score_zp, score_scale);
+        }
+
+        int dims[3][4] = {{1, 4 * YOLO_BENCHMARK_DFL_LEN, grid, grid},
+                          {1, YOLO_BENCHMARK_CLASS_NUM, grid, grid},
+                          {1, 1, grid, grid}};
+        void * bufs[3] = {branch.box.data(), branch.score.data(), branch.score_sum.data()};
+        for(int k = 0; k < 3; k++) {
+            auto & attr = output_attrs[i * 3 + k];
+            attr.index  = i * 3 + k;
+            attr.n_dims = 4;
+            memcpy(attr.dims, dims[k], sizeof(dims[k]));
+            attr.type     = RKNN_TENSOR_INT8;
+            attr.qnt_type = RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC;
+            attr.zp       = k == 0 ? box_zp : score_zp;
+            attr.scale    = k == 0 ? box_scale : score_scale;
+            outputs[i * 3 + k].index = i * 3 + k;
+            outputs[i * 3 + k].buf   = bufs[k];
+        }
+    }
+
+    yolo_workspace_t workspace;
+    if(init_yolo_workspace(&app_ctx, &workspace) != 0) {
+        return 1;
+    }
+
+    std::vector<float> reference_boxes;
+    std::vector<float> reference_probs;
+    int reference_count = 0;
+    auto reference_stat = benchmark_measure(
+        [&]() {
+            reference_boxes.clear();
+            reference_probs.clear();
+            reference_count = 0;
+            for(int i = 0; i < 3; i++) {
+                int grid = YOLO_BENCHMARK_MODEL_SIZE / (8 << i);
+                reference_count += reference_process_i8(
+                    branches[i].box.data(), box_zp, box_scale, branches[i].score.data(), score_zp, score_scale,
+                    branches[i].score_sum.data(), score_zp, score_scale, grid, grid, 8 << i, YOLO_BENCHMARK_DFL_LEN,
+                    BOX_THRESH, reference_boxes, reference_probs);
+            }
+        },
+        YOLO_BENCHMARK_ITERATIONS);
+
+    int count = 0;
+    auto stat = benchmark_measure(
+        [&]() { count = yolo_generate_candidates(&app_ctx, outputs.data(), BOX_THRESH, &workspace); },
+        YOLO_BENCHMARK_ITERATIONS);
+
+    letterbox_t letter_box = {0, 0, 1.f};
+    yolo_result_list results;
+    auto post_process_stat = benchmark_measure(
+        [&]() {
+            yolo_post_process(&app_ctx, outputs.data(), &letter_box, BOX_THRESH, NMS_THRESH, &workspace, &results);
+        },
+        YOLO_BENCHMARK_ITERATIONS);
+
+    // 两种实现的候选框顺序相同
+    float max_diff = 0;
+    if(count == reference_count) {
+        for(int i = 0; i < count * 4; i++) {
+            max_diff = std::max(max_diff, std::fabs(workspace.boxes[i] - reference_boxes[i]));
+        }
+    }
+
+    printf(" %dx%d, %d classes, dfl_len %d, %d candidates\n", YOLO_BENCHMARK_MODEL_SIZE, YOLO_BENCHMARK_MODEL_SIZE,
+           YOLO_BENCHMARK_CLASS_NUM, YOLO_BENCHMARK_DFL_LEN, count);
+    benchmark_print("reference scan + exp dfl", reference_stat);
+    benchmark_print("block scan + lut dfl", stat);
+    benchmark_print("yolo_post_process", post_process_stat);
+    printf("  speedup %.2fx, candidates %d/%d, max box diff %.4f\n", reference_stat.avg_us / stat.avg_us, count,
+           reference_count, max_diff);
+
+    return count == reference_count && max_diff < 0.01f ? 0 : 1;
+}
@@ -1,61 +1,77 @@
 #include "Camera.hpp"
+#include "Trace.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <thread>
 
-Camera::Camera() : is_running_(false)
+Camera::Camera(const camera_config_t & config, int stream_id)
+    : FrameSource(stream_id, config.device, policy_from_env(), capacity_from_env()), config_(config)
 {
-    capture_.open(21, cv::CAP_V4L2);
+    const char * device = config_.device.c_str();
+    width_              = config_.width;
+    height_             = config_.height;
 
-    capture_.set(cv::CAP_PROP_FPS, 30);
-    capture_.set(cv::CAP_PROP_FRAME_WIDTH, CAMERA_WIDTH);
-    capture_.set(cv::CAP_PROP_FRAME_HEIGHT, CAMERA_HEIGHT);
-
-    capture_thread_fn_ = [this]() {
-        try {
-            while(is_running_) {
-
-                std::unique_lock<std::mutex> lock(frame_queue_mutex_);
-                frame_queue_cond_.wait(lock, [this]() { return frame_queue_.empty(); });
+    const char * backend = getenv(CAMERA_BACKEND_ENV);
+    if(backend == nullptr || strcmp(backend, "v4l2") == 0) {
+        int buffer_count = atoi(getenv(CAMERA_BUFFER_COUNT_ENV) ?: "0");
+        if(buffer_count <= 0) {
+            buffer_count = V4L2_CAPTURE_BUFFER_COUNT;
+        }
 
-                std::unique_ptr<cv::Mat> frame = std::make_unique<cv::Mat>();
-                capture_ >> *frame;
+        if(v4l2_.open(device, config_.width, config_.height, config_.fps, buffer_count) == 0) {
+            width_          = v4l2_.get_width();
+            height_         = v4l2_.get_height();
+            uint32_t format = v4l2_.get_pixel_format();
+            printf("Camera%d: v4l2 %s %dx%d %.4s%s\n", stream_id_, device, width_, height_, (const char *)&format,
+                   v4l2_.is_zero_copy() ? " zero-copy" : "");
+        } else {
+            std::cerr << "Camera" << stream_id_ << ": v4l2 open failed, fallback to opencv" << std::endl;
+        }
+    }
 
-                if(frame->empty()) {
-                    break;
-                }
+    if(!v4l2_.is_opened()) {
+        capture_.open(config_.device, cv::CAP_V4L2);
 
-                frame_queue_.push(std::move(frame));
-                frame_queue_cond_.notify_one();
-            }
-        } catch(std::exception & e) {
-            std::cerr << "Error: " << e.what() << std::endl;
+        capture_.set(cv::CAP_PROP_FPS, config_.fps);
+        capture_.set(cv::CAP_PROP_FRAME_WIDTH, config_.width);
+        capture_.set(cv::CAP_PROP_FRAME_HEIGHT, config_.height);
+        if(capture_.isOpened()) {
+            width_  = capture_.get(cv::CAP_PROP_FRAME_WIDTH);
+            height_ = capture_.get(cv::CAP_PROP_FRAME_HEIGHT);
         }
-    };
+    }
 }
 
-void Camera::start()
+bool Camera::read_frame(Frame & frame)
 {
-    is_running_     = true;
-    capture_thread_ = std::thread(capture_thread_fn_);
+    TRACE_SCOPE(TraceStage::CAMERA_CAPTURE);
+
+    if(v4l2_.is_opened()) {
+        return v4l2_.read(frame) == 0;
+    }
+
+    frame.image = std::make_shared<cv::Mat>();
+    capture_ >> *frame.image;
+    if(frame.image->empty()) {
+        return false;
+    }
+    frame.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now().time_since_epoch())
+                             .count();
+    return true;
 }
 
-void Camera::stop()
+void Camera::open_stream()
 {
-    is_running_ = false;
-    capture_thread_.join();
-    while(!frame_queue_.empty()) {
-        frame_queue_.pop();
+    if(v4l2_.is_opened()) {
+        v4l2_.start();
     }
 }
 
-std::shared_ptr<cv::Mat> Camera::get_frame()
+void Camera::close_stream()
 {
-    std::unique_lock<std::mutex> lock(frame_queue_mutex_);
-    frame_queue_cond_.wait(lock, [this]() { return !frame_queue_.empty(); });
-    auto frame = frame_queue_.front();
-    frame_queue_.pop();
-
-    frame_queue_cond_.notify_one();
-
-    return std::move(frame);
-}
\ No newline at end of file
+    if(v4l2_.is_opened()) {
+        v4l2_.stop();
+    }
+}
@@ -0,0 +1,439 @@
+#include "V4l2Capture.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+}
+
+// 按优先顺序尝试的像素格式，BGR24 可以零拷贝
+static const uint32_t v4l2_capture_formats[] = {V4L2_PIX_FMT_BGR24, V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_YUYV};
+
+static int xioctl(int fd, unsigned long request, void * arg)
+{
+    int ret;
+    do {
+        ret = ioctl(fd, request, arg);
+    } while(ret == -1 && errno == EINTR);
+    return ret;
+}
+
+// 与帧共享的采集状态，帧释放时通过它归还缓冲区
+struct V4l2Capture::State {
+    typedef struct {
+        void * start;
+        size_t length;
+        int dma_fd;
+        bool is_held; // 被流水线中的帧引用，不在驱动队列中
+    } buffer_t;
+
+    int fd{-1};
+    bool is_mplane{false};
+    uint32_t buf_type{V4L2_BUF_TYPE_VIDEO_CAPTURE};
+    int width{0};
+    int height{0};
+    uint32_t pixel_format{0};
+    uint32_t bytes_per_line{0};
+
+    std::mutex mutex;
+    std::vector<buffer_t> buffers;
+    bool is_streaming{false};
+    int queued{0};
+
+    // 格式转换的目标图像池
+    std::mutex pool_mutex;
+    std::vector<cv::Mat *> free_mats;
+
+    ~State()
+    {
+        for(auto & buffer : buffers) {
+            if(buffer.dma_fd >= 0) {
+                ::close(buffer.dma_fd);
+            }
+            if(buffer.start != MAP_FAILED) {
+                munmap(buffer.start, buffer.length);
+            }
+        }
+        if(fd >= 0) {
+            ::close(fd);
+        }
+        for(auto mat : free_mats) {
+            delete mat;
+        }
+    }
+
+    // 调用方持有 mutex
+    int queue_buffer_locked(uint32_t index)
+    {
+        struct v4l2_buffer buf;
+        struct v4l2_plane planes[VIDEO_MAX_PLANES];
+        memset(&buf, 0, sizeof(buf));
+        memset(planes, 0, sizeof(planes));
+        buf.type   = buf_type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index  = index;
+        if(is_mplane) {
+            buf.m.planes = planes;
+            buf.length   = 1;
+        }
+
+        if(xioctl(fd, VIDIOC_QBUF, &buf) < 0) {
+            perror("VIDIOC_QBUF");
+            return -1;
+        }
+        queued++;
+        return 0;
+    }
+
+    void release_buffer(uint32_t index)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers[index].is_held = false;
+        if(is_streaming) {
+            queue_buffer_locked(index);
+        }
+    }
+
+    std::shared_ptr<cv::Mat> acquire_mat(const std::shared_ptr<State> & self)
+    {
+        cv::Mat * mat = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            if(!free_mats.empty()) {
+                mat = free_mats.back();
+                free_mats.pop_back();
+            }
+        }
+        if(mat == nullptr) {
+            mat = new cv::Mat(height, width, CV_8UC3);
+        }
+
+        return std::shared_ptr<cv::Mat>(mat, [self](cv::Mat * mat) {
+            std::lock_guard<std::mutex> lock(self->pool_mutex);
+            self->free_mats.push_back(mat);
+        });
+    }
+};
+
+V4l2Capture::V4l2Capture()
+{}
+
+V4l2Capture::~V4l2Capture()
+{
+    close();
+}
+
+int V4l2Capture::open(const char * device, int width, int height, int fps, int buffer_count)
+{
+    close();
+
+    auto state = std::make_shared<State>();
+    state->fd  = ::open(device, O_RDWR | O_NONBLOCK);
+    if(state->fd < 0) {
+        perror(device);
+        return -1;
+    }
+
+    struct v4l2_capability cap;
+    memset(&cap, 0, sizeof(cap));
+    if(xioctl(state->fd, VIDIOC_QUERYCAP, &cap) < 0) {
+        perror("VIDIOC_QUERYCAP");
+        return -1;
+    }
+    uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if(!(caps & V4L2_CAP_STREAMING)) {
+        std::cerr << device << " does not support streaming" << std::endl;
+        return -1;
+    }
+    if(caps & V4L2_CAP_VIDEO_CAPTURE_MPLANE) {
+        state->is_mplane = true;
+        state->buf_type  = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    } else if(!(caps & V4L2_CAP_VIDEO_CAPTURE)) {
+        std::cerr << device << " is not a capture device" << std::endl;
+        return -1;
+    }
+
+    // 依次尝试支持的像素格式，驱动会把不支持的格式改成它支持的格式
+    for(uint32_t pixel_format : v4l2_capture_formats) {
+        struct v4l2_format fmt;
+        memset(&fmt, 0, sizeof(fmt));
+        fmt.type = state->buf_type;
+        if(state->is_mplane) {
+            fmt.fmt.pix_mp.width       = width;
+            fmt.fmt.pix_mp.height      = height;
+            fmt.fmt.pix_mp.pixelformat = pixel_format;
+            fmt.fmt.pix_mp.field       = V4L2_FIELD_ANY;
+            fmt.fmt.pix_mp.num_planes  = 1;
+        } else {
+            fmt.fmt.pix.width       = width;
+            fmt.fmt.pix.height      = height;
+            fmt.fmt.pix.pixelformat = pixel_format;
+            fmt.fmt.pix.field       = V4L2_FIELD_ANY;
+        }
+        if(xioctl(state->fd, VIDIOC_S_FMT, &fmt) < 0) {
+            continue;
+        }
+
+        if(state->is_mplane) {
+            if(fmt.fmt.pix_mp.pixelformat != pixel_format || fmt.fmt.pix_mp.num_planes != 1) {
+                continue;
+            }
+            state->width          = fmt.fmt.pix_mp.width;
+            state->height         = fmt.fmt.pix_mp.height;
+            state->bytes_per_line = fmt.fmt.pix_mp.plane_fmt[0].bytesperline;
+        } else {
+            if(fmt.fmt.pix.pixelformat != pixel_format) {
+                continue;
+            }
+            state->width          = fmt.fmt.pix.width;
+            state->height         = fmt.fmt.pix.height;
+            state->bytes_per_line = fmt.fmt.pix.bytesperline;
+        }
+        state->pixel_format = pixel_format;
+        break;
+    }
+    if(state->pixel_format == 0) {
+        std::cerr << device << ": no supported pixel format (BGR24/NV12/YUYV)" << std::endl;
+        return -1;
+    }
+
+    // 帧率设置失败时使用驱动默认帧率
+    struct v4l2_streamparm parm;
+    memset(&parm, 0, sizeof(parm));
+    parm.type                                  = state->buf_type;
+    parm.parm.capture.timeperframe.numerator   = 1;
+    parm.parm.capture.timeperframe.denominator = fps;
+    xioctl(state->fd, VIDIOC_S_PARM, &parm);
+
+    struct v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.count  = buffer_count;
+    req.type   = state->buf_type;
+    req.memory = V4L2_MEMORY_MMAP;
+    if(xioctl(state->fd, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+        perror("VIDIOC_REQBUFS");
+        return -1;
+    }
+
+    for(uint32_t i = 0; i < req.count; i++) {
+        struct v4l2_buffer buf;
+        struct v4l2_plane planes[VIDEO_MAX_PLANES];
+        memset(&buf, 0, sizeof(buf));
+        memset(planes, 0, sizeof(planes));
+        buf.type   = state->buf_type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index  = i;
+        if(state->is_mplane) {
+            buf.m.planes = planes;
+            buf.length   = 1;
+        }
+        if(xioctl(state->fd, VIDIOC_QUERYBUF, &buf) < 0) {
+            perror("VIDIOC_QUERYBUF");
+            return -1;
+        }
+
+        State::buffer_t buffer;
+        buffer.length  = state->is_mplane ? planes[0].length : buf.length;
+        off_t offset   = state->is_mplane ? planes[0].m.mem_offset : buf.m.offset;
+        buffer.start   = mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, state->fd, offset);
+        buffer.dma_fd  = -1;
+        buffer.is_held = false;
+        state->buffers.push_back(buffer);
+        if(buffer.start == MAP_FAILED) {
+            perror("mmap");
+            return -1;
+        }
+
+        // 导出 DMABUF，供 RGA/NPU 直接导入，驱动不支持时只使用 mmap
+        struct v4l2_exportbuffer expbuf;
+        memset(&expbuf, 0, sizeof(expbuf));
+        expbuf.type  = state->buf_type;
+        expbuf.index = i;
+        expbuf.plane = 0;
+        expbuf.flags = O_RDWR | O_CLOEXEC;
+        if(xioctl(state->fd, VIDIOC_EXPBUF, &expbuf) == 0) {
+            state->buffers.back().dma_fd = expbuf.fd;
+        }
+    }
+
+    state_ = std::move(state);
+    return 0;
+}
+
+void V4l2Capture::close()
+{
+    if(!state_) {
+        return;
+    }
+    stop();
+    // 仍被帧引用的缓冲区在最后一帧释放时才解除映射
+    state_.reset();
+}
+
+bool V4l2Capture::is_opened()
+{
+    return state_ != nullptr;
+}
+
+int V4l2Capture::start()
+{
+    if(!state_) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if(state_->is_streaming) {
+        return 0;
+    }
+    // 上次停止时仍被引用的缓冲区在释放时才入队
+    for(uint32_t i = 0; i < state_->buffers.size(); i++) {
+        if(!state_->buffers[i].is_held && state_->queue_buffer_locked(i) != 0) {
+            return -1;
+        }
+    }
+
+    int type = state_->buf_type;
+    if(xioctl(state_->fd, VIDIOC_STREAMON, &type) < 0) {
+        perror("VIDIOC_STREAMON");
+        return -1;
+    }
+    state_->is_streaming = true;
+    return 0;
+}
+
+int V4l2Capture::stop()
+{
+    if(!state_) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if(!state_->is_streaming) {
+        return 0;
+    }
+    state_->is_streaming = false;
+    state_->queued       = 0;
+
+    // STREAMOFF 会把驱动队列中的缓冲区全部取回
+    int type = state_->buf_type;
+    if(xioctl(state_->fd, VIDIOC_STREAMOFF, &type) < 0) {
+        perror("VIDIOC_STREAMOFF");
+        return -1;
+    }
+    return 0;
+}
+
+int V4l2Capture::read(Frame & frame)
+{
+    if(!state_) {
+        return -1;
+    }
+    State & state = *state_;
+
+    struct pollfd pfd;
+    pfd.fd     = state.fd;
+    pfd.events = POLLIN;
+    int ret;
+    do {
+        ret = poll(&pfd, 1, V4L2_CAPTURE_TIMEOUT_MS);
+    } while(ret == -1 && errno == EINTR);
+    if(ret <= 0) {
+        std::cerr << "V4l2Capture: wait frame " << (ret == 0 ? "timeout" : strerror(errno)) << std::endl;
+        return -1;
+    }
+
+    struct v4l2_buffer buf;
+    struct v4l2_plane planes[VIDEO_MAX_PLANES];
+    memset(&buf, 0, sizeof(buf));
+    memset(planes, 0, sizeof(planes));
+    buf.type   = state.buf_type;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if(state.is_mplane) {
+        buf.m.planes = planes;
+        buf.length   = 1;
+    }
+
+    bool is_zero_copy;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if(xioctl(state.fd, VIDIOC_DQBUF, &buf) < 0) {
+            perror("VIDIOC_DQBUF");
+            return -1;
+        }
+        state.queued--;
+
+        // 驱动中剩余的缓冲区太少时复制一份，立即归还缓冲区
+        is_zero_copy = state.pixel_format == V4L2_PIX_FMT_BGR24 && state.queued >= V4L2_CAPTURE_MIN_QUEUED;
+        state.buffers[buf.index].is_held = is_zero_copy;
+    }
+
+    if(buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+        frame.timestamp_us = (int64_t)buf.timestamp.tv_sec * 1000000 + buf.timestamp.tv_usec;
+    } else {
+        frame.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch())
+                                 .count();
+    }
+
+    uint32_t index = buf.index;
+    auto & buffer  = state.buffers[index];
+
+    if(is_zero_copy) {
+        std::shared_ptr<State> self = state_;
+        frame.image = std::shared_ptr<cv::Mat>(
+            new cv::Mat(state.height, state.width, CV_8UC3, buffer.start, state.bytes_per_line),
+            [self, index](cv::Mat * mat) {
+                delete mat;
+                self->release_buffer(index);
+            });
+        frame.dma_fd = buffer.dma_fd;
+        return 0;
+    }
+
+    frame.image  = state.acquire_mat(state_);
+    frame.dma_fd = -1;
+    switch(state.pixel_format) {
+        case V4L2_PIX_FMT_BGR24:
+            cv::Mat(state.height, state.width, CV_8UC3, buffer.start, state.bytes_per_line).copyTo(*frame.image);
+            break;
+        case V4L2_PIX_FMT_NV12:
+            cv::cvtColor(cv::Mat(state.height * 3 / 2, state.width, CV_8UC1, buffer.start, state.bytes_per_line),
+                         *frame.image, cv::COLOR_YUV2BGR_NV12);
+            break;
+        case V4L2_PIX_FMT_YUYV:
+            cv::cvtColor(cv::Mat(state.height, state.width, CV_8UC2, buffer.start, state.bytes_per_line),
+                         *frame.image, cv::COLOR_YUV2BGR_YUYV);
+            break;
+    }
+    state.release_buffer(index);
+    return 0;
+}
+
+int V4l2Capture::get_width()
+{
+    return state_ ? state_->width : 0;
+}
+
+int V4l2Capture::get_height()
+{
+    return state_ ? state_->height : 0;
+}
+
+uint32_t V4l2Capture::get_pixel_format()
+{
+    return state_ ? state_->pixel_format : 0;
+}
+
+bool V4l2Capture::is_zero_copy()
+{
+    return state_ && state_->pixel_format == V4L2_PIX_FMT_BGR24;
+}
@@ -0,0 +1,276 @@
+#include "CameraManager.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+CameraManager::CameraManager(const std::vector<camera_config_t> & configs)
+{
+    for(size_t i = 0; i < configs.size(); i++) {
+        auto stream    = std::make_unique<Stream>();
+        if(configs[i].device.compare(0, 5, "/dev/") == 0) {
+            stream->source = std::make_unique<Camera>(configs[i], i);
+        } else {
+            stream->source = std::make_unique<FileSource>(configs[i].device, i);
+        }
+        stream->source->set_frame_callback([this]() {
+            std::lock_guard<std::mutex> lock(frame_mutex_);
+            frame_signal_++;
+            frame_cond_.notify_one();
+        });
+        streams_.push_back(std::move(stream));
+    }
+}
+
+std::vector<camera_config_t> CameraManager::load_config()
+{
+    std::vector<camera_config_t> configs;
+
+    const char * env = getenv(CAMERA_MANAGER_DEVICES_ENV);
+    if(env == nullptr || *env == '\0') {
+        configs.push_back(camera_config_t());
+        return configs;
+    }
+
+    std::stringstream devices(env);
+    std::string item;
+    while(std::getline(devices, item, ',')) {
+        if(item.empty()) {
+            continue;
+        }
+        if(configs.size() == RKNN_POOL_MAX_STREAMS) {
+            std::cerr << "CameraManager: at most " << RKNN_POOL_MAX_STREAMS << " cameras, ignore " << item
+                      << std::endl;
+            continue;
+        }
+
+        camera_config_t config;
+        // 网络地址本身带有 ':'，只把最后一个 ':' 之后形如 宽x高[@帧率] 的部分当作尺寸
+        auto pos = item.rfind(':');
+        if(pos != std::string::npos && item.find_first_not_of("0123456789x@", pos + 1) != std::string::npos) {
+            pos = std::string::npos;
+        }
+        config.device = item.substr(0, pos);
+        if(pos != std::string::npos) {
+            int width = 0, height = 0, fps = 0;
+            int count = sscanf(item.c_str() + pos + 1, "%dx%d@%d", &width, &height, &fps);
+            if(count >= 2 && width > 0 && height > 0) {
+                config.width  = width;
+                config.height = height;
+            } else {
+                std::cerr << "CameraManager: invalid size in " << item << ", use default" << std::endl;
+            }
+            if(count == 3 && fps > 0) {
+                config.fps = fps;
+            }
+        }
+        configs.push_back(config);
+    }
+
+    if(configs.empty()) {
+        configs.push_back(camera_config_t());
+    }
+    return configs;
+}
+
+int CameraManager::size()
+{
+    return streams_.size();
+}
+
+FrameSource & CameraManager::get_source(int stream_id)
+{
+    return *streams_[stream_id]->source;
+}
+
+void CameraManager::init_image_process(int model_size)
+{
+    for(auto & stream : streams_) {
+        if(stream->image_process) {
+            continue;
+        }
+        stream->image_process = std::make_unique<ImageProcess>(stream->source->get_width(),
+                                                               stream->source->get_height(), model_size);
+    }
+}
+
+ImageProcess & CameraManager::get_image_process(int stream_id)
+{
+    return *streams_[stream_id]->image_process;
+}
+
+void CameraManager::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        for(auto & stream : streams_) {
+            stream->capture_base = stream->source->get_stats();
+            stream->submitted    = 0;
+            stream->completed    = 0;
+            stream->latencies_ms.clear();
+        }
+        start_time_       = std::chrono::steady_clock::now();
+        last_report_time_ = start_time_;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex_);
+        is_running_  = true;
+        next_stream_ = 0;
+    }
+
+    for(auto & stream : streams_) {
+        stream->source->start();
+    }
+}
+
+void CameraManager::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex_);
+        is_running_ = false;
+    }
+    frame_cond_.notify_all();
+
+    for(auto & stream : streams_) {
+        stream->source->stop();
+    }
+    print_stats();
+}
+
+bool CameraManager::next_frame(Frame & frame, int timeout_ms)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    int count     = streams_.size();
+
+    std::unique_lock<std::mutex> lock(frame_mutex_);
+    while(is_running_) {
+        // 持有 frame_mutex_ 时记下信号，之后写入的帧一定会改变它，不会漏掉唤醒
+        uint64_t signal = frame_signal_;
+
+        for(int i = 0; i < count; i++) {
+            int stream_id = (next_stream_ + i) % count;
+            if(streams_[stream_id]->source->try_get_frame(frame)) {
+                next_stream_ = (stream_id + 1) % count;
+
+                std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+                streams_[stream_id]->submitted++;
+                return true;
+            }
+        }
+
+        if(!frame_cond_.wait_until(lock, deadline, [&]() { return frame_signal_ != signal || !is_running_; })) {
+            return false;
+        }
+    }
+    return false;
+}
+
+void CameraManager::record_result(const Frame & frame)
+{
+    int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now().time_since_epoch())
+                         .count();
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    auto & stream = streams_[frame.stream_id];
+    stream->completed++;
+    stream->latencies_ms.push_back((now_us - frame.timestamp_us) / 1000.0);
+    if(stream->latencies_ms.size() > CAMERA_MANAGER_LATENCY_SAMPLES) {
+        stream->latencies_ms.pop_front();
+    }
+}
+
+void CameraManager::drain_results(SecurityRknnPool & pool)
+{
+    for(int stream_id = 0; stream_id < (int)streams_.size(); stream_id++) {
+        if(stream_id == CAMERA_MANAGER_PRIMARY_STREAM) {
+            continue;
+        }
+
+        Frame frame;
+        while(pool.get_result(stream_id, frame)) {
+            record_result(frame);
+            auto & callback = streams_[stream_id]->result_callback;
+            if(callback) {
+                callback(std::move(frame));
+            }
+            frame = Frame();
+        }
+    }
+
+    report_if_due();
+}
+
+void CameraManager::set_result_callback(int stream_id, std::function<void(Frame)> callback)
+{
+    streams_[stream_id]->result_callback = std::move(callback);
+}
+
+camera_stream_stats_t CameraManager::get_stats(int stream_id)
+{
+    auto & stream = streams_[stream_id];
+    auto capture  = stream->source->get_stats();
+
+    camera_stream_stats_t stats;
+    stats.stream_id = stream_id;
+
+    std::vector<double> latencies;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats.capture.captured  = capture.captured - stream->capture_base.captured;
+        stats.capture.dropped   = capture.dropped - stream->capture_base.dropped;
+        stats.capture.delivered = capture.delivered - stream->capture_base.delivered;
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+        seconds        = std::max(seconds, 1e-3);
+
+        stats.submitted   = stream->submitted;
+        stats.completed   = stream->completed;
+        stats.capture_fps = stats.capture.captured / seconds;
+        stats.result_fps  = stats.completed / seconds;
+        latencies.assign(stream->latencies_ms.begin(), stream->latencies_ms.end());
+    }
+
+    stats.latency_p50_ms = stats.latency_p99_ms = 0;
+    if(!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        stats.latency_p50_ms = latencies[latencies.size() / 2];
+        stats.latency_p99_ms = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+    }
+    return stats;
+}
+
+void CameraManager::print_stats()
+{
+    for(int stream_id = 0; stream_id < (int)streams_.size(); stream_id++) {
+        auto stats = get_stats(stream_id);
+        printf("CameraManager: stream %d %-14s capture %5.1ffps dropped %-6llu infer %5.1ffps (%llu/%llu) "
+               "latency p50 %6.1fms p99 %6.1fms\n",
+               stream_id, streams_[stream_id]->source->get_name().c_str(), stats.capture_fps,
+               (unsigned long long)stats.capture.dropped, stats.result_fps, (unsigned long long)stats.completed,
+               (unsigned long long)stats.submitted, stats.latency_p50_ms, stats.latency_p99_ms);
+    }
+}
+
+void CameraManager::report_if_due()
+{
+    static const int interval_ms = [] {
+        const char * env = getenv(CAMERA_MANAGER_REPORT_INTERVAL_ENV);
+        return env ? atoi(env) : 0;
+    }();
+    if(interval_ms <= 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        auto now = std::chrono::steady_clock::now();
+        if(now - last_report_time_ < std::chrono::milliseconds(interval_ms)) {
+            return;
+        }
+        last_report_time_ = now;
+    }
+    print_stats();
+}
@@ -0,0 +1,66 @@
+#include "Executor.hpp"
+#include <cstdio>
+#include <exception>
+#include <iostream>
+
+Executor & Executor::instance()
+{
+    static Executor executor;
+    return executor;
+}
+
+Executor::Executor()
+{
+    const char * names[]   = {"io", "ui", "npu"};
+    const size_t threads[] = {EXECUTOR_IO_THREADS, EXECUTOR_UI_THREADS, EXECUTOR_NPU_THREADS};
+
+    for(int i = 0; i < (int)ExecutorQueue::COUNT; i++) {
+        queues_[i].name = names[i];
+        queues_[i].pool = std::make_unique<ThreadPool>(threads[i]);
+    }
+}
+
+void Executor::post(ExecutorQueue queue, std::function<void()> task)
+{
+    Queue & target = queues_[(int)queue];
+    target.submitted++;
+
+    // 不保留 future，避免析构时等待任务结束
+    target.pool->enqueue([&target, task = std::move(task)]() {
+        target.running++;
+        try {
+            task();
+        } catch(std::exception & e) {
+            std::cout << "Executor---" << target.name << ": " << e.what() << std::endl;
+        }
+        target.running--;
+        target.completed++;
+    });
+}
+
+executor_metrics_t Executor::metrics()
+{
+    executor_metrics_t metrics;
+    metrics.threads_created = ThreadPool::threads_created();
+    for(int i = 0; i < (int)ExecutorQueue::COUNT; i++) {
+        auto & queue = queues_[i];
+
+        metrics.queues[i].name      = queue.name;
+        metrics.queues[i].threads   = queue.pool->size();
+        metrics.queues[i].pending   = queue.pool->pending();
+        metrics.queues[i].running   = queue.running;
+        metrics.queues[i].submitted = queue.submitted;
+        metrics.queues[i].completed = queue.completed;
+    }
+    return metrics;
+}
+
+void Executor::print_metrics()
+{
+    auto metrics = this->metrics();
+    printf("executor: threads_created=%zu\n", metrics.threads_created);
+    for(auto & queue : metrics.queues) {
+        printf("  %-4s threads=%zu pending=%zu running=%zu submitted=%zu completed=%zu\n", queue.name, queue.threads,
+               queue.pending, queue.running, queue.submitted, queue.completed);
+    }
+}
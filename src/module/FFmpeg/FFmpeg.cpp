@@ -1,4 +1,5 @@
 #include "FFmpeg.hpp"
+#include "Trace.hpp"
 #include <iostream>
 #include <libavformat/avformat.h>
 #include <thread>
@@ -131,7 +132,10 @@ void FFmpeg::start_process_frame()
 
                 frame_->pts = origin_rtsp_pts_++;
 
-                ret_ = avcodec_send_frame(rk_encodec_ctx_, frame_);
+                {
+                    TRACE_SCOPE(TraceStage::ENCODE_SEND_FRAME);
+                    ret_ = avcodec_send_frame(rk_encodec_ctx_, frame_);
+                }
                 if(ret_ < 0) {
                     throw std::runtime_error("Error sending a frame for encoding");
                 }
@@ -165,7 +169,10 @@ void FFmpeg::start_process_frame()
                         // std::cout << "cloned_packet->pts: " << cloned_packet->pts
                         //           << ", cloned_packet->dts: " << cloned_packet->dts << std::endl;
 
-                        ret_ = av_interleaved_write_frame(mp4_out_fmt_ctx_, cloned_packet);
+                        {
+                            TRACE_SCOPE(TraceStage::ENCODE_WRITE_FRAME);
+                            ret_ = av_interleaved_write_frame(mp4_out_fmt_ctx_, cloned_packet);
+                        }
                         if(ret_ < 0) {
                             char errbuf[AV_ERROR_MAX_STRING_SIZE];
                             av_strerror(ret_, errbuf, sizeof(errbuf));
@@ -188,7 +195,10 @@ void FFmpeg::start_process_frame()
                     // std::cout << "hevc_pkt->pts: " << hevc_pkt_->pts << ", hevc_pkt->dts: " << hevc_pkt_->dts
                     //           << std::endl;
 
-                    ret_ = av_interleaved_write_frame(rtsp_out_fmt_ctx_, hevc_pkt_);
+                    {
+                        TRACE_SCOPE(TraceStage::ENCODE_WRITE_FRAME);
+                        ret_ = av_interleaved_write_frame(rtsp_out_fmt_ctx_, hevc_pkt_);
+                    }
 
                     if(ret_ < 0) {
                         char errbuf[AV_ERROR_MAX_STRING_SIZE];
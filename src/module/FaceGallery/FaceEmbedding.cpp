@@ -0,0 +1,219 @@
+#include "FaceEmbedding.hpp"
+#include "Float16.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static_assert(FACE_GALLERY_DIM % 16 == 0, "face embedding kernels process 16 elements per iteration");
+
+FaceEmbeddingPrecision face_embedding_precision_from_env()
+{
+    const char * env = getenv(FACE_GALLERY_PRECISION_ENV);
+    if(env != nullptr && strcmp(env, "fp16") == 0) {
+        return FaceEmbeddingPrecision::FP16;
+    }
+    if(env != nullptr && strcmp(env, "int8") == 0) {
+        return FaceEmbeddingPrecision::INT8;
+    }
+    return FaceEmbeddingPrecision::FP32;
+}
+
+const char * face_embedding_precision_name(FaceEmbeddingPrecision precision)
+{
+    switch(precision) {
+        case FaceEmbeddingPrecision::FP16: return "fp16";
+        case FaceEmbeddingPrecision::INT8: return "int8";
+        default: return "fp32";
+    }
+}
+
+size_t face_embedding_row_bytes(FaceEmbeddingPrecision precision)
+{
+    switch(precision) {
+        case FaceEmbeddingPrecision::FP16: return FACE_GALLERY_DIM * sizeof(uint16_t);
+        case FaceEmbeddingPrecision::INT8: return FACE_GALLERY_DIM * sizeof(int8_t);
+        default: return FACE_GALLERY_DIM * sizeof(float);
+    }
+}
+
+float face_embedding_dot(const float * a, const float * b)
+{
+#if defined(__ARM_NEON)
+    // 四组累加器，隐藏 FMA 的延迟
+    float32x4_t sum0 = vdupq_n_f32(0);
+    float32x4_t sum1 = vdupq_n_f32(0);
+    float32x4_t sum2 = vdupq_n_f32(0);
+    float32x4_t sum3 = vdupq_n_f32(0);
+    for(int i = 0; i < FACE_GALLERY_DIM; i += 16) {
+        sum0 = vfmaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+        sum1 = vfmaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        sum2 = vfmaq_f32(sum2, vld1q_f32(a + i + 8), vld1q_f32(b + i + 8));
+        sum3 = vfmaq_f32(sum3, vld1q_f32(a + i + 12), vld1q_f32(b + i + 12));
+    }
+    return vaddvq_f32(vaddq_f32(vaddq_f32(sum0, sum1), vaddq_f32(sum2, sum3)));
+#else
+    float sum[16] = {0};
+    for(int i = 0; i < FACE_GALLERY_DIM; i += 16) {
+        for(int k = 0; k < 16; k++) {
+            sum[k] += a[i + k] * b[i + k];
+        }
+    }
+    float total = 0;
+    for(int k = 0; k < 16; k++) {
+        total += sum[k];
+    }
+    return total;
+#endif
+}
+
+#if !defined(__ARM_NEON)
+// 乘 2^112 修正指数偏移，非规格化数也能正确转换；单位向量的分量不会是 inf/nan，不需要单独处理，循环可以向量化
+static inline float fp16_to_fp32(uint16_t h)
+{
+    uint32_t bits = (uint32_t)(h & 0x7fff) << 13;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    value *= 0x1p112f;
+    memcpy(&bits, &value, sizeof(bits));
+    bits |= (uint32_t)(h & 0x8000) << 16;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+#endif
+
+// 查询保持 fp32，图库行读入后转换为 fp32 再乘加，内存读取量是 fp32 的一半
+float face_embedding_dot_fp16(const float * a, const uint16_t * b)
+{
+#if defined(__ARM_NEON)
+    float32x4_t sum0 = vdupq_n_f32(0);
+    float32x4_t sum1 = vdupq_n_f32(0);
+    float32x4_t sum2 = vdupq_n_f32(0);
+    float32x4_t sum3 = vdupq_n_f32(0);
+    for(int i = 0; i < FACE_GALLERY_DIM; i += 16) {
+        float16x8_t b0 = vreinterpretq_f16_u16(vld1q_u16(b + i));
+        float16x8_t b1 = vreinterpretq_f16_u16(vld1q_u16(b + i + 8));
+        sum0           = vfmaq_f32(sum0, vld1q_f32(a + i), vcvt_f32_f16(vget_low_f16(b0)));
+        sum1           = vfmaq_f32(sum1, vld1q_f32(a + i + 4), vcvt_high_f32_f16(b0));
+        sum2           = vfmaq_f32(sum2, vld1q_f32(a + i + 8), vcvt_f32_f16(vget_low_f16(b1)));
+        sum3           = vfmaq_f32(sum3, vld1q_f32(a + i + 12), vcvt_high_f32_f16(b1));
+    }
+    return vaddvq_f32(vaddq_f32(vaddq_f32(sum0, sum1), vaddq_f32(sum2, sum3)));
+#else
+    float sum[16] = {0};
+    for(int i = 0; i < FACE_GALLERY_DIM; i += 16) {
+        for(int k = 0; k < 16; k++) {
+            sum[k] += a[i + k] * fp16_to_fp32(b[i + k]);
+        }
+    }
+    float total = 0;
+    for(int k = 0; k < 16; k++) {
+        total += sum[k];
+    }
+    return total;
+#endif
+}
+
+int32_t face_embedding_dot_int8(const int8_t * a, const int8_t * b)
+{
+#if defined(__ARM_FEATURE_DOTPROD)
+    // RK3588 的 A76/A55 支持 SDOT，每条指令完成 16 个乘加
+    int32x4_t sum0 = vdupq_n_s32(0);
+    int32x4_t sum1 = vdupq_n_s32(0);
+    for(int i = 0; i < FACE_GALLERY_DIM; i += 32) {
+        sum0 = vdotq_s32(sum0, vld1q_s8(a + i), vld1q_s8(b + i));
+        sum1 = vdotq_s32(sum1, vld1q_s8(a + i + 16), vld1q_s8(b + i + 16));
+    }
+    return vaddvq_s32(vaddq_s32(sum0, sum1));
+#elif defined(__ARM_NEON)
+    int32x4_t sum = vdupq_n_s32(0);
+    for(int i = 0; i < FACE_GALLERY_DIM; i += 16) {
+        int8x16_t va = vld1q_s8(a + i);
+        int8x16_t vb = vld1q_s8(b + i);
+        sum          = vpadalq_s16(sum, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+        sum          = vpadalq_s16(sum, vmull_high_s8(va, vb));
+    }
+    return vaddvq_s32(sum);
+#else
+    int32_t sum = 0;
+    for(int i = 0; i < FACE_GALLERY_DIM; i++) {
+        sum += (int32_t)a[i] * b[i];
+    }
+    return sum;
+#endif
+}
+
+bool face_embedding_normalize(const float * embedding, float * normalized)
+{
+    float norm = std::sqrt(face_embedding_dot(embedding, embedding));
+    if(norm == 0 || !std::isfinite(norm)) {
+        return false;
+    }
+    float scale = 1.0f / norm;
+    for(int i = 0; i < FACE_GALLERY_DIM; i++) {
+        normalized[i] = embedding[i] * scale;
+    }
+    return true;
+}
+
+// 对称量化，最大绝对值映射到 127，返回缩放系数
+static float quantize_int8(const float * normalized, int8_t * quantized)
+{
+    float max_abs = 0;
+    for(int i = 0; i < FACE_GALLERY_DIM; i++) {
+        max_abs = std::max(max_abs, std::fabs(normalized[i]));
+    }
+    float scale = max_abs > 0 ? max_abs / 127 : 1;
+    for(int i = 0; i < FACE_GALLERY_DIM; i++) {
+        quantized[i] = (int8_t)std::lround(normalized[i] / scale);
+    }
+    return scale;
+}
+
+float face_embedding_encode(FaceEmbeddingPrecision precision, const float * normalized, uint8_t * row)
+{
+    switch(precision) {
+        case FaceEmbeddingPrecision::FP16:
+            for(int i = 0; i < FACE_GALLERY_DIM; i++) {
+                ((uint16_t *)row)[i] = rknpu2::float16::bits(normalized[i]);
+            }
+            return 1;
+        case FaceEmbeddingPrecision::INT8:
+            return quantize_int8(normalized, (int8_t *)row);
+        default:
+            memcpy(row, normalized, FACE_GALLERY_DIM * sizeof(float));
+            return 1;
+    }
+}
+
+void face_query_init(FaceEmbeddingPrecision precision, const float * normalized, face_query_t & query)
+{
+    memcpy(query.fp32, normalized, sizeof(query.fp32));
+    query.scale = precision == FaceEmbeddingPrecision::INT8 ? quantize_int8(normalized, query.int8) : 1;
+}
+
+void face_query_from_row(const face_embedding_matrix_t & matrix, int row, face_query_t & query)
+{
+    const uint8_t * data = matrix.data + (size_t)row * face_embedding_row_bytes(matrix.precision);
+    switch(matrix.precision) {
+        case FaceEmbeddingPrecision::FP16:
+            for(int i = 0; i < FACE_GALLERY_DIM; i++) {
+                query.fp32[i] = rknpu2::float16::fromBits(((const uint16_t *)data)[i]);
+            }
+            query.scale = 1;
+            break;
+        case FaceEmbeddingPrecision::INT8:
+            // 已经是量化后的数据，直接复制
+            memcpy(query.int8, data, sizeof(query.int8));
+            query.scale = matrix.scales[row];
+            break;
+        default:
+            memcpy(query.fp32, data, sizeof(query.fp32));
+            query.scale = 1;
+            break;
+    }
+}
@@ -0,0 +1,181 @@
+#include "FaceGallery.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+FaceGalleryIndex face_gallery_index_from_env()
+{
+    const char * env = getenv(FACE_GALLERY_INDEX_ENV);
+    if(env != nullptr && strcmp(env, "hnsw") == 0) {
+        return FaceGalleryIndex::HNSW;
+    }
+    return FaceGalleryIndex::EXACT;
+}
+
+FaceGallery::FaceGallery(FaceGalleryIndex index, FaceEmbeddingPrecision precision)
+    : precision_(precision), row_bytes_(face_embedding_row_bytes(precision))
+{
+    reserve(FACE_GALLERY_INITIAL_CAPACITY);
+    if(index == FaceGalleryIndex::HNSW) {
+        hnsw_            = std::make_unique<FaceHnswIndex>();
+        const char * env = getenv(FACE_GALLERY_HNSW_EF_ENV);
+        if(env != nullptr && atoi(env) > 0) {
+            hnsw_ef_ = atoi(env);
+        }
+    }
+}
+
+FaceGallery::~FaceGallery()
+{
+    free(data_);
+}
+
+void FaceGallery::reserve(int capacity)
+{
+    auto data = (uint8_t *)aligned_alloc(FACE_GALLERY_ALIGNMENT, (size_t)capacity * row_bytes_);
+    if(data == nullptr) {
+        throw std::bad_alloc();
+    }
+    if(data_ != nullptr) {
+        memcpy(data, data_, (size_t)size_ * row_bytes_);
+        free(data_);
+    }
+    data_     = data;
+    capacity_ = capacity;
+}
+
+int FaceGallery::add(const float * embedding)
+{
+    alignas(FACE_GALLERY_ALIGNMENT) float normalized[FACE_GALLERY_DIM];
+    if(!face_embedding_normalize(embedding, normalized)) {
+        return -1;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if(size_ == capacity_) {
+        reserve(capacity_ * 2);
+    }
+    scales_.push_back(face_embedding_encode(precision_, normalized, data_ + (size_t)size_ * row_bytes_));
+    is_removed_.push_back(0);
+    if(hnsw_) {
+        hnsw_->insert(get_matrix(), size_);
+    }
+    return size_++;
+}
+
+bool FaceGallery::remove(int id)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if(id < 0 || id >= size_ || is_removed_[id]) {
+        return false;
+    }
+    is_removed_[id] = 1;
+    removed_count_++;
+    if(hnsw_) {
+        hnsw_->remove(id);
+    }
+    return true;
+}
+
+int FaceGallery::size()
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return size_ - removed_count_;
+}
+
+void FaceGallery::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    size_          = 0;
+    removed_count_ = 0;
+    scales_.clear();
+    is_removed_.clear();
+    if(hnsw_) {
+        hnsw_->clear();
+    }
+}
+
+face_embedding_matrix_t FaceGallery::get_matrix() const
+{
+    return face_embedding_matrix_t{precision_, data_, scales_.data()};
+}
+
+int FaceGallery::collect_top(const face_query_t & query, int keep, face_match_t * top)
+{
+    auto matrix = get_matrix();
+    if(hnsw_ && size_ - removed_count_ >= FACE_GALLERY_HNSW_MIN_SIZE) {
+        std::vector<face_hnsw_result_t> candidates(keep);
+        int count = hnsw_->search(matrix, query, keep, hnsw_ef_, candidates.data());
+        for(int i = 0; i < count; i++) {
+            float score = candidates[i].first;
+            top[i]      = face_match_t{candidates[i].second, score, 0, score > FACE_GALLERY_MATCH_THRESHOLD};
+        }
+        return count;
+    }
+
+    // 按分数从高到低插入排序，keep 通常很小
+    int filled = 0;
+    for(int i = 0; i < size_; i++) {
+        float score = face_embedding_score(matrix, query, i);
+        if((filled == keep && score <= top[keep - 1].score) || is_removed_[i]) {
+            continue;
+        }
+        int pos = filled < keep ? filled++ : keep - 1;
+        while(pos > 0 && top[pos - 1].score < score) {
+            top[pos] = top[pos - 1];
+            pos--;
+        }
+        top[pos] = face_match_t{i, score, 0, score > FACE_GALLERY_MATCH_THRESHOLD};
+    }
+    return filled;
+}
+
+face_match_t FaceGallery::search(const float * embedding)
+{
+    face_match_t match{-1, -1, 0, false};
+
+    alignas(FACE_GALLERY_ALIGNMENT) float normalized[FACE_GALLERY_DIM];
+    if(!face_embedding_normalize(embedding, normalized)) {
+        return match;
+    }
+    face_query_t query;
+    face_query_init(precision_, normalized, query);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    face_match_t top[2];
+    int count = collect_top(query, 2, top);
+    if(count == 0) {
+        return match;
+    }
+
+    // 单位向量的余弦相似度在 [-1, 1]，只有一个身份时按 -1 计算 margin
+    match        = top[0];
+    match.margin = top[0].score - (count > 1 ? top[1].score : -1);
+    return match;
+}
+
+int FaceGallery::search_top_k(const float * embedding, int k, face_match_t * results)
+{
+    alignas(FACE_GALLERY_ALIGNMENT) float normalized[FACE_GALLERY_DIM];
+    if(k <= 0 || !face_embedding_normalize(embedding, normalized)) {
+        return 0;
+    }
+    face_query_t query;
+    face_query_init(precision_, normalized, query);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    // 多取一名用于计算最后一名的 margin
+    std::vector<face_match_t> top(k + 1);
+    int filled = collect_top(query, k + 1, top.data());
+    int count  = std::min(k, filled);
+
+    for(int i = 0; i < count; i++) {
+        results[i]        = top[i];
+        float next        = i + 1 < filled ? top[i + 1].score : -1;
+        results[i].margin = top[i].score - next;
+    }
+    return count;
+}
@@ -0,0 +1,435 @@
+#include "FaceGalleryStore.hpp"
+#include "Executor.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+static_assert(sizeof(face_gallery_file_header_t) == 64, "face gallery header layout changed");
+static_assert(sizeof(face_gallery_record_t) % 8 == 0, "face gallery records must stay 8-byte aligned");
+
+// 压缩时每次写入的记录数
+#define FACE_GALLERY_COMPACT_BATCH 256
+
+// 与 zlib 相同的 CRC32，启动时要校验整个文件，有 ARMv8 CRC32 指令时使用指令计算
+static uint32_t crc32(const void * data, size_t size)
+{
+#if defined(__ARM_FEATURE_CRC32)
+    auto bytes   = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFF;
+    for(; size >= 8; size -= 8, bytes += 8) {
+        uint64_t value;
+        memcpy(&value, bytes, sizeof(value));
+        crc = __crc32d(crc, value);
+    }
+    for(; size > 0; size--) {
+        crc = __crc32b(crc, *bytes++);
+    }
+    return ~crc;
+#else
+    static const auto table = [] {
+        std::array<uint32_t, 256> table;
+        for(uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for(int k = 0; k < 8; k++) {
+                crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320 : 0);
+            }
+            table[i] = crc;
+        }
+        return table;
+    }();
+
+    auto bytes   = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFF;
+    for(size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+#endif
+}
+
+static uint32_t record_crc(const face_gallery_record_t & record)
+{
+    return crc32((const char *)&record + sizeof(record.crc), sizeof(record) - sizeof(record.crc));
+}
+
+static face_gallery_file_header_t make_header()
+{
+    face_gallery_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FACE_GALLERY_FILE_MAGIC, sizeof(FACE_GALLERY_FILE_MAGIC));
+    header.version     = FACE_GALLERY_FILE_VERSION;
+    header.dim         = FACE_GALLERY_DIM;
+    header.record_size = sizeof(face_gallery_record_t);
+    return header;
+}
+
+static bool is_valid_header(const face_gallery_file_header_t & header)
+{
+    auto expected = make_header();
+    return memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 && header.version == expected.version &&
+           header.dim == expected.dim && header.record_size == expected.record_size;
+}
+
+static bool write_all(int fd, const void * data, size_t size)
+{
+    auto bytes = (const char *)data;
+    while(size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if(written < 0 && errno == EINTR) {
+            continue;
+        }
+        if(written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
+
+// rename 后同步目录，保证断电后新文件名可见
+static void sync_directory(const std::string & path)
+{
+    size_t slash    = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd          = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+std::string FaceGalleryStore::path_from_env()
+{
+    const char * env = getenv(FACE_GALLERY_PATH_ENV);
+    return env ? env : FACE_GALLERY_DEFAULT_PATH;
+}
+
+FaceGalleryStore::FaceGalleryStore(FaceGallery & gallery, std::string path) : gallery_(gallery), path_(std::move(path))
+{}
+
+FaceGalleryStore::~FaceGalleryStore()
+{
+    // 压缩任务在 IO 队列中执行，引用了 this
+    std::unique_lock<std::mutex> lock(mutex_);
+    compact_cond_.wait(lock, [this]() { return !is_compacting_; });
+    if(fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool FaceGalleryStore::create_file()
+{
+    std::string tmp_path = path_ + ".tmp";
+    int fd               = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        perror(tmp_path.c_str());
+        return false;
+    }
+    auto header = make_header();
+    if(!write_all(fd, &header, sizeof(header)) || fdatasync(fd) < 0 || rename(tmp_path.c_str(), path_.c_str()) < 0) {
+        perror(path_.c_str());
+        close(fd);
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    sync_directory(path_);
+
+    fd_        = fd;
+    file_size_ = sizeof(header);
+    return true;
+}
+
+int FaceGalleryStore::add_to_gallery(const face_gallery_record_t & record)
+{
+    int row = gallery_.add(record.embedding);
+    if(row < 0) {
+        return -1;
+    }
+    ids_.push_back(record.id);
+    labels_.emplace_back(record.label, strnlen(record.label, FACE_GALLERY_LABEL_SIZE));
+    rows_[record.id] = row;
+    next_id_         = std::max(next_id_, record.id + 1);
+    return row;
+}
+
+bool FaceGalleryStore::open()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    int fd = ::open(path_.c_str(), O_RDWR | O_CLOEXEC);
+    if(fd < 0) {
+        if(errno != ENOENT) {
+            perror(path_.c_str());
+            return false;
+        }
+        return create_file();
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) < 0) {
+        perror(path_.c_str());
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+
+    void * data = MAP_FAILED;
+    if(size >= sizeof(face_gallery_file_header_t)) {
+        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if(data == MAP_FAILED || !is_valid_header(*(const face_gallery_file_header_t *)data)) {
+        // 无法识别的文件不覆盖，改名保留后重新创建
+        std::string bad_path = path_ + ".bad";
+        std::cout << path_ << ": invalid face gallery, moved to " << bad_path << std::endl;
+        if(data != MAP_FAILED) {
+            munmap(data, size);
+        }
+        close(fd);
+        rename(path_.c_str(), bad_path.c_str());
+        return create_file();
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    auto records = (const face_gallery_record_t *)((const char *)data + sizeof(face_gallery_file_header_t));
+    size_t count = (size - sizeof(face_gallery_file_header_t)) / sizeof(face_gallery_record_t);
+    size_t valid = 0;
+    for(; valid < count; valid++) {
+        auto & record = records[valid];
+        if(record.crc != record_crc(record)) {
+            break;
+        }
+        if(record.type == FACE_GALLERY_RECORD_ADD) {
+            add_to_gallery(record);
+        } else if(record.type == FACE_GALLERY_RECORD_REMOVE) {
+            auto it = rows_.find(record.id);
+            if(it != rows_.end()) {
+                gallery_.remove(it->second);
+                rows_.erase(it);
+                dead_records_++;
+            }
+            dead_records_++;
+        }
+    }
+    munmap(data, size);
+
+    // 写入时断电留下的半条记录，截掉后新记录仍从记录边界开始
+    uint64_t valid_size = sizeof(face_gallery_file_header_t) + valid * sizeof(face_gallery_record_t);
+    if(valid_size < size) {
+        std::cout << path_ << ": dropped " << size - valid_size << " bytes of incomplete records" << std::endl;
+        if(ftruncate(fd, valid_size) < 0 || fdatasync(fd) < 0) {
+            perror(path_.c_str());
+        }
+    }
+
+    fd_        = fd;
+    file_size_ = valid_size;
+    std::cout << "Loaded " << rows_.size() << " faces from " << path_ << std::endl;
+
+    compact_if_needed();
+    return true;
+}
+
+bool FaceGalleryStore::append(face_gallery_record_t & record)
+{
+    record.crc      = record_crc(record);
+    ssize_t written = pwrite(fd_, &record, sizeof(record), file_size_);
+    if(written != (ssize_t)sizeof(record) || fdatasync(fd_) < 0) {
+        perror(path_.c_str());
+        // 去掉可能写了一部分的记录
+        if(ftruncate(fd_, file_size_) < 0) {
+            perror(path_.c_str());
+        }
+        return false;
+    }
+    file_size_ += sizeof(record);
+    return true;
+}
+
+int FaceGalleryStore::enroll(const float * embedding, const char * label)
+{
+    face_gallery_record_t record;
+    memset(&record, 0, sizeof(record));
+    if(!face_embedding_normalize(embedding, record.embedding)) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    record.type      = FACE_GALLERY_RECORD_ADD;
+    record.id        = next_id_;
+    record.timestamp = time(nullptr);
+    if(label != nullptr && label[0] != '\0') {
+        strncpy(record.label, label, FACE_GALLERY_LABEL_SIZE - 1);
+    } else {
+        snprintf(record.label, FACE_GALLERY_LABEL_SIZE, "face_%d", record.id);
+    }
+
+    // 先落盘再加入图库，文件打开失败时只保存在内存中
+    if(fd_ >= 0 && !append(record)) {
+        return -1;
+    }
+    return add_to_gallery(record) < 0 ? -1 : record.id;
+}
+
+bool FaceGalleryStore::remove(int id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = rows_.find(id);
+    if(it == rows_.end()) {
+        return false;
+    }
+
+    face_gallery_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.type      = FACE_GALLERY_RECORD_REMOVE;
+    record.id        = id;
+    record.timestamp = time(nullptr);
+    if(fd_ >= 0 && !append(record)) {
+        return false;
+    }
+
+    gallery_.remove(it->second);
+    rows_.erase(it);
+    dead_records_ += 2;
+    compact_if_needed();
+    return true;
+}
+
+int FaceGalleryStore::get_id(int row)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return row >= 0 && row < (int)ids_.size() ? ids_[row] : -1;
+}
+
+std::string FaceGalleryStore::get_label(int row)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return row >= 0 && row < (int)labels_.size() ? labels_[row] : std::string();
+}
+
+void FaceGalleryStore::compact_if_needed()
+{
+    if(fd_ < 0 || is_compacting_ || dead_records_ < FACE_GALLERY_COMPACT_MIN_DEAD ||
+       dead_records_ <= (int)rows_.size()) {
+        return;
+    }
+    is_compacting_ = true;
+    Executor::instance().post(ExecutorQueue::IO, [this]() {
+        rewrite();
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_compacting_ = false;
+        compact_cond_.notify_all();
+    });
+}
+
+bool FaceGalleryStore::compact()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        compact_cond_.wait(lock, [this]() { return !is_compacting_; });
+        if(fd_ < 0) {
+            return false;
+        }
+        is_compacting_ = true;
+    }
+    bool is_ok = rewrite();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_compacting_ = false;
+    compact_cond_.notify_all();
+    return is_ok;
+}
+
+// 先不加锁复制压缩开始时的有效记录，再加锁补上期间追加的记录并替换文件
+bool FaceGalleryStore::rewrite()
+{
+    int fd;
+    uint64_t end;
+    std::unordered_map<int, int> live;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fd   = fd_;
+        end  = file_size_;
+        live = rows_;
+    }
+
+    void * data = mmap(nullptr, end, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+    madvise(data, end, MADV_SEQUENTIAL);
+
+    std::string tmp_path = path_ + ".tmp";
+    int out              = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(out < 0) {
+        perror(tmp_path.c_str());
+        munmap(data, end);
+        return false;
+    }
+
+    auto header    = make_header();
+    bool is_ok     = write_all(out, &header, sizeof(header));
+    auto records   = (const face_gallery_record_t *)((const char *)data + sizeof(header));
+    size_t count   = (end - sizeof(header)) / sizeof(face_gallery_record_t);
+    uint64_t size  = sizeof(header);
+    size_t pending = 0;
+    std::vector<face_gallery_record_t> batch(FACE_GALLERY_COMPACT_BATCH);
+    for(size_t i = 0; i < count && is_ok; i++) {
+        if(records[i].type != FACE_GALLERY_RECORD_ADD || live.count(records[i].id) == 0) {
+            continue;
+        }
+        batch[pending++] = records[i];
+        if(pending == batch.size()) {
+            is_ok = write_all(out, batch.data(), pending * sizeof(face_gallery_record_t));
+            size += pending * sizeof(face_gallery_record_t);
+            pending = 0;
+        }
+    }
+    if(pending > 0 && is_ok) {
+        is_ok = write_all(out, batch.data(), pending * sizeof(face_gallery_record_t));
+        size += pending * sizeof(face_gallery_record_t);
+    }
+    munmap(data, end);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 压缩期间追加的记录原样复制，其中的删除记录和对应的身份仍算作失效记录
+    int tail_dead = 0;
+    for(uint64_t offset = end; offset < file_size_ && is_ok; offset += sizeof(face_gallery_record_t)) {
+        face_gallery_record_t record;
+        is_ok = pread(fd_, &record, sizeof(record), offset) == (ssize_t)sizeof(record) &&
+                write_all(out, &record, sizeof(record));
+        size += sizeof(record);
+        tail_dead += record.type == FACE_GALLERY_RECORD_REMOVE ? 2 : 0;
+    }
+    if(!is_ok || fdatasync(out) < 0 || rename(tmp_path.c_str(), path_.c_str()) < 0) {
+        perror(tmp_path.c_str());
+        close(out);
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    sync_directory(path_);
+
+    std::cout << "Compacted " << path_ << ": " << file_size_ << " -> " << size << " bytes" << std::endl;
+    close(fd_);
+    fd_           = out;
+    file_size_    = size;
+    dead_records_ = tail_dead;
+    return true;
+}
@@ -0,0 +1,260 @@
+#include "FaceHnsw.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+// 每个线程一份访问标记，按代数区分不同的查询，不需要每次清零
+typedef struct {
+    std::vector<uint32_t> marks;
+    uint32_t generation{0};
+} visited_list_t;
+
+static visited_list_t & get_visited_list(size_t size)
+{
+    thread_local visited_list_t visited;
+    if(visited.marks.size() < size) {
+        visited.marks.resize(size, 0);
+    }
+    if(++visited.generation == 0) {
+        std::fill(visited.marks.begin(), visited.marks.end(), 0);
+        visited.generation = 1;
+    }
+    return visited;
+}
+
+FaceHnswIndex::FaceHnswIndex(int m, int ef_construction)
+    : m_(m), m0_(m * 2), ef_construction_(ef_construction), level_mult_(1 / std::log((double)m)), rng_(100)
+{}
+
+int FaceHnswIndex::random_level()
+{
+    std::uniform_real_distribution<double> distribution(0, 1);
+    double u = 1 - distribution(rng_); // (0, 1]
+    return (int)(-std::log(u) * level_mult_);
+}
+
+int FaceHnswIndex::max_links(int level) const
+{
+    return level == 0 ? m0_ : m_;
+}
+
+int * FaceHnswIndex::get_links(int id, int level)
+{
+    if(level == 0) {
+        return links0_.data() + (size_t)id * (1 + m0_);
+    }
+    return upper_links_[id].data() + (size_t)(level - 1) * (1 + m_);
+}
+
+const int * FaceHnswIndex::get_links(int id, int level) const
+{
+    return const_cast<FaceHnswIndex *>(this)->get_links(id, level);
+}
+
+int FaceHnswIndex::greedy_search(const face_embedding_matrix_t & matrix, const face_query_t & query, int entry,
+                                 float & entry_score, int level) const
+{
+    bool is_changed = true;
+    while(is_changed) {
+        is_changed        = false;
+        const int * links = get_links(entry, level);
+        for(int i = 1; i <= links[0]; i++) {
+            float score = face_embedding_score(matrix, query, links[i]);
+            if(score > entry_score) {
+                entry_score = score;
+                entry       = links[i];
+                is_changed  = true;
+            }
+        }
+    }
+    return entry;
+}
+
+std::vector<face_hnsw_result_t> FaceHnswIndex::search_layer(const face_embedding_matrix_t & matrix,
+                                                            const face_query_t & query, int entry, float entry_score,
+                                                            int ef, int level) const
+{
+    auto & visited = get_visited_list(levels_.size());
+
+    // candidates 先取相似度最高的，results 堆顶是目前最差的结果
+    std::priority_queue<face_hnsw_result_t> candidates;
+    std::priority_queue<face_hnsw_result_t, std::vector<face_hnsw_result_t>, std::greater<face_hnsw_result_t>>
+        results;
+
+    candidates.emplace(entry_score, entry);
+    results.emplace(entry_score, entry);
+    visited.marks[entry] = visited.generation;
+
+    while(!candidates.empty()) {
+        auto current = candidates.top();
+        if((int)results.size() >= ef && current.first < results.top().first) {
+            break;
+        }
+        candidates.pop();
+
+        const int * links = get_links(current.second, level);
+        for(int i = 1; i <= links[0]; i++) {
+            int neighbor = links[i];
+            if(visited.marks[neighbor] == visited.generation) {
+                continue;
+            }
+            visited.marks[neighbor] = visited.generation;
+
+            float score = face_embedding_score(matrix, query, neighbor);
+            if((int)results.size() < ef || score > results.top().first) {
+                candidates.emplace(score, neighbor);
+                results.emplace(score, neighbor);
+                if((int)results.size() > ef) {
+                    results.pop();
+                }
+            }
+        }
+    }
+
+    std::vector<face_hnsw_result_t> sorted(results.size());
+    for(int i = (int)sorted.size() - 1; i >= 0; i--) {
+        sorted[i] = results.top();
+        results.pop();
+    }
+    return sorted;
+}
+
+std::vector<int> FaceHnswIndex::select_neighbors(const face_embedding_matrix_t & matrix,
+                                                 const std::vector<face_hnsw_result_t> & candidates,
+                                                 int max_count) const
+{
+    std::vector<int> selected;
+    face_query_t candidate_query;
+    for(auto & candidate : candidates) {
+        if((int)selected.size() >= max_count) {
+            break;
+        }
+        if(!selected.empty()) {
+            face_query_from_row(matrix, candidate.second, candidate_query);
+        }
+
+        bool is_kept = true;
+        for(int id : selected) {
+            if(face_embedding_score(matrix, candidate_query, id) > candidate.first) {
+                is_kept = false;
+                break;
+            }
+        }
+        if(is_kept) {
+            selected.push_back(candidate.second);
+        }
+    }
+    return selected;
+}
+
+// 把 id 加入 neighbor 的邻居表，满了则在原邻居和 id 中重新选择
+void FaceHnswIndex::connect(const face_embedding_matrix_t & matrix, int id, int neighbor, int level)
+{
+    int * links = get_links(neighbor, level);
+    int limit   = max_links(level);
+    if(links[0] < limit) {
+        links[++links[0]] = id;
+        return;
+    }
+
+    face_query_t base;
+    face_query_from_row(matrix, neighbor, base);
+    std::vector<face_hnsw_result_t> candidates;
+    candidates.emplace_back(face_embedding_score(matrix, base, id), id);
+    for(int i = 1; i <= links[0]; i++) {
+        candidates.emplace_back(face_embedding_score(matrix, base, links[i]), links[i]);
+    }
+    std::sort(candidates.begin(), candidates.end(), std::greater<face_hnsw_result_t>());
+
+    auto selected = select_neighbors(matrix, candidates, limit);
+    links[0]      = selected.size();
+    std::copy(selected.begin(), selected.end(), links + 1);
+}
+
+void FaceHnswIndex::insert(const face_embedding_matrix_t & matrix, int id)
+{
+    int level = random_level();
+
+    levels_.push_back(level);
+    is_deleted_.push_back(0);
+    links0_.resize(levels_.size() * (1 + m0_), 0);
+    upper_links_.emplace_back((size_t)level * (1 + m_), 0);
+
+    if(entry_point_ < 0) {
+        entry_point_ = id;
+        max_level_   = level;
+        return;
+    }
+
+    face_query_t query;
+    face_query_from_row(matrix, id, query);
+    int entry         = entry_point_;
+    float entry_score = face_embedding_score(matrix, query, entry);
+    for(int l = max_level_; l > level; l--) {
+        entry = greedy_search(matrix, query, entry, entry_score, l);
+    }
+
+    for(int l = std::min(level, max_level_); l >= 0; l--) {
+        auto candidates = search_layer(matrix, query, entry, entry_score, ef_construction_, l);
+        auto neighbors  = select_neighbors(matrix, candidates, m_);
+
+        int * links = get_links(id, l);
+        links[0]    = neighbors.size();
+        std::copy(neighbors.begin(), neighbors.end(), links + 1);
+        for(int neighbor : neighbors) {
+            connect(matrix, id, neighbor, l);
+        }
+
+        entry       = candidates[0].second;
+        entry_score = candidates[0].first;
+    }
+
+    if(level > max_level_) {
+        max_level_   = level;
+        entry_point_ = id;
+    }
+}
+
+void FaceHnswIndex::remove(int id)
+{
+    if(id >= 0 && id < (int)is_deleted_.size()) {
+        is_deleted_[id] = 1;
+    }
+}
+
+void FaceHnswIndex::clear()
+{
+    entry_point_ = -1;
+    max_level_   = -1;
+    levels_.clear();
+    is_deleted_.clear();
+    links0_.clear();
+    upper_links_.clear();
+}
+
+int FaceHnswIndex::search(const face_embedding_matrix_t & matrix, const face_query_t & query, int k, int ef,
+                          face_hnsw_result_t * results) const
+{
+    if(entry_point_ < 0 || k <= 0) {
+        return 0;
+    }
+
+    int entry         = entry_point_;
+    float entry_score = face_embedding_score(matrix, query, entry);
+    for(int l = max_level_; l > 0; l--) {
+        entry = greedy_search(matrix, query, entry, entry_score, l);
+    }
+
+    auto candidates = search_layer(matrix, query, entry, entry_score, std::max(ef, k), 0);
+    int count       = 0;
+    for(auto & candidate : candidates) {
+        if(count == k) {
+            break;
+        }
+        if(!is_deleted_[candidate.second]) {
+            results[count++] = candidate;
+        }
+    }
+    return count;
+}
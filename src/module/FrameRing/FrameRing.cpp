@@ -0,0 +1,140 @@
+#include "FrameRing.hpp"
+#include <cstring>
+
+FrameRing::FrameRing(size_t capacity, FrameRingPolicy policy)
+    : slots_(policy == FrameRingPolicy::LATEST_ONLY || capacity == 0 ? 1 : capacity), policy_(policy)
+{}
+
+Frame FrameRing::take_oldest_locked()
+{
+    Frame frame = std::move(slots_[head_]);
+    slots_[head_] = Frame();
+    head_         = (head_ + 1) % slots_.size();
+    count_--;
+    return frame;
+}
+
+bool FrameRing::push(Frame frame)
+{
+    // 被挤掉的帧在锁外释放，零拷贝帧释放时会把缓冲区还给驱动
+    Frame evicted;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(policy_ == FrameRingPolicy::BLOCK) {
+            not_full_.wait(lock, [this]() { return is_closed_ || count_ < slots_.size(); });
+        }
+        if(is_closed_) {
+            return false;
+        }
+
+        if(count_ == slots_.size()) {
+            evicted = take_oldest_locked();
+            stats_.dropped++;
+        }
+        slots_[(head_ + count_) % slots_.size()] = std::move(frame);
+        count_++;
+        stats_.captured++;
+    }
+    not_empty_.notify_one();
+    return true;
+}
+
+bool FrameRing::pop(Frame & frame)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return is_closed_ || count_ > 0; });
+        if(count_ == 0) {
+            return false;
+        }
+
+        frame = take_oldest_locked();
+        stats_.delivered++;
+    }
+    not_full_.notify_one();
+    return true;
+}
+
+bool FrameRing::try_pop(Frame & frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(count_ == 0) {
+            return false;
+        }
+
+        frame = take_oldest_locked();
+        stats_.delivered++;
+    }
+    not_full_.notify_one();
+    return true;
+}
+
+void FrameRing::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_closed_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+}
+
+void FrameRing::reset()
+{
+    std::vector<Frame> frames;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while(count_ > 0) {
+            frames.push_back(take_oldest_locked());
+            stats_.dropped++;
+        }
+        head_      = 0;
+        is_closed_ = false;
+    }
+    not_full_.notify_all();
+}
+
+size_t FrameRing::size()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+size_t FrameRing::capacity()
+{
+    return slots_.size();
+}
+
+FrameRingPolicy FrameRing::policy()
+{
+    return policy_;
+}
+
+frame_ring_stats_t FrameRing::stats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+static const char * frame_ring_policy_names[] = {
+    "block",       // FrameRingPolicy::BLOCK
+    "drop_oldest", // FrameRingPolicy::DROP_OLDEST
+    "latest_only", // FrameRingPolicy::LATEST_ONLY
+};
+
+bool frame_ring_policy_from_string(const char * name, FrameRingPolicy & policy)
+{
+    for(int i = 0; i < (int)(sizeof(frame_ring_policy_names) / sizeof(frame_ring_policy_names[0])); i++) {
+        if(strcmp(name, frame_ring_policy_names[i]) == 0) {
+            policy = (FrameRingPolicy)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char * frame_ring_policy_name(FrameRingPolicy policy)
+{
+    return frame_ring_policy_names[(int)policy];
+}
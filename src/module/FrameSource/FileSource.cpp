@@ -0,0 +1,205 @@
+#include "FileSource.hpp"
+#include "Trace.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+static bool file_source_is_realtime()
+{
+    const char * env = getenv(FILE_SOURCE_PACING_ENV);
+    return env == nullptr || strcmp(env, "fast") != 0;
+}
+
+static bool file_source_is_loop()
+{
+    const char * env = getenv(FILE_SOURCE_LOOP_ENV);
+    return env == nullptr || atoi(env) != 0;
+}
+
+FileSource::FileSource(const std::string & path, bool is_realtime, bool is_loop, int stream_id)
+    : FrameSource(stream_id, path, is_realtime ? policy_from_env() : FrameRingPolicy::BLOCK, capacity_from_env()),
+      path_(path), is_realtime_(is_realtime && path.find("://") == std::string::npos), is_loop_(is_loop)
+{
+    if(open_input() != 0) {
+        close_input();
+        return;
+    }
+    printf("FileSource%d: %s %dx%d %s%s\n", stream_id_, path_.c_str(), width_, height_,
+           is_realtime_ ? "realtime" : "fast", is_loop_ ? " loop" : "");
+}
+
+FileSource::FileSource(const std::string & path, int stream_id)
+    : FileSource(path, file_source_is_realtime(), file_source_is_loop(), stream_id)
+{}
+
+FileSource::~FileSource()
+{
+    close_input();
+}
+
+bool FileSource::is_opened()
+{
+    return codec_ctx_ != nullptr;
+}
+
+int FileSource::open_input()
+{
+    avformat_network_init();
+
+    if(avformat_open_input(&format_ctx_, path_.c_str(), nullptr, nullptr) < 0) {
+        std::cerr << "FileSource: can not open " << path_ << std::endl;
+        return -1;
+    }
+    if(avformat_find_stream_info(format_ctx_, nullptr) < 0) {
+        std::cerr << "FileSource: can not find stream info in " << path_ << std::endl;
+        return -1;
+    }
+
+    const AVCodec * codec = nullptr;
+    stream_index_         = av_find_best_stream(format_ctx_, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if(stream_index_ < 0 || codec == nullptr) {
+        std::cerr << "FileSource: no video stream in " << path_ << std::endl;
+        return -1;
+    }
+
+    codec_ctx_ = avcodec_alloc_context3(codec);
+    if(codec_ctx_ == nullptr) {
+        return -1;
+    }
+    if(avcodec_parameters_to_context(codec_ctx_, format_ctx_->streams[stream_index_]->codecpar) < 0) {
+        return -1;
+    }
+    codec_ctx_->thread_count = 0; // 由解码器自动选择线程数
+    if(avcodec_open2(codec_ctx_, codec, nullptr) < 0) {
+        std::cerr << "FileSource: can not open decoder " << codec->name << std::endl;
+        avcodec_free_context(&codec_ctx_);
+        return -1;
+    }
+
+    width_  = codec_ctx_->width;
+    height_ = codec_ctx_->height;
+    packet_ = av_packet_alloc();
+    frame_  = av_frame_alloc();
+    return 0;
+}
+
+void FileSource::close_input()
+{
+    sws_freeContext(sws_ctx_);
+    sws_ctx_ = nullptr;
+    av_frame_free(&frame_);
+    av_packet_free(&packet_);
+    avcodec_free_context(&codec_ctx_);
+    avformat_close_input(&format_ctx_);
+}
+
+void FileSource::open_stream()
+{
+    // 每次启动都重新计时，realtime 模式从当前位置按原速继续
+    first_pts_ = AV_NOPTS_VALUE;
+}
+
+bool FileSource::decode_next()
+{
+    while(true) {
+        int ret = avcodec_receive_frame(codec_ctx_, frame_);
+        if(ret == 0) {
+            return true;
+        }
+        if(ret == AVERROR_EOF) {
+            if(!is_loop_) {
+                return false;
+            }
+            // 回到开头重新播放，时间戳从头开始，重新计时
+            if(av_seek_frame(format_ctx_, stream_index_, 0, AVSEEK_FLAG_BACKWARD) < 0) {
+                std::cerr << "FileSource: seek failed in " << path_ << std::endl;
+                return false;
+            }
+            avcodec_flush_buffers(codec_ctx_);
+            is_draining_ = false;
+            first_pts_   = AV_NOPTS_VALUE;
+            continue;
+        }
+        if(ret != AVERROR(EAGAIN)) {
+            std::cerr << "FileSource: decode error in " << path_ << std::endl;
+            return false;
+        }
+
+        if(is_draining_) {
+            return false;
+        }
+
+        // 解码器需要更多数据
+        ret = av_read_frame(format_ctx_, packet_);
+        if(ret < 0) {
+            // 文件结束，送入空包取出解码器中剩余的帧
+            is_draining_ = true;
+            avcodec_send_packet(codec_ctx_, nullptr);
+            continue;
+        }
+        if(packet_->stream_index == stream_index_) {
+            avcodec_send_packet(codec_ctx_, packet_);
+        }
+        av_packet_unref(packet_);
+    }
+}
+
+void FileSource::wait_for_pts(int64_t pts)
+{
+    if(pts == AV_NOPTS_VALUE) {
+        return;
+    }
+
+    auto now = clock::now();
+    if(first_pts_ == AV_NOPTS_VALUE) {
+        first_pts_  = pts;
+        first_time_ = now;
+        return;
+    }
+
+    AVRational time_base = format_ctx_->streams[stream_index_]->time_base;
+    int64_t offset_us    = av_rescale_q(pts - first_pts_, time_base, AVRational{1, 1000000});
+    auto deadline        = first_time_ + std::chrono::microseconds(offset_us);
+    if(deadline > now) {
+        std::this_thread::sleep_until(deadline);
+    }
+}
+
+bool FileSource::read_frame(Frame & frame)
+{
+    if(!is_opened()) {
+        return false;
+    }
+
+    {
+        TRACE_SCOPE(TraceStage::CAMERA_CAPTURE);
+        if(!decode_next()) {
+            return false;
+        }
+
+        // 转换为 BGR，尺寸不变，上下文在格式和尺寸不变时复用
+        sws_ctx_ = sws_getCachedContext(sws_ctx_, frame_->width, frame_->height, (AVPixelFormat)frame_->format,
+                                        frame_->width, frame_->height, AV_PIX_FMT_BGR24, SWS_FAST_BILINEAR, nullptr,
+                                        nullptr, nullptr);
+        if(sws_ctx_ == nullptr) {
+            std::cerr << "FileSource: unsupported pixel format in " << path_ << std::endl;
+            return false;
+        }
+
+        frame.image       = std::make_shared<cv::Mat>(frame_->height, frame_->width, CV_8UC3);
+        uint8_t * dst[1]  = {frame.image->data};
+        int dst_stride[1] = {(int)frame.image->step[0]};
+        sws_scale(sws_ctx_, frame_->data, frame_->linesize, 0, frame_->height, dst, dst_stride);
+    }
+
+    if(is_realtime_) {
+        wait_for_pts(frame_->best_effort_timestamp);
+    }
+    av_frame_unref(frame_);
+
+    frame.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now().time_since_epoch())
+                             .count();
+    return true;
+}
@@ -0,0 +1,118 @@
+#include "FrameSource.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+FrameSource::FrameSource(int stream_id, const std::string & name, FrameRingPolicy policy, size_t capacity)
+    : stream_id_(stream_id), name_(name), frame_ring_(capacity, policy)
+{}
+
+FrameRingPolicy FrameSource::policy_from_env()
+{
+    FrameRingPolicy policy = FrameRingPolicy::DROP_OLDEST;
+    const char * env       = getenv(CAMERA_FRAME_POLICY_ENV);
+    if(env != nullptr && !frame_ring_policy_from_string(env, policy)) {
+        std::cerr << "FrameSource: unknown frame policy " << env << ", use drop_oldest" << std::endl;
+    }
+    return policy;
+}
+
+size_t FrameSource::capacity_from_env()
+{
+    const char * env = getenv(CAMERA_FRAME_RING_SIZE_ENV);
+    int size         = env ? atoi(env) : 0;
+    return size > 0 ? size : FRAME_RING_CAPACITY;
+}
+
+void FrameSource::capture_loop()
+{
+    try {
+        while(is_running_) {
+            Frame frame;
+            if(!read_frame(frame)) {
+                break;
+            }
+            frame.sequence  = ++frame_sequence_;
+            frame.stream_id = stream_id_;
+
+            if(!frame_ring_.push(std::move(frame))) {
+                break;
+            }
+            if(frame_callback_) {
+                frame_callback_();
+            }
+        }
+    } catch(std::exception & e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+    // 唤醒等待取帧的线程
+    frame_ring_.close();
+    if(frame_callback_) {
+        frame_callback_();
+    }
+}
+
+void FrameSource::start()
+{
+    open_stream();
+    frame_ring_.reset();
+    is_running_     = true;
+    capture_thread_ = std::thread(&FrameSource::capture_loop, this);
+}
+
+void FrameSource::stop()
+{
+    is_running_ = false;
+    frame_ring_.close();
+    capture_thread_.join();
+    // 归还缓存中的帧，零拷贝帧引用的驱动缓冲区要在停止采集前释放
+    frame_ring_.reset();
+    close_stream();
+
+    auto stats = frame_ring_.stats();
+    printf("%s(%d): %s captured=%llu dropped=%llu delivered=%llu\n", name_.c_str(), stream_id_,
+           frame_ring_policy_name(frame_ring_.policy()), (unsigned long long)stats.captured,
+           (unsigned long long)stats.dropped, (unsigned long long)stats.delivered);
+}
+
+Frame FrameSource::get_frame()
+{
+    Frame frame;
+    frame_ring_.pop(frame);
+    return frame;
+}
+
+bool FrameSource::try_get_frame(Frame & frame)
+{
+    return frame_ring_.try_pop(frame);
+}
+
+frame_ring_stats_t FrameSource::get_stats()
+{
+    return frame_ring_.stats();
+}
+
+void FrameSource::set_frame_callback(std::function<void()> callback)
+{
+    frame_callback_ = std::move(callback);
+}
+
+int FrameSource::get_stream_id()
+{
+    return stream_id_;
+}
+
+int FrameSource::get_width()
+{
+    return width_;
+}
+
+int FrameSource::get_height()
+{
+    return height_;
+}
+
+const std::string & FrameSource::get_name()
+{
+    return name_;
+}
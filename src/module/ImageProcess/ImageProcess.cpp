@@ -1,36 +1,186 @@
 #include "ImageProcess.hpp"
+#include "Trace.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstring>
 #include <string>
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 // 定义最大类别数
 #define N_CLASS_COLORS (20)
 
 // 人脸框长度
 #define FACE_BOX_LENGTH 60
 
+// letterbox 填充值
+#define LETTERBOX_PAD_VALUE 114
+
+// 插值权重的定点位数
+#define LETTERBOX_COEF_BITS 8
+#define LETTERBOX_COEF_SCALE (1 << LETTERBOX_COEF_BITS)
+
+// 计算输出坐标对应的源坐标和权重，与 cv::resize(INTER_LINEAR) 的像素中心对齐方式一致
+static void build_resize_table(int src_len, int dst_len, std::vector<int> & ofs, std::vector<uint16_t> & alpha)
+{
+    ofs.resize(dst_len);
+    alpha.resize(dst_len);
+
+    double inv_scale = (double)src_len / dst_len;
+    for(int i = 0; i < dst_len; i++) {
+        double f = (i + 0.5) * inv_scale - 0.5;
+        int i0   = (int)std::floor(f);
+        double a = f - i0;
+        if(i0 < 0) {
+            i0 = 0;
+            a  = 0;
+        }
+        if(i0 >= src_len - 1) {
+            i0 = src_len - 1;
+            a  = 0;
+        }
+        ofs[i]   = i0;
+        alpha[i] = (uint16_t)std::lround(a * LETTERBOX_COEF_SCALE);
+    }
+}
+
+// 水平插值一行，输出按 RGB 顺序排列，结果放大了 LETTERBOX_COEF_SCALE 倍
+static void resize_row_bgr_to_rgb_scalar(const uint8_t * src_row, const int * x_ofs, const uint16_t * x_alpha,
+                                         int width, uint16_t * dst)
+{
+    for(int x = 0; x < width; x++) {
+        const uint8_t * p0 = src_row + x_ofs[x] * 3;
+        // 权重为 0 时不读取右侧像素，避免最后一列越界
+        const uint8_t * p1 = x_alpha[x] != 0 ? p0 + 3 : p0;
+        uint16_t a         = x_alpha[x];
+        uint16_t ia        = LETTERBOX_COEF_SCALE - a;
+
+        dst[0] = p0[2] * ia + p1[2] * a;
+        dst[1] = p0[1] * ia + p1[1] * a;
+        dst[2] = p0[0] * ia + p1[0] * a;
+        dst += 3;
+    }
+}
+
+#if defined(__ARM_NEON)
+// 每次处理 8 个输出像素: 按查找表把左右两个源像素收集成连续的 BGR 数据，vld3 拆分通道后
+// 扩展到 16 位乘加插值，vst3 按 RGB 顺序交错写回，不足 8 个的部分用标量处理
+static void resize_row_bgr_to_rgb_neon(const uint8_t * src_row, const int * x_ofs, const uint16_t * x_alpha,
+                                       int width, uint16_t * dst)
+{
+    const uint16x8_t v_scale = vdupq_n_u16(LETTERBOX_COEF_SCALE);
+    uint8_t left[8 * 3];
+    uint8_t right[8 * 3];
+
+    int x = 0;
+    for(; x + 8 <= width; x += 8) {
+        for(int k = 0; k < 8; k++) {
+            const uint8_t * p0 = src_row + x_ofs[x + k] * 3;
+            // 权重为 0 时不读取右侧像素，避免最后一列越界
+            const uint8_t * p1 = x_alpha[x + k] != 0 ? p0 + 3 : p0;
+            memcpy(left + k * 3, p0, 3);
+            memcpy(right + k * 3, p1, 3);
+        }
+        uint8x8x3_t l = vld3_u8(left);
+        uint8x8x3_t r = vld3_u8(right);
+        uint16x8_t a  = vld1q_u16(x_alpha + x);
+        uint16x8_t ia = vsubq_u16(v_scale, a);
+
+        // 最大值 255 * LETTERBOX_COEF_SCALE，16 位不会溢出
+        uint16x8x3_t out;
+        out.val[0] = vmlaq_u16(vmulq_u16(vmovl_u8(l.val[2]), ia), vmovl_u8(r.val[2]), a);
+        out.val[1] = vmlaq_u16(vmulq_u16(vmovl_u8(l.val[1]), ia), vmovl_u8(r.val[1]), a);
+        out.val[2] = vmlaq_u16(vmulq_u16(vmovl_u8(l.val[0]), ia), vmovl_u8(r.val[0]), a);
+        vst3q_u16(dst + x * 3, out);
+    }
+
+    resize_row_bgr_to_rgb_scalar(src_row, x_ofs + x, x_alpha + x, width - x, dst + x * 3);
+}
+#endif
+
+static std::atomic<bool> neon_enabled{true};
+
+bool ImageProcess::is_neon_available()
+{
+#if defined(__ARM_NEON)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ImageProcess::set_neon_enabled(bool is_enabled)
+{
+    neon_enabled = is_enabled;
+}
+
+// 垂直插值两行并还原为 8 位
+static void blend_rows(const uint16_t * row0, const uint16_t * row1, uint16_t beta, uint8_t * dst, int n)
+{
+    uint16_t ibeta = LETTERBOX_COEF_SCALE - beta;
+    int i          = 0;
+
+#if defined(__ARM_NEON)
+    uint16x4_t v_ibeta = vdup_n_u16(ibeta);
+    uint16x4_t v_beta  = vdup_n_u16(beta);
+    for(; i + 8 <= n; i += 8) {
+        uint16x8_t r0 = vld1q_u16(row0 + i);
+        uint16x8_t r1 = vld1q_u16(row1 + i);
+
+        uint32x4_t lo = vmull_u16(vget_low_u16(r0), v_ibeta);
+        lo            = vmlal_u16(lo, vget_low_u16(r1), v_beta);
+        uint32x4_t hi = vmull_u16(vget_high_u16(r0), v_ibeta);
+        hi            = vmlal_u16(hi, vget_high_u16(r1), v_beta);
+
+        // 两次插值共放大 2^16 倍，四舍五入右移还原
+        uint16x8_t v = vcombine_u16(vrshrn_n_u32(lo, 2 * LETTERBOX_COEF_BITS), vrshrn_n_u32(hi, 2 * LETTERBOX_COEF_BITS));
+        vst1_u8(dst + i, vmovn_u16(v));
+    }
+#endif
+
+    for(; i < n; i++) {
+        uint32_t v = (uint32_t)row0[i] * ibeta + (uint32_t)row1[i] * beta;
+        dst[i]     = (uint8_t)((v + (1 << (2 * LETTERBOX_COEF_BITS - 1))) >> (2 * LETTERBOX_COEF_BITS));
+    }
+}
+
 // 计算缩放比例和填充大小的构造函数
-ImageProcess::ImageProcess(int width, int height, int target_size)
+ImageProcess::ImageProcess(int width, int height, int target_size) : target_size_(target_size)
+{
+    reset(width, height);
+}
+
+// 按新的源图尺寸重新计算，查找表复用已分配的内存
+void ImageProcess::reset(int width, int height)
 {
     // 根据目标大小计算缩放比例
-    scale_ = static_cast<double>(target_size) / std::max(height, width);
+    scale_ = static_cast<double>(target_size_) / std::max(height, width);
 
     // 根据缩放比例计算填充的大小
-    padding_x_ = target_size - static_cast<int>(width * scale_);
-    padding_y_ = target_size - static_cast<int>(height * scale_);
+    padding_x_ = target_size_ - static_cast<int>(width * scale_);
+    padding_y_ = target_size_ - static_cast<int>(height * scale_);
 
     // 计算新的尺寸
     new_size_ = cv::Size(static_cast<int>(width * scale_), static_cast<int>(height * scale_));
 
-    target_size_ = target_size;
-
     // 设置填充信息
     letterbox_.scale = scale_;
     letterbox_.x_pad = padding_x_ / 2;
     letterbox_.y_pad = padding_y_ / 2;
+
+    src_width_  = width;
+    src_height_ = height;
+    build_resize_table(width, new_size_.width, x_ofs_, x_alpha_);
+    build_resize_table(height, new_size_.height, y_ofs_, y_beta_);
 }
 
 // 将图像转换为目标大小，填充并返回
 std::unique_ptr<cv::Mat> ImageProcess::convert(const cv::Mat & src)
 {
+    TRACE_SCOPE(TraceStage::PREPROCESS);
+
     if(src.empty()) {
         return nullptr;
     }
@@ -51,49 +201,133 @@ std::unique_ptr<cv::Mat> ImageProcess::convert(const cv::Mat & src)
     return square_img;
 }
 
+// 缩放、填充和 BGR->RGB 融合为一次遍历:
+// 每个输出行先对两条源行做水平插值(同时交换通道)得到 16 位中间结果，再做垂直插值写入 dst
+int ImageProcess::convert(const cv::Mat & src, void * dst, int dst_stride)
+{
+    TRACE_SCOPE(TraceStage::PREPROCESS);
+
+    if(src.empty() || dst == nullptr || src.type() != CV_8UC3 || src.cols != src_width_ ||
+       src.rows != src_height_) {
+        return -1;
+    }
+
+    uint8_t * out = (uint8_t *)dst;
+    int x         = padding_x_ / 2;
+    int y         = padding_y_ / 2;
+    int w         = new_size_.width;
+    int h         = new_size_.height;
+    int row_bytes = target_size_ * 3;
+
+    // 上下填充
+    for(int dy = 0; dy < y; dy++) {
+        memset(out + dy * dst_stride, LETTERBOX_PAD_VALUE, row_bytes);
+    }
+    for(int dy = y + h; dy < target_size_; dy++) {
+        memset(out + dy * dst_stride, LETTERBOX_PAD_VALUE, row_bytes);
+    }
+
+    auto resize_row = resize_row_bgr_to_rgb_scalar;
+#if defined(__ARM_NEON)
+    if(neon_enabled) {
+        resize_row = resize_row_bgr_to_rgb_neon;
+    }
+#endif
+
+    thread_local std::vector<uint16_t> rows[2];
+    rows[0].resize(w * 3);
+    rows[1].resize(w * 3);
+    int row_index[2] = {-1, -1};
+
+    for(int dy = 0; dy < h; dy++) {
+        uint8_t * dst_row = out + (y + dy) * dst_stride;
+
+        // 左右填充
+        memset(dst_row, LETTERBOX_PAD_VALUE, x * 3);
+        memset(dst_row + (x + w) * 3, LETTERBOX_PAD_VALUE, (target_size_ - x - w) * 3);
+
+        int sy0 = y_ofs_[dy];
+        int sy1 = y_beta_[dy] != 0 ? sy0 + 1 : sy0;
+
+        // 放大时相邻输出行会用到相同的源行，复用已插值的结果
+        if(row_index[0] != sy0) {
+            if(row_index[1] == sy0) {
+                std::swap(rows[0], rows[1]);
+                std::swap(row_index[0], row_index[1]);
+            } else {
+                resize_row(src.ptr<uint8_t>(sy0), x_ofs_.data(), x_alpha_.data(), w, rows[0].data());
+                row_index[0] = sy0;
+            }
+        }
+        if(sy1 != sy0 && row_index[1] != sy1) {
+            resize_row(src.ptr<uint8_t>(sy1), x_ofs_.data(), x_alpha_.data(), w, rows[1].data());
+            row_index[1] = sy1;
+        }
+
+        blend_rows(rows[0].data(), sy1 != sy0 ? rows[1].data() : rows[0].data(), y_beta_[dy], dst_row + x * 3, w * 3);
+    }
+
+    return 0;
+}
+
 // 获取 letterbox 配置，用于图像填充
 const letterbox_t & ImageProcess::get_letter_box()
 {
     return letterbox_;
 }
 
+// 在人脸框的四个角绘制折线
+static void draw_face_box(cv::Mat & image, const retinaface_object * detect_result, const cv::Scalar & color)
+{
+    // 左上角
+    cv::line(image, cv::Point(detect_result->box.left, detect_result->box.top),
+             cv::Point(detect_result->box.left + FACE_BOX_LENGTH, detect_result->box.top), color, 5);
+    cv::line(image, cv::Point(detect_result->box.left, detect_result->box.top),
+             cv::Point(detect_result->box.left, detect_result->box.top + FACE_BOX_LENGTH), color, 5);
+
+    // 右上角
+    cv::line(image, cv::Point(detect_result->box.right - FACE_BOX_LENGTH, detect_result->box.top),
+             cv::Point(detect_result->box.right, detect_result->box.top), color, 5);
+    cv::line(image, cv::Point(detect_result->box.right, detect_result->box.top),
+             cv::Point(detect_result->box.right, detect_result->box.top + FACE_BOX_LENGTH), color, 5);
+
+    // 左下角
+    cv::line(image, cv::Point(detect_result->box.left, detect_result->box.bottom - FACE_BOX_LENGTH),
+             cv::Point(detect_result->box.left, detect_result->box.bottom), color, 5);
+    cv::line(image, cv::Point(detect_result->box.left, detect_result->box.bottom),
+             cv::Point(detect_result->box.left + FACE_BOX_LENGTH, detect_result->box.bottom), color, 5);
+
+    // 右下角
+    cv::line(image, cv::Point(detect_result->box.right - FACE_BOX_LENGTH, detect_result->box.bottom),
+             cv::Point(detect_result->box.right, detect_result->box.bottom), color, 5);
+    cv::line(image, cv::Point(detect_result->box.right, detect_result->box.bottom - FACE_BOX_LENGTH),
+             cv::Point(detect_result->box.right, detect_result->box.bottom), color, 5);
+}
+
 // 图像后处理，进行物体检测和后续处理
 void ImageProcess::image_post_process(cv::Mat & image, retinaface_result & results, cv::Scalar & color)
 {
+    TRACE_SCOPE(TraceStage::IMAGE_POST_PROCESS);
 
     for(int i = 0; i < results.count; ++i) {
+        // 绘制检测框
+        draw_face_box(image, &(results.object[i]), color);
+    }
+}
 
-        retinaface_object * detect_result = &(results.object[i]);
+void ImageProcess::image_post_process(cv::Mat & image, retinaface_result & results, const cv::Scalar * colors)
+{
+    TRACE_SCOPE(TraceStage::IMAGE_POST_PROCESS);
 
-        // 绘制检测框
-        // 左上角
-        cv::line(image, cv::Point(detect_result->box.left, detect_result->box.top),
-                 cv::Point(detect_result->box.left + FACE_BOX_LENGTH, detect_result->box.top), color, 5);
-        cv::line(image, cv::Point(detect_result->box.left, detect_result->box.top),
-                 cv::Point(detect_result->box.left, detect_result->box.top + FACE_BOX_LENGTH), color, 5);
-
-        // 右上角
-        cv::line(image, cv::Point(detect_result->box.right - FACE_BOX_LENGTH, detect_result->box.top),
-                 cv::Point(detect_result->box.right, detect_result->box.top), color, 5);
-        cv::line(image, cv::Point(detect_result->box.right, detect_result->box.top),
-                 cv::Point(detect_result->box.right, detect_result->box.top + FACE_BOX_LENGTH), color, 5);
-
-        // 左下角
-        cv::line(image, cv::Point(detect_result->box.left, detect_result->box.bottom - FACE_BOX_LENGTH),
-                 cv::Point(detect_result->box.left, detect_result->box.bottom), color, 5);
-        cv::line(image, cv::Point(detect_result->box.left, detect_result->box.bottom),
-                 cv::Point(detect_result->box.left + FACE_BOX_LENGTH, detect_result->box.bottom), color, 5);
-
-        // 右下角
-        cv::line(image, cv::Point(detect_result->box.right - FACE_BOX_LENGTH, detect_result->box.bottom),
-                 cv::Point(detect_result->box.right, detect_result->box.bottom), color, 5);
-        cv::line(image, cv::Point(detect_result->box.right, detect_result->box.bottom - FACE_BOX_LENGTH),
-                 cv::Point(detect_result->box.right, detect_result->box.bottom), color, 5);
+    for(int i = 0; i < results.count; ++i) {
+        draw_face_box(image, &(results.object[i]), colors[i]);
     }
 }
 
 void ImageProcess::image_post_process(cv::Mat & image, yolo_result_list & results, cv::Scalar & color)
 {
+    TRACE_SCOPE(TraceStage::IMAGE_POST_PROCESS);
+
     for(int i = 0; i < results.count; ++i) {
         yolo_result * detect_result = &(results.results[i]);
 
@@ -0,0 +1,125 @@
+#include "InferenceBackend.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+// 根据模型路径生成录制/回放文件路径: <dir>/<模型文件名>.replay
+std::string get_replay_file_path(const char * dir, const char * model_path)
+{
+    std::string file_name(model_path);
+    auto pos = file_name.find_last_of('/');
+    if(pos != std::string::npos) {
+        file_name = file_name.substr(pos + 1);
+    }
+    return std::string(dir) + "/" + file_name + ".replay";
+}
+
+std::unique_ptr<InferenceBackend> create_inference_backend()
+{
+    const char * backend_name = getenv(INFERENCE_BACKEND_ENV);
+
+#if USE_RKNN_RUNTIME
+    if(backend_name == nullptr || strcmp(backend_name, "rknn") == 0) {
+        return std::make_unique<RknnBackend>();
+    }
+#endif
+
+    if(backend_name != nullptr && strcmp(backend_name, "replay") != 0) {
+        std::cout << "Unknown inference backend: " << backend_name << ", fallback to replay" << std::endl;
+    }
+    return std::make_unique<ReplayBackend>();
+}
+
+// ============================ ReplayRecorder ============================
+
+std::shared_ptr<ReplayRecorder> ReplayRecorder::open(const char * model_path, InferenceBackend * backend)
+{
+    const char * record_dir = getenv(INFERENCE_RECORD_DIR_ENV);
+    if(record_dir == nullptr) {
+        return nullptr;
+    }
+
+    // 同一模型的所有上下文写入同一个文件
+    static std::mutex recorders_mutex;
+    static std::map<std::string, std::weak_ptr<ReplayRecorder>> recorders;
+
+    std::string path = get_replay_file_path(record_dir, model_path);
+
+    std::lock_guard<std::mutex> lock(recorders_mutex);
+    if(auto recorder = recorders[path].lock()) {
+        return recorder;
+    }
+
+    rknn_input_output_num io_num;
+    if(backend->query(RKNN_QUERY_IN_OUT_NUM, &io_num, sizeof(io_num)) != RKNN_SUCC) {
+        return nullptr;
+    }
+
+    auto recorder = std::shared_ptr<ReplayRecorder>(new ReplayRecorder());
+    recorder->fp_ = fopen(path.c_str(), "wb");
+    if(recorder->fp_ == nullptr) {
+        std::cout << "Open " << path << " for recording failed!" << std::endl;
+        return nullptr;
+    }
+
+    const char * max_frames = getenv(INFERENCE_RECORD_FRAMES_ENV);
+    if(max_frames != nullptr) {
+        recorder->max_frames_ = atoi(max_frames);
+    }
+
+    replay_file_header_t header;
+    memcpy(header.magic, REPLAY_FILE_MAGIC, sizeof(header.magic));
+    header.version = REPLAY_FILE_VERSION;
+    header.io_num  = io_num;
+    fwrite(&header, sizeof(header), 1, recorder->fp_);
+
+    for(uint32_t i = 0; i < io_num.n_input; i++) {
+        rknn_tensor_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.index = i;
+        backend->query(RKNN_QUERY_INPUT_ATTR, &attr, sizeof(attr));
+        fwrite(&attr, sizeof(attr), 1, recorder->fp_);
+    }
+    for(uint32_t i = 0; i < io_num.n_output; i++) {
+        rknn_tensor_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.index = i;
+        backend->query(RKNN_QUERY_OUTPUT_ATTR, &attr, sizeof(attr));
+        fwrite(&attr, sizeof(attr), 1, recorder->fp_);
+    }
+
+    std::cout << "Recording outputs to " << path << std::endl;
+
+    recorders[path] = recorder;
+    return recorder;
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+    if(fp_ != nullptr) {
+        fclose(fp_);
+    }
+}
+
+void ReplayRecorder::append(uint32_t n_outputs, rknn_output outputs[])
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(frames_ >= max_frames_) {
+        return;
+    }
+
+    for(uint32_t i = 0; i < n_outputs; i++) {
+        replay_tensor_header_t tensor_header;
+        tensor_header.index    = outputs[i].index;
+        tensor_header.is_float = outputs[i].want_float;
+        tensor_header.size     = outputs[i].size;
+        fwrite(&tensor_header, sizeof(tensor_header), 1, fp_);
+        fwrite(outputs[i].buf, 1, outputs[i].size, fp_);
+    }
+
+    if(++frames_ == max_frames_) {
+        fflush(fp_);
+        std::cout << "Recording finished, " << frames_ << " frames" << std::endl;
+    }
+}
@@ -0,0 +1,369 @@
+#include "InferenceBackend.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+// 读取录制文件
+static std::shared_ptr<ReplayData> load_replay_data(const std::string & path)
+{
+    FILE * fp = fopen(path.c_str(), "rb");
+    if(fp == nullptr) {
+        std::cout << "Open replay file " << path << " failed!" << std::endl;
+        return nullptr;
+    }
+
+    auto data = std::make_shared<ReplayData>();
+
+    replay_file_header_t header;
+    if(fread(&header, sizeof(header), 1, fp) != 1 || memcmp(header.magic, REPLAY_FILE_MAGIC, 4) != 0 ||
+       header.version != REPLAY_FILE_VERSION) {
+        std::cout << "Invalid replay file " << path << std::endl;
+        fclose(fp);
+        return nullptr;
+    }
+
+    data->io_num = header.io_num;
+    data->input_attrs.resize(header.io_num.n_input);
+    data->output_attrs.resize(header.io_num.n_output);
+
+    if(fread(data->input_attrs.data(), sizeof(rknn_tensor_attr), header.io_num.n_input, fp) != header.io_num.n_input ||
+       fread(data->output_attrs.data(), sizeof(rknn_tensor_attr), header.io_num.n_output, fp) !=
+           header.io_num.n_output) {
+        std::cout << "Invalid replay file " << path << std::endl;
+        fclose(fp);
+        return nullptr;
+    }
+
+    // 逐帧读取，末尾不完整的帧直接丢弃
+    while(true) {
+        std::vector<ReplayTensor> frame(header.io_num.n_output);
+        bool is_complete = true;
+        for(uint32_t i = 0; i < header.io_num.n_output; i++) {
+            if(fread(&frame[i].header, sizeof(replay_tensor_header_t), 1, fp) != 1) {
+                is_complete = false;
+                break;
+            }
+            frame[i].data.resize(frame[i].header.size);
+            if(fread(frame[i].data.data(), 1, frame[i].header.size, fp) != frame[i].header.size) {
+                is_complete = false;
+                break;
+            }
+        }
+        if(!is_complete) {
+            break;
+        }
+        data->frames.push_back(std::move(frame));
+    }
+    fclose(fp);
+
+    if(data->frames.empty()) {
+        std::cout << "Replay file " << path << " has no frame" << std::endl;
+        return nullptr;
+    }
+
+    std::cout << "Load replay file " << path << ", " << data->frames.size() << " frames" << std::endl;
+    return data;
+}
+
+static bool is_float_tensor(const rknn_tensor_attr & attr)
+{
+    return attr.type == RKNN_TENSOR_FLOAT32;
+}
+
+ReplayBackend::ReplayBackend()
+{
+    const char * latency = getenv(INFERENCE_REPLAY_LATENCY_ENV);
+    if(latency != nullptr) {
+        latency_us_ = atoi(latency);
+    }
+}
+
+int ReplayBackend::init(void * model, uint32_t size, const char * model_path)
+{
+    const char * replay_dir = getenv(INFERENCE_REPLAY_DIR_ENV);
+    data_ = load_replay_data(get_replay_file_path(replay_dir ? replay_dir : INFERENCE_REPLAY_DIR_DEFAULT, model_path));
+    if(!data_) {
+        return RKNN_ERR_MODEL_INVALID;
+    }
+    convert_buffers_.resize(data_->io_num.n_output);
+    return RKNN_SUCC;
+}
+
+int ReplayBackend::dup(InferenceBackend * src)
+{
+    auto src_backend = dynamic_cast<ReplayBackend *>(src);
+    if(src_backend == nullptr || !src_backend->data_) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    data_ = src_backend->data_;
+    convert_buffers_.resize(data_->io_num.n_output);
+    return RKNN_SUCC;
+}
+
+int ReplayBackend::destroy()
+{
+    data_.reset();
+    convert_buffers_.clear();
+    output_mems_.clear();
+    output_mem_attrs_.clear();
+    return RKNN_SUCC;
+}
+
+int ReplayBackend::set_core_mask(rknn_core_mask core_mask)
+{
+    return RKNN_SUCC;
+}
+
+int ReplayBackend::query(rknn_query_cmd cmd, void * info, uint32_t size)
+{
+    if(!data_) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+
+    switch(cmd) {
+        case RKNN_QUERY_IN_OUT_NUM:
+            if(size < sizeof(rknn_input_output_num)) return RKNN_ERR_PARAM_INVALID;
+            memcpy(info, &data_->io_num, sizeof(rknn_input_output_num));
+            return RKNN_SUCC;
+        case RKNN_QUERY_INPUT_ATTR:
+        case RKNN_QUERY_OUTPUT_ATTR: {
+            if(size < sizeof(rknn_tensor_attr)) return RKNN_ERR_PARAM_INVALID;
+            auto attr   = (rknn_tensor_attr *)info;
+            auto & list = cmd == RKNN_QUERY_INPUT_ATTR ? data_->input_attrs : data_->output_attrs;
+            if(attr->index >= list.size()) return RKNN_ERR_PARAM_INVALID;
+            memcpy(attr, &list[attr->index], sizeof(rknn_tensor_attr));
+            return RKNN_SUCC;
+        }
+        case RKNN_QUERY_SDK_VERSION: {
+            if(size < sizeof(rknn_sdk_version)) return RKNN_ERR_PARAM_INVALID;
+            auto version = (rknn_sdk_version *)info;
+            snprintf(version->api_version, sizeof(version->api_version), "replay");
+            snprintf(version->drv_version, sizeof(version->drv_version), "replay");
+            return RKNN_SUCC;
+        }
+        default: return RKNN_ERR_PARAM_INVALID;
+    }
+}
+
+int ReplayBackend::inputs_set(uint32_t n_inputs, rknn_input inputs[])
+{
+    if(!data_ || n_inputs != data_->io_num.n_input) {
+        return RKNN_ERR_INPUT_INVALID;
+    }
+    for(uint32_t i = 0; i < n_inputs; i++) {
+        if(inputs[i].buf == nullptr) {
+            return RKNN_ERR_INPUT_INVALID;
+        }
+    }
+    return RKNN_SUCC;
+}
+
+int ReplayBackend::run()
+{
+    int ret = run_async();
+    return ret != RKNN_SUCC ? ret : wait();
+}
+
+int ReplayBackend::run_async()
+{
+    if(!data_) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+    run_deadline_ = std::chrono::steady_clock::now() + std::chrono::microseconds(latency_us_);
+    return RKNN_SUCC;
+}
+
+// 模拟推理耗时从 run_async 开始计算，期间调用者做的 CPU 工作与之重叠
+int ReplayBackend::wait()
+{
+    if(!data_) {
+        return RKNN_ERR_CTX_INVALID;
+    }
+
+    std::this_thread::sleep_until(run_deadline_);
+
+    current_frame_ = frame_index_ % data_->frames.size();
+    frame_index_++;
+
+    // 写入绑定的输出内存
+    for(size_t i = 0; i < output_mems_.size(); i++) {
+        if(output_mems_[i] == nullptr) {
+            continue;
+        }
+        void * buf    = nullptr;
+        uint32_t size = 0;
+        int ret       = get_output_tensor(i, is_float_tensor(output_mem_attrs_[i]), &buf, &size);
+        if(ret != RKNN_SUCC) {
+            return ret;
+        }
+        if(output_mems_[i]->size < size) {
+            return RKNN_ERR_OUTPUT_INVALID;
+        }
+        memcpy(output_mems_[i]->virt_addr, buf, size);
+    }
+    return RKNN_SUCC;
+}
+
+int ReplayBackend::get_output_tensor(uint32_t index, bool want_float, void ** buf, uint32_t * size)
+{
+    auto & frame = data_->frames[current_frame_];
+    if(index >= frame.size()) {
+        return RKNN_ERR_OUTPUT_INVALID;
+    }
+
+    auto & tensor                 = frame[index];
+    const rknn_tensor_attr & attr = data_->output_attrs[index];
+
+    want_float        = want_float || is_float_tensor(attr);
+    bool stored_float = tensor.header.is_float || is_float_tensor(attr);
+
+    void * src      = tensor.data.data();
+    uint32_t length = tensor.header.size;
+
+    if(want_float && !stored_float) {
+        // 反量化
+        if(attr.type != RKNN_TENSOR_INT8 && attr.type != RKNN_TENSOR_UINT8) {
+            return RKNN_ERR_OUTPUT_INVALID;
+        }
+        auto & buffer = convert_buffers_[index];
+        buffer.resize(length * sizeof(float));
+        float * dst = (float *)buffer.data();
+        for(uint32_t k = 0; k < length; k++) {
+            int32_t qnt = attr.type == RKNN_TENSOR_INT8 ? (int32_t)((int8_t *)src)[k] : (int32_t)((uint8_t *)src)[k];
+            dst[k]      = ((float)qnt - (float)attr.zp) * attr.scale;
+        }
+        src    = buffer.data();
+        length = buffer.size();
+    } else if(!want_float && stored_float) {
+        // 量化
+        if(attr.type != RKNN_TENSOR_INT8 && attr.type != RKNN_TENSOR_UINT8) {
+            return RKNN_ERR_OUTPUT_INVALID;
+        }
+        auto & buffer   = convert_buffers_[index];
+        uint32_t n_elem = length / sizeof(float);
+        buffer.resize(n_elem);
+        float * values = (float *)src;
+        float min_val  = attr.type == RKNN_TENSOR_INT8 ? -128.f : 0.f;
+        float max_val  = attr.type == RKNN_TENSOR_INT8 ? 127.f : 255.f;
+        for(uint32_t k = 0; k < n_elem; k++) {
+            float qnt = std::round(values[k] / attr.scale) + attr.zp;
+            qnt       = qnt < min_val ? min_val : (qnt > max_val ? max_val : qnt);
+            if(attr.type == RKNN_TENSOR_INT8) {
+                ((int8_t *)buffer.data())[k] = (int8_t)qnt;
+            } else {
+                buffer[k] = (uint8_t)qnt;
+            }
+        }
+        src    = buffer.data();
+        length = buffer.size();
+    }
+
+    *buf  = src;
+    *size = length;
+    return RKNN_SUCC;
+}
+
+int ReplayBackend::outputs_get(uint32_t n_outputs, rknn_output outputs[])
+{
+    if(!data_ || n_outputs > data_->io_num.n_output) {
+        return RKNN_ERR_OUTPUT_INVALID;
+    }
+
+    for(uint32_t i = 0; i < n_outputs; i++) {
+        void * src      = nullptr;
+        uint32_t length = 0;
+        int ret         = get_output_tensor(outputs[i].index, outputs[i].want_float, &src, &length);
+        if(ret != RKNN_SUCC) {
+            return ret;
+        }
+
+        if(outputs[i].is_prealloc) {
+            if(outputs[i].buf == nullptr || outputs[i].size < length) {
+                return RKNN_ERR_OUTPUT_INVALID;
+            }
+            memcpy(outputs[i].buf, src, length);
+        } else {
+            outputs[i].buf  = src;
+            outputs[i].size = length;
+        }
+    }
+
+    return RKNN_SUCC;
+}
+
+int ReplayBackend::outputs_release(uint32_t n_outputs, rknn_output outputs[])
+{
+    // 输出缓冲区由回放数据持有，无需释放
+    return RKNN_SUCC;
+}
+
+// 回放后端没有设备内存，用普通堆内存模拟 rknn_tensor_mem
+rknn_tensor_mem * ReplayBackend::create_mem(uint32_t size)
+{
+    auto mem = (rknn_tensor_mem *)calloc(1, sizeof(rknn_tensor_mem));
+    if(mem == nullptr) {
+        return nullptr;
+    }
+    mem->virt_addr = aligned_alloc(64, (size + 63) / 64 * 64);
+    if(mem->virt_addr == nullptr) {
+        free(mem);
+        return nullptr;
+    }
+    mem->fd    = -1;
+    mem->size  = size;
+    mem->flags = RKNN_TENSOR_MEMORY_FLAGS_ALLOC_INSIDE;
+    return mem;
+}
+
+int ReplayBackend::destroy_mem(rknn_tensor_mem * mem)
+{
+    if(mem == nullptr) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    for(auto & output_mem : output_mems_) {
+        if(output_mem == mem) {
+            output_mem = nullptr;
+        }
+    }
+    free(mem->virt_addr);
+    free(mem);
+    return RKNN_SUCC;
+}
+
+int ReplayBackend::set_input_mem(rknn_tensor_mem * mem, rknn_tensor_attr * attr)
+{
+    if(!data_ || mem == nullptr || attr == nullptr || attr->index >= data_->io_num.n_input) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    return RKNN_SUCC;
+}
+
+int ReplayBackend::set_output_mem(rknn_tensor_mem * mem, rknn_tensor_attr * attr)
+{
+    if(!data_ || mem == nullptr || attr == nullptr || attr->index >= data_->io_num.n_output) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    output_mems_.resize(data_->io_num.n_output, nullptr);
+    output_mem_attrs_.resize(data_->io_num.n_output);
+    output_mems_[attr->index]      = mem;
+    output_mem_attrs_[attr->index] = *attr;
+    return RKNN_SUCC;
+}
+
+int ReplayBackend::mem_sync(rknn_tensor_mem * mem, rknn_mem_sync_mode mode)
+{
+    return RKNN_SUCC;
+}
+
+const char * ReplayBackend::name()
+{
+    return "replay";
+}
+
+bool ReplayBackend::require_model_data()
+{
+    return false;
+}
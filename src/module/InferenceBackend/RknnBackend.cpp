@@ -0,0 +1,177 @@
+#include "InferenceBackend.hpp"
+#include <cstring>
+
+#if USE_RKNN_RUNTIME
+
+RknnBackend::~RknnBackend()
+{
+    destroy();
+}
+
+int RknnBackend::init(void * model, uint32_t size, const char * model_path)
+{
+    int ret = rknn_init(&ctx_, model, size, 0, NULL);
+    if(ret != RKNN_SUCC) {
+        return ret;
+    }
+    recorder_ = ReplayRecorder::open(model_path, this);
+    return RKNN_SUCC;
+}
+
+int RknnBackend::dup(InferenceBackend * src)
+{
+    auto src_backend = dynamic_cast<RknnBackend *>(src);
+    if(src_backend == nullptr) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+
+    int ret = rknn_dup_context(&src_backend->ctx_, &ctx_);
+    if(ret != RKNN_SUCC) {
+        return ret;
+    }
+    recorder_ = src_backend->recorder_;
+    return RKNN_SUCC;
+}
+
+int RknnBackend::destroy()
+{
+    int ret = RKNN_SUCC;
+    if(ctx_ != 0) {
+        ret  = rknn_destroy(ctx_);
+        ctx_ = 0;
+    }
+    recorder_.reset();
+    output_mems_.clear();
+    output_mem_attrs_.clear();
+    return ret;
+}
+
+int RknnBackend::set_core_mask(rknn_core_mask core_mask)
+{
+    return rknn_set_core_mask(ctx_, core_mask);
+}
+
+int RknnBackend::query(rknn_query_cmd cmd, void * info, uint32_t size)
+{
+    return rknn_query(ctx_, cmd, info, size);
+}
+
+int RknnBackend::inputs_set(uint32_t n_inputs, rknn_input inputs[])
+{
+    return rknn_inputs_set(ctx_, n_inputs, inputs);
+}
+
+int RknnBackend::run()
+{
+    int ret = rknn_run(ctx_, nullptr);
+    if(ret != RKNN_SUCC) {
+        return ret;
+    }
+    return record_outputs();
+}
+
+int RknnBackend::run_async()
+{
+    rknn_run_extend extend;
+    memset(&extend, 0, sizeof(extend));
+    extend.non_block = 1;
+    return rknn_run(ctx_, &extend);
+}
+
+int RknnBackend::wait()
+{
+    rknn_run_extend extend;
+    memset(&extend, 0, sizeof(extend));
+    int ret = rknn_wait(ctx_, &extend);
+    if(ret != RKNN_SUCC) {
+        return ret;
+    }
+    return record_outputs();
+}
+
+int RknnBackend::record_outputs()
+{
+    if(!recorder_ || output_mems_.empty()) {
+        return RKNN_SUCC;
+    }
+
+    // 使用零拷贝输出时在这里录制
+    std::vector<rknn_output> outputs;
+    for(size_t i = 0; i < output_mems_.size(); i++) {
+        if(output_mems_[i] == nullptr) {
+            continue;
+        }
+        rknn_mem_sync(ctx_, output_mems_[i], RKNN_MEMORY_SYNC_FROM_DEVICE);
+
+        rknn_output output;
+        memset(&output, 0, sizeof(output));
+        output.index      = i;
+        output.want_float = output_mem_attrs_[i].type == RKNN_TENSOR_FLOAT32;
+        output.buf        = output_mems_[i]->virt_addr;
+        output.size       = output_mem_attrs_[i].size;
+        outputs.push_back(output);
+    }
+    recorder_->append(outputs.size(), outputs.data());
+    return RKNN_SUCC;
+}
+
+int RknnBackend::outputs_get(uint32_t n_outputs, rknn_output outputs[])
+{
+    int ret = rknn_outputs_get(ctx_, n_outputs, outputs, nullptr);
+    if(ret == RKNN_SUCC && recorder_) {
+        recorder_->append(n_outputs, outputs);
+    }
+    return ret;
+}
+
+int RknnBackend::outputs_release(uint32_t n_outputs, rknn_output outputs[])
+{
+    return rknn_outputs_release(ctx_, n_outputs, outputs);
+}
+
+rknn_tensor_mem * RknnBackend::create_mem(uint32_t size)
+{
+    return rknn_create_mem(ctx_, size);
+}
+
+int RknnBackend::destroy_mem(rknn_tensor_mem * mem)
+{
+    for(auto & output_mem : output_mems_) {
+        if(output_mem == mem) {
+            output_mem = nullptr;
+        }
+    }
+    return rknn_destroy_mem(ctx_, mem);
+}
+
+int RknnBackend::set_input_mem(rknn_tensor_mem * mem, rknn_tensor_attr * attr)
+{
+    return rknn_set_io_mem(ctx_, mem, attr);
+}
+
+int RknnBackend::set_output_mem(rknn_tensor_mem * mem, rknn_tensor_attr * attr)
+{
+    int ret = rknn_set_io_mem(ctx_, mem, attr);
+    if(ret != RKNN_SUCC || !recorder_) {
+        return ret;
+    }
+    if(attr->index >= output_mems_.size()) {
+        output_mems_.resize(attr->index + 1, nullptr);
+        output_mem_attrs_.resize(attr->index + 1);
+    }
+    output_mems_[attr->index]      = mem;
+    output_mem_attrs_[attr->index] = *attr;
+    return RKNN_SUCC;
+}
+
+int RknnBackend::mem_sync(rknn_tensor_mem * mem, rknn_mem_sync_mode mode)
+{
+    return rknn_mem_sync(ctx_, mem, mode);
+}
+
+const char * RknnBackend::name()
+{
+    return "rknn";
+}
+
+#endif
@@ -1,42 +1,12 @@
 #include "Model.hpp"
+#include "ModelRegistry.hpp"
 #include "PostProcess.hpp"
+#include "Trace.hpp"
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <iostream>
 
-static int get_core_num()
-{
-    static int core_num = 0;
-    static std::mutex mtx;
-    std::lock_guard<std::mutex> lock(mtx);
-    int temp = core_num % NPU_CORE_NUM;
-    core_num++;
-    return temp;
-}
-
-static int read_data_from_file(const char * path, char ** out_data)
-{
-    FILE * fp = fopen(path, "rb");
-    if(fp == NULL) {
-        return -1;
-    }
-    fseek(fp, 0, SEEK_END);
-    int file_size   = ftell(fp);
-    char * data     = (char *)malloc(file_size + 1);
-    data[file_size] = 0;
-    fseek(fp, 0, SEEK_SET);
-    if(file_size != fread(data, 1, file_size, fp)) {
-        free(data);
-        fclose(fp);
-        return -1;
-    }
-    if(fp) {
-        fclose(fp);
-    }
-    *out_data = data;
-    return file_size;
-}
-
 // 将量化后的数据转换为浮点数
 static float deqnt_affine_to_f32(int8_t qnt, int32_t zp, float scale)
 {
@@ -67,48 +37,69 @@ static void dump_tensor_attr(rknn_tensor_attr * attr)
            get_qnt_type_string(attr->qnt_type), attr->zp, attr->scale);
 }
 
-// ===============================================Facenet==============================================================
+// ===============================================BaseModel==============================================================
 
-Facenet::Facenet()
-{}
+BaseModel::BaseModel(const char * model_path, std::unique_ptr<InferenceBackend> backend, bool want_float)
+    : model_path_(model_path), backend_(std::move(backend)), want_float_(want_float)
+{
+    memset(&app_ctx_, 0, sizeof(app_ctx_));
+}
 
-int Facenet::init(rknn_context * ctx_in, bool is_copy)
+BaseModel::~BaseModel()
 {
-    int model_len = 0;
-    char * model;
-    int ret   = 0;
-    model_len = read_data_from_file(FACENET_MODEL_PATH, &model);
+    deinit();
+}
 
-    if(model == nullptr) {
-        std::cout << "Load model failed" << std::endl;
-        return -1;
-    }
+InferenceBackend * BaseModel::get_backend()
+{
+    return backend_.get();
+}
+
+const char * BaseModel::get_model_path()
+{
+    return model_path_;
+}
+
+rknn_core_mask BaseModel::get_core_mask()
+{
+    return core_mask_;
+}
+
+int BaseModel::init(InferenceBackend * backend_in, bool is_copy)
+{
+    TRACE_SCOPE(TraceStage::MODEL_INIT);
+
+    int ret = 0;
 
     if(is_copy) {
-        ret = rknn_dup_context(ctx_in, &ctx_);
+        // 复制已初始化的上下文，不需要再读取模型文件
+        ret = backend_->dup(backend_in);
         if(ret != RKNN_SUCC) {
             std::cout << "rknn_dup_context failed! error code = " << ret << std::endl;
             return -1;
         }
     } else {
-        std::cout << "rknn_init() is called" << std::endl;
-        ret = rknn_init(&ctx_, model, model_len, 0, NULL);
-        free(model);
+        std::shared_ptr<const model_file_t> model;
+        if(backend_->require_model_data()) {
+            model = ModelRegistry::instance().acquire(model_path_);
+            if(model == nullptr) {
+                std::cout << "Load model failed" << std::endl;
+                return -1;
+            }
+        }
+
+        std::cout << "rknn_init() is called, backend: " << backend_->name() << std::endl;
+        // rknn_init 会把模型加载到自己的内存中，返回后映射可以释放
+        ret = model ? backend_->init(model->data, model->size, model_path_) : backend_->init(nullptr, 0, model_path_);
         if(ret != RKNN_SUCC) {
             std::cout << "rknn_init failed! error code = " << ret << std::endl;
             return -1;
         }
     }
 
-    rknn_core_mask core_mask;
-
-    switch(get_core_num()) {
-        case 0: core_mask = RKNN_NPU_CORE_0; break;
-        case 1: core_mask = RKNN_NPU_CORE_1; break;
-        case 2: core_mask = RKNN_NPU_CORE_2; break;
-    }
+    core_mask_ = NpuScheduler::instance().assign_core(model_path_);
 
-    ret = rknn_set_core_mask(ctx_, core_mask);
+    ret = backend_->set_core_mask(core_mask_);
 
     if(ret < 0) {
         std::cout << "rknn_set_core_mask failed! error code = " << ret << std::endl;
@@ -117,7 +108,7 @@ int Facenet::init(rknn_context * ctx_in, bool is_copy)
 
     rknn_sdk_version version;
 
-    ret = rknn_query(ctx_, RKNN_QUERY_SDK_VERSION, &version, sizeof(rknn_sdk_version));
+    ret = backend_->query(RKNN_QUERY_SDK_VERSION, &version, sizeof(rknn_sdk_version));
     if(ret < 0) {
         return -1;
     }
@@ -125,7 +116,7 @@ int Facenet::init(rknn_context * ctx_in, bool is_copy)
     // Get Model Input Output Number
     rknn_input_output_num io_num;
 
-    ret = rknn_query(ctx_, RKNN_QUERY_IN_OUT_NUM, &io_num, sizeof(io_num));
+    ret = backend_->query(RKNN_QUERY_IN_OUT_NUM, &io_num, sizeof(io_num));
 
     if(ret != RKNN_SUCC) {
         std::cout << "rknn_query failed! error code = " << ret << std::endl;
@@ -134,13 +125,13 @@ int Facenet::init(rknn_context * ctx_in, bool is_copy)
 
     // Get Model Input Info
 
-    rknn_tensor_attr input_attrs[io_num.n_input]; // 这里使用的是变长数组，不建议这么使用
+    std::vector<rknn_tensor_attr> input_attrs(io_num.n_input);
 
-    memset(input_attrs, 0, sizeof(input_attrs));
+    memset(input_attrs.data(), 0, io_num.n_input * sizeof(rknn_tensor_attr));
 
     for(int i = 0; i < io_num.n_input; i++) {
         input_attrs[i].index = i;
-        ret                  = rknn_query(ctx_, RKNN_QUERY_INPUT_ATTR, &(input_attrs[i]), sizeof(rknn_tensor_attr));
+        ret = backend_->query(RKNN_QUERY_INPUT_ATTR, &(input_attrs[i]), sizeof(rknn_tensor_attr));
         if(ret != RKNN_SUCC) {
             std::cout << "input rknn_query failed! error code = " << ret << std::endl;
             return -1;
@@ -152,13 +143,13 @@ int Facenet::init(rknn_context * ctx_in, bool is_copy)
 
     // Get Model Output Info
 
-    rknn_tensor_attr output_attrs[io_num.n_output];
+    std::vector<rknn_tensor_attr> output_attrs(io_num.n_output);
 
-    memset(output_attrs, 0, sizeof(output_attrs));
+    memset(output_attrs.data(), 0, io_num.n_output * sizeof(rknn_tensor_attr));
 
     for(int i = 0; i < io_num.n_output; i++) {
         output_attrs[i].index = i;
-        ret                   = rknn_query(ctx_, RKNN_QUERY_OUTPUT_ATTR, &(output_attrs[i]), sizeof(rknn_tensor_attr));
+        ret = backend_->query(RKNN_QUERY_OUTPUT_ATTR, &(output_attrs[i]), sizeof(rknn_tensor_attr));
 
         if(ret != RKNN_SUCC) {
             std::cout << "output rknn_query fail! error code = " << ret << std::endl;
@@ -170,32 +161,25 @@ int Facenet::init(rknn_context * ctx_in, bool is_copy)
         }
     }
 
-    // Set to context
-    app_ctx_.rknn_ctx = ctx_;
-
     if(output_attrs[0].qnt_type == RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC && output_attrs[0].type == RKNN_TENSOR_INT8) {
-        // std::cout << "this is a quant model" << std::endl;
         app_ctx_.is_quant = true;
     } else {
-        // std::cout << "this is a float model" << std::endl;
         app_ctx_.is_quant = false;
     }
 
     app_ctx_.io_num      = io_num;
     app_ctx_.input_attrs = (rknn_tensor_attr *)malloc(io_num.n_input * sizeof(rknn_tensor_attr));
-    memcpy(app_ctx_.input_attrs, input_attrs, io_num.n_input * sizeof(rknn_tensor_attr));
+    memcpy(app_ctx_.input_attrs, input_attrs.data(), io_num.n_input * sizeof(rknn_tensor_attr));
 
     app_ctx_.output_attrs = (rknn_tensor_attr *)malloc(io_num.n_output * sizeof(rknn_tensor_attr));
-    memcpy(app_ctx_.output_attrs, output_attrs, io_num.n_output * sizeof(rknn_tensor_attr));
+    memcpy(app_ctx_.output_attrs, output_attrs.data(), io_num.n_output * sizeof(rknn_tensor_attr));
 
     // 获取模型输入的宽高和通道数
     if(input_attrs[0].fmt == RKNN_TENSOR_NCHW) {
-        // std::cout << "model is NCHW input fmt" << std::endl;
         app_ctx_.model_channel = input_attrs[0].dims[1];
         app_ctx_.model_height  = input_attrs[0].dims[2];
         app_ctx_.model_width   = input_attrs[0].dims[3];
     } else {
-        // std::cout << "model is NHWC input fmt" << std::endl;
         app_ctx_.model_height  = input_attrs[0].dims[1];
         app_ctx_.model_width   = input_attrs[0].dims[2];
         app_ctx_.model_channel = input_attrs[0].dims[3];
@@ -204,579 +188,283 @@ int Facenet::init(rknn_context * ctx_in, bool is_copy)
     if(!is_copy) {
         std::cout << "sdk version: " << version.api_version << " driver version: " << version.drv_version << std::endl;
         std::cout << "model input num: " << io_num.n_input << ", and output num: " << io_num.n_output << std::endl;
-        std::cout << "input tensors:" << std::endl;
-        std::cout << "output tensors:" << std::endl;
         std::cout << "model input height=" << app_ctx_.model_height << ", width=" << app_ctx_.model_width
                   << ", channel=" << app_ctx_.model_channel << std::endl;
     }
 
-    // 初始化输入输出参数
-    inputs_  = std::make_unique<rknn_input[]>(app_ctx_.io_num.n_input);
-    outputs_ = std::make_unique<rknn_output[]>(app_ctx_.io_num.n_output);
-
-    inputs_[0].index = 0;
-    inputs_[0].type  = RKNN_TENSOR_UINT8;
-    inputs_[0].fmt   = RKNN_TENSOR_NHWC;
-    inputs_[0].size  = app_ctx_.model_width * app_ctx_.model_height * app_ctx_.model_channel;
-    inputs_[0].buf   = nullptr;
-
-    return 0;
-}
-
-Facenet::~Facenet()
-{
-    deinit();
-}
-
-int Facenet::deinit()
-{
-    if(app_ctx_.rknn_ctx != 0) {
-        std::cout << "rknn_destroy" << std::endl;
-        rknn_destroy(app_ctx_.rknn_ctx);
-        app_ctx_.rknn_ctx = 0;
-    }
-    if(app_ctx_.input_attrs != nullptr) {
-        std::cout << "free input_attrs" << std::endl;
-        free(app_ctx_.input_attrs);
-    }
-    if(app_ctx_.output_attrs != nullptr) {
-        std::cout << "free output_attrs" << std::endl;
-        free(app_ctx_.output_attrs);
-    }
-
-    return 0;
-}
-
-rknn_context * Facenet::get_rknn_context()
-{
-    return &(this->ctx_);
-}
-
-int Facenet::inference(void * image_buf, std::vector<float> & out_fp32, letterbox_t letter_box)
-{
-    // image_buf 是 RGB888 格式，width 和 height 是模型输入的宽高
-    inputs_[0].buf = image_buf;
-
-    int ret = rknn_inputs_set(app_ctx_.rknn_ctx, app_ctx_.io_num.n_input, inputs_.get());
-    if(ret < 0) {
-        std::cout << "rknn_input_set failed! error code = " << ret << std::endl;
+    if(init_io_mem() != 0) {
         return -1;
     }
 
-    ret = rknn_run(app_ctx_.rknn_ctx, nullptr);
-    if(ret != RKNN_SUCC) {
-        std::cout << "rknn_run failed, error code = " << ret << std::endl;
+    if(init_post_process() != 0) {
+        std::cout << "init post process failed!" << std::endl;
         return -1;
     }
 
-    for(int i = 0; i < app_ctx_.io_num.n_output; i++) {
-        outputs_[i].index      = i;
-        outputs_[i].want_float = 0;
-    }
-
-    outputs_lock_.lock();
-
-    ret = rknn_outputs_get(app_ctx_.rknn_ctx, app_ctx_.io_num.n_output, outputs_.get(), nullptr);
-
-    if(ret != RKNN_SUCC) {
-        std::cout << "rknn_outputs_get failed, error code = " << ret << std::endl;
-        return -1;
-    }
-
-    uint8_t * output_data = (uint8_t *)outputs_[0].buf;
-
-    output_normalization(&app_ctx_, output_data, out_fp32);
-
-    // TODO
-    // float distance = get_duclidean_distance(old_out_fp32, out_fp32.data());
-
-    // Remeber to release rknn outputs_
-    rknn_outputs_release(app_ctx_.rknn_ctx, app_ctx_.io_num.n_output, outputs_.get());
-
-    outputs_lock_.unlock();
-
     return 0;
 }
 
-int Facenet::get_model_width()
+int BaseModel::init_io_mem()
 {
-    return app_ctx_.model_width;
-}
-
-int Facenet::get_model_height()
-{
-    return app_ctx_.model_height;
-}
-
-// ===============================================Retinaface==============================================================
-
-Retinaface::Retinaface()
-{}
-
-int Retinaface::init(rknn_context * ctx_in, bool is_copy)
-{
-    int model_len = 0;
-    char * model;
-    int ret   = 0;
-    model_len = read_data_from_file(RETINA_FACE_MODEL_PATH, &model);
-
-    if(model == nullptr) {
-        std::cout << "Load model failed" << std::endl;
+    // 输入: NHWC uint8，按 w_stride 对齐
+    rknn_tensor_attr input_attr = app_ctx_.input_attrs[0];
+    input_attr.type             = RKNN_TENSOR_UINT8;
+    input_attr.fmt              = RKNN_TENSOR_NHWC;
+
+    int w_stride        = input_attr.w_stride > 0 ? input_attr.w_stride : app_ctx_.model_width;
+    input_stride_       = w_stride * app_ctx_.model_channel;
+    uint32_t input_size = std::max(input_attr.size_with_stride, (uint32_t)(input_stride_ * app_ctx_.model_height));
+
+    input_mem_ = backend_->create_mem(input_size);
+    if(input_mem_ == nullptr) {
+        std::cout << "rknn_create_mem failed!" << std::endl;
         return -1;
     }
 
-    if(is_copy) {
-        ret = rknn_dup_context(ctx_in, &ctx_);
-        if(ret != RKNN_SUCC) {
-            std::cout << "rknn_dup_context failed! error code = " << ret << std::endl;
-            return -1;
-        }
-    } else {
-        std::cout << "rknn_init() is called" << std::endl;
-        ret = rknn_init(&ctx_, model, model_len, 0, NULL);
-        free(model);
-        if(ret != RKNN_SUCC) {
-            std::cout << "rknn_init failed! error code = " << ret << std::endl;
-            return -1;
-        }
-    }
-
-    rknn_core_mask core_mask;
-
-    switch(get_core_num()) {
-        case 0: core_mask = RKNN_NPU_CORE_0; break;
-        case 1: core_mask = RKNN_NPU_CORE_1; break;
-        case 2: core_mask = RKNN_NPU_CORE_2; break;
-    }
-
-    ret = rknn_set_core_mask(ctx_, core_mask);
-
-    if(ret < 0) {
-        std::cout << "rknn_set_core_mask failed! error code = " << ret << std::endl;
-        return -1;
-    }
-
-    rknn_sdk_version version;
-
-    ret = rknn_query(ctx_, RKNN_QUERY_SDK_VERSION, &version, sizeof(rknn_sdk_version));
-    if(ret < 0) {
-        return -1;
-    }
-
-    // Get Model Input Output Number
-    rknn_input_output_num io_num;
-
-    ret = rknn_query(ctx_, RKNN_QUERY_IN_OUT_NUM, &io_num, sizeof(io_num));
-
+    int ret = backend_->set_input_mem(input_mem_, &input_attr);
     if(ret != RKNN_SUCC) {
-        std::cout << "rknn_query failed! error code = " << ret << std::endl;
+        std::cout << "input rknn_set_io_mem failed! error code = " << ret << std::endl;
         return -1;
     }
 
-    // Get Model Input Info
+    // 输出
+    outputs_ = std::make_unique<rknn_output[]>(app_ctx_.io_num.n_output);
+    output_mems_.resize(app_ctx_.io_num.n_output, nullptr);
 
-    rknn_tensor_attr input_attrs[io_num.n_input]; // 这里使用的是变长数组，不建议这么使用
+    bool want_float = want_float_ || !app_ctx_.is_quant;
 
-    memset(input_attrs, 0, sizeof(input_attrs));
+    for(int i = 0; i < app_ctx_.io_num.n_output; i++) {
+        rknn_tensor_attr output_attr = app_ctx_.output_attrs[i];
+        if(want_float) {
+            output_attr.type = RKNN_TENSOR_FLOAT32;
+            output_attr.size = output_attr.n_elems * sizeof(float);
+        }
 
-    for(int i = 0; i < io_num.n_input; i++) {
-        input_attrs[i].index = i;
-        ret                  = rknn_query(ctx_, RKNN_QUERY_INPUT_ATTR, &(input_attrs[i]), sizeof(rknn_tensor_attr));
-        if(ret != RKNN_SUCC) {
-            std::cout << "input rknn_query failed! error code = " << ret << std::endl;
+        output_mems_[i] = backend_->create_mem(output_attr.size);
+        if(output_mems_[i] == nullptr) {
+            std::cout << "rknn_create_mem failed!" << std::endl;
             return -1;
         }
-        if(!is_copy) {
-            dump_tensor_attr(&(input_attrs[i]));
-        }
-    }
-
-    // Get Model Output Info
-
-    rknn_tensor_attr output_attrs[io_num.n_output];
-
-    memset(output_attrs, 0, sizeof(output_attrs));
-
-    for(int i = 0; i < io_num.n_output; i++) {
-        output_attrs[i].index = i;
-        ret                   = rknn_query(ctx_, RKNN_QUERY_OUTPUT_ATTR, &(output_attrs[i]), sizeof(rknn_tensor_attr));
 
+        ret = backend_->set_output_mem(output_mems_[i], &output_attr);
         if(ret != RKNN_SUCC) {
-            std::cout << "output rknn_query fail! error code = " << ret << std::endl;
+            std::cout << "output rknn_set_io_mem failed! error code = " << ret << std::endl;
             return -1;
         }
 
-        if(!is_copy) {
-            dump_tensor_attr(&(output_attrs[i]));
-        }
-    }
-
-    // Set to context
-    app_ctx_.rknn_ctx = ctx_;
-
-    if(output_attrs[0].qnt_type == RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC && output_attrs[0].type == RKNN_TENSOR_INT8) {
-        // std::cout << "this is a quant model" << std::endl;
-        app_ctx_.is_quant = true;
-    } else {
-        // std::cout << "this is a float model" << std::endl;
-        app_ctx_.is_quant = false;
-    }
-
-    app_ctx_.io_num      = io_num;
-    app_ctx_.input_attrs = (rknn_tensor_attr *)malloc(io_num.n_input * sizeof(rknn_tensor_attr));
-    memcpy(app_ctx_.input_attrs, input_attrs, io_num.n_input * sizeof(rknn_tensor_attr));
-
-    app_ctx_.output_attrs = (rknn_tensor_attr *)malloc(io_num.n_output * sizeof(rknn_tensor_attr));
-    memcpy(app_ctx_.output_attrs, output_attrs, io_num.n_output * sizeof(rknn_tensor_attr));
-
-    // 获取模型输入的宽高和通道数
-    if(input_attrs[0].fmt == RKNN_TENSOR_NCHW) {
-        // std::cout << "model is NCHW input fmt" << std::endl;
-        app_ctx_.model_channel = input_attrs[0].dims[1];
-        app_ctx_.model_height  = input_attrs[0].dims[2];
-        app_ctx_.model_width   = input_attrs[0].dims[3];
-    } else {
-        // std::cout << "model is NHWC input fmt" << std::endl;
-        app_ctx_.model_height  = input_attrs[0].dims[1];
-        app_ctx_.model_width   = input_attrs[0].dims[2];
-        app_ctx_.model_channel = input_attrs[0].dims[3];
-    }
-
-    if(!is_copy) {
-        std::cout << "sdk version: " << version.api_version << " driver version: " << version.drv_version << std::endl;
-        std::cout << "model input num: " << io_num.n_input << ", and output num: " << io_num.n_output << std::endl;
-        std::cout << "input tensors:" << std::endl;
-        std::cout << "output tensors:" << std::endl;
-        std::cout << "model input height=" << app_ctx_.model_height << ", width=" << app_ctx_.model_width
-                  << ", channel=" << app_ctx_.model_channel << std::endl;
+        memset(&outputs_[i], 0, sizeof(rknn_output));
+        outputs_[i].index      = i;
+        outputs_[i].want_float = want_float;
+        outputs_[i].buf        = output_mems_[i]->virt_addr;
+        outputs_[i].size       = output_attr.size;
     }
 
-    // 初始化输入输出参数
-    inputs_  = std::make_unique<rknn_input[]>(app_ctx_.io_num.n_input);
-    outputs_ = std::make_unique<rknn_output[]>(app_ctx_.io_num.n_output);
-
-    inputs_[0].index = 0;
-    inputs_[0].type  = RKNN_TENSOR_UINT8;
-    inputs_[0].fmt   = RKNN_TENSOR_NHWC;
-    inputs_[0].size  = app_ctx_.model_width * app_ctx_.model_height * app_ctx_.model_channel;
-    inputs_[0].buf   = nullptr;
-
     return 0;
 }
 
-Retinaface::~Retinaface()
+void BaseModel::release_io_mem()
 {
-    deinit();
+    if(input_mem_ != nullptr) {
+        backend_->destroy_mem(input_mem_);
+        input_mem_ = nullptr;
+    }
+    for(auto & mem : output_mems_) {
+        if(mem != nullptr) {
+            backend_->destroy_mem(mem);
+            mem = nullptr;
+        }
+    }
+    output_mems_.clear();
+    outputs_.reset();
 }
 
-int Retinaface::deinit()
+int BaseModel::deinit()
 {
-    if(app_ctx_.rknn_ctx != 0) {
-        std::cout << "rknn_destroy" << std::endl;
-        rknn_destroy(app_ctx_.rknn_ctx);
-        app_ctx_.rknn_ctx = 0;
+    if(backend_) {
+        release_io_mem();
+        backend_->destroy();
+    }
+    if(core_mask_ != RKNN_NPU_CORE_AUTO) {
+        NpuScheduler::instance().release_core(core_mask_);
+        core_mask_ = RKNN_NPU_CORE_AUTO;
     }
     if(app_ctx_.input_attrs != nullptr) {
-        std::cout << "free input_attrs" << std::endl;
         free(app_ctx_.input_attrs);
+        app_ctx_.input_attrs = nullptr;
     }
     if(app_ctx_.output_attrs != nullptr) {
-        std::cout << "free output_attrs" << std::endl;
         free(app_ctx_.output_attrs);
+        app_ctx_.output_attrs = nullptr;
     }
 
     return 0;
 }
 
-rknn_context * Retinaface::get_rknn_context()
+int BaseModel::run_inference(const cv::Mat & image, ImageProcess & image_process)
 {
-    return &(this->ctx_);
+    if(submit(image, image_process) != 0) {
+        return -1;
+    }
+    return wait_outputs();
 }
 
-int Retinaface::inference(void * image_buf, retinaface_result * results, letterbox_t letter_box)
+int BaseModel::submit(const cv::Mat & image, ImageProcess & image_process)
 {
-    // image_buf 是 RGB888 格式，width 和 height 是模型输入的宽高
-    inputs_[0].buf = image_buf;
+    if(input_mem_ == nullptr) {
+        return -1;
+    }
 
-    int ret = rknn_inputs_set(app_ctx_.rknn_ctx, app_ctx_.io_num.n_input, inputs_.get());
-    if(ret < 0) {
-        std::cout << "rknn_input_set failed! error code = " << ret << std::endl;
+    // 预处理结果直接写入输入内存，省去 rknn_inputs_set 的拷贝
+    if(image_process.convert(image, input_mem_->virt_addr, input_stride_) != 0) {
         return -1;
     }
+    backend_->mem_sync(input_mem_, RKNN_MEMORY_SYNC_TO_DEVICE);
 
-    ret = rknn_run(app_ctx_.rknn_ctx, nullptr);
+    NpuScheduler::instance().begin_run(core_mask_);
+    run_start_ns_ = trace_now_ns();
+    int ret       = backend_->run_async();
     if(ret != RKNN_SUCC) {
+        NpuScheduler::instance().end_run(core_mask_);
         std::cout << "rknn_run failed, error code = " << ret << std::endl;
         return -1;
     }
+    return 0;
+}
 
-    for(int i = 0; i < app_ctx_.io_num.n_output; i++) {
-        outputs_[i].index      = i;
-        outputs_[i].want_float = 1;
-        // outputs_[i].want_float = (!app_ctx_.is_quant);
+int BaseModel::wait_outputs()
+{
+    int ret            = backend_->wait();
+    int64_t run_end_ns = trace_now_ns();
+    NpuScheduler::instance().end_run(core_mask_);
+    trace_record(TraceStage::NPU_RUN, run_start_ns_, run_end_ns);
+    if(ret != RKNN_SUCC) {
+        std::cout << "rknn_wait failed, error code = " << ret << std::endl;
+        return -1;
     }
 
-    outputs_lock_.lock();
+    // 零拷贝输出下 rknn_outputs_get 由输出内存同步代替
+    for(auto mem : output_mems_) {
+        backend_->mem_sync(mem, RKNN_MEMORY_SYNC_FROM_DEVICE);
+    }
+    trace_record(TraceStage::NPU_OUTPUT, run_end_ns, trace_now_ns());
 
-    ret = rknn_outputs_get(app_ctx_.rknn_ctx, app_ctx_.io_num.n_output, outputs_.get(), nullptr);
+    return 0;
+}
 
-    if(ret != RKNN_SUCC) {
-        std::cout << "rknn_outputs_get failed, error code = " << ret << std::endl;
+int BaseModel::warm_up()
+{
+    if(input_mem_ == nullptr) {
         return -1;
     }
+    TRACE_SCOPE(TraceStage::MODEL_WARM_UP);
 
-    // Post Process
-    retinaface_post_process(&app_ctx_, outputs_.get(), &letter_box, results);
-
-    // Remeber to release rknn outputs_
-    rknn_outputs_release(app_ctx_.rknn_ctx, app_ctx_.io_num.n_output, outputs_.get());
-
-    outputs_lock_.unlock();
+    memset(input_mem_->virt_addr, 0, input_mem_->size);
+    backend_->mem_sync(input_mem_, RKNN_MEMORY_SYNC_TO_DEVICE);
 
+    int ret = backend_->run();
+    if(ret != RKNN_SUCC) {
+        std::cout << "warm up rknn_run failed, error code = " << ret << std::endl;
+        return -1;
+    }
+    for(auto mem : output_mems_) {
+        backend_->mem_sync(mem, RKNN_MEMORY_SYNC_FROM_DEVICE);
+    }
     return 0;
 }
 
-int Retinaface::get_model_width()
+int BaseModel::get_model_width()
 {
     return app_ctx_.model_width;
 }
 
-int Retinaface::get_model_height()
+int BaseModel::get_model_height()
 {
     return app_ctx_.model_height;
 }
 
-// ================================================Yolo11============================================================
+// ===============================================Facenet==============================================================
 
-Yolo11::Yolo11()
+Facenet::Facenet(std::unique_ptr<InferenceBackend> backend)
+    : BaseModel(FACENET_MODEL_PATH, std::move(backend), false)
 {}
 
-int Yolo11::init(rknn_context * ctx_in, bool is_copy)
+int Facenet::inference(const cv::Mat & image, ImageProcess & image_process, std::vector<float> & out_fp32)
 {
-    int model_len = 0;
-    char * model;
-    int ret   = 0;
-    model_len = read_data_from_file(YOLO11_MODEL_PATH, &model);
-
-    if(model == nullptr) {
-        std::cout << "Load model failed" << std::endl;
+    if(submit(image, image_process) != 0) {
         return -1;
     }
+    return get_result(out_fp32);
+}
 
-    if(is_copy) {
-        ret = rknn_dup_context(ctx_in, &ctx_);
-        if(ret != RKNN_SUCC) {
-            std::cout << "rknn_dup_context failed! error code = " << ret << std::endl;
-            return -1;
-        }
-    } else {
-        std::cout << "rknn_init() is called" << std::endl;
-        ret = rknn_init(&ctx_, model, model_len, 0, NULL);
-        free(model);
-        if(ret != RKNN_SUCC) {
-            std::cout << "rknn_init failed! error code = " << ret << std::endl;
-            return -1;
-        }
-    }
-
-    rknn_core_mask core_mask;
-
-    switch(get_core_num()) {
-        case 0: core_mask = RKNN_NPU_CORE_0; break;
-        case 1: core_mask = RKNN_NPU_CORE_1; break;
-        case 2: core_mask = RKNN_NPU_CORE_2; break;
-    }
-
-    ret = rknn_set_core_mask(ctx_, core_mask);
-
-    if(ret < 0) {
-        std::cout << "rknn_set_core_mask failed! error code = " << ret << std::endl;
-        return -1;
-    }
-
-    rknn_sdk_version version;
-
-    ret = rknn_query(ctx_, RKNN_QUERY_SDK_VERSION, &version, sizeof(rknn_sdk_version));
-    if(ret < 0) {
-        return -1;
-    }
-
-    // Get Model Input Output Number
-    rknn_input_output_num io_num;
-
-    ret = rknn_query(ctx_, RKNN_QUERY_IN_OUT_NUM, &io_num, sizeof(io_num));
-
-    if(ret != RKNN_SUCC) {
-        std::cout << "rknn_query failed! error code = " << ret << std::endl;
+int Facenet::get_result(std::vector<float> & out_fp32)
+{
+    if(wait_outputs() != 0) {
         return -1;
     }
 
-    rknn_tensor_attr input_attrs[io_num.n_input]; // 这里使用的是变长数组，不建议这么使用
-
-    memset(input_attrs, 0, sizeof(input_attrs));
-
-    for(int i = 0; i < io_num.n_input; i++) {
-        input_attrs[i].index = i;
-        ret                  = rknn_query(ctx_, RKNN_QUERY_INPUT_ATTR, &(input_attrs[i]), sizeof(rknn_tensor_attr));
-        if(ret != RKNN_SUCC) {
-            std::cout << "input rknn_query failed! error code = " << ret << std::endl;
-            return -1;
-        }
-        if(!is_copy) {
-            dump_tensor_attr(&(input_attrs[i]));
-        }
-    }
-
-    // Get Model Output Info
-
-    rknn_tensor_attr output_attrs[io_num.n_output];
-
-    memset(output_attrs, 0, sizeof(output_attrs));
-
-    for(int i = 0; i < io_num.n_output; i++) {
-        output_attrs[i].index = i;
-        ret                   = rknn_query(ctx_, RKNN_QUERY_OUTPUT_ATTR, &(output_attrs[i]), sizeof(rknn_tensor_attr));
-
-        if(ret != RKNN_SUCC) {
-            std::cout << "output rknn_query fail! error code = " << ret << std::endl;
-            return -1;
-        }
-
-        if(!is_copy) {
-            dump_tensor_attr(&(output_attrs[i]));
-        }
-    }
+    uint8_t * output_data = (uint8_t *)outputs_[0].buf;
 
-    // Set to context
-    app_ctx_.rknn_ctx = ctx_;
+    output_normalization(&app_ctx_, output_data, out_fp32);
 
-    if(output_attrs[0].qnt_type == RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC && output_attrs[0].type == RKNN_TENSOR_INT8) {
-        app_ctx_.is_quant = true;
-    } else {
-        app_ctx_.is_quant = false;
-    }
+    return 0;
+}
 
-    app_ctx_.io_num      = io_num;
-    app_ctx_.input_attrs = (rknn_tensor_attr *)malloc(io_num.n_input * sizeof(rknn_tensor_attr));
-    memcpy(app_ctx_.input_attrs, input_attrs, io_num.n_input * sizeof(rknn_tensor_attr));
+// ===============================================Retinaface==============================================================
 
-    app_ctx_.output_attrs = (rknn_tensor_attr *)malloc(io_num.n_output * sizeof(rknn_tensor_attr));
-    memcpy(app_ctx_.output_attrs, output_attrs, io_num.n_output * sizeof(rknn_tensor_attr));
+Retinaface::Retinaface(std::unique_ptr<InferenceBackend> backend)
+    : BaseModel(RETINA_FACE_MODEL_PATH, std::move(backend), true)
+{}
 
-    // 获取模型输入的宽高和通道数
-    if(input_attrs[0].fmt == RKNN_TENSOR_NCHW) {
-        app_ctx_.model_channel = input_attrs[0].dims[1];
-        app_ctx_.model_height  = input_attrs[0].dims[2];
-        app_ctx_.model_width   = input_attrs[0].dims[3];
-    } else {
-        app_ctx_.model_height  = input_attrs[0].dims[1];
-        app_ctx_.model_width   = input_attrs[0].dims[2];
-        app_ctx_.model_channel = input_attrs[0].dims[3];
-    }
+int Retinaface::init_post_process()
+{
+    return init_retinaface_decoder(&app_ctx_, &decoder_);
+}
 
-    if(!is_copy) {
-        std::cout << "sdk version: " << version.api_version << " driver version: " << version.drv_version << std::endl;
-        std::cout << "model input num: " << io_num.n_input << ", and output num: " << io_num.n_output << std::endl;
-        std::cout << "input tensors:" << std::endl;
-        std::cout << "model input height=" << app_ctx_.model_height << ", width=" << app_ctx_.model_width
-                  << ", channel=" << app_ctx_.model_channel << std::endl;
+int Retinaface::inference(const cv::Mat & image, ImageProcess & image_process, retinaface_result * results)
+{
+    if(run_inference(image, image_process) != 0) {
+        return -1;
     }
 
-    // 初始化输入输出参数
-    inputs_  = std::make_unique<rknn_input[]>(app_ctx_.io_num.n_input);
-    outputs_ = std::make_unique<rknn_output[]>(app_ctx_.io_num.n_output);
+    letterbox_t letter_box = image_process.get_letter_box();
 
-    inputs_[0].index = 0;
-    inputs_[0].type  = RKNN_TENSOR_UINT8;
-    inputs_[0].fmt   = RKNN_TENSOR_NHWC;
-    inputs_[0].size  = app_ctx_.model_width * app_ctx_.model_height * app_ctx_.model_channel;
-    inputs_[0].buf   = nullptr;
+    // Post Process
+    retinaface_post_process(&app_ctx_, outputs_.get(), &letter_box, &decoder_, results);
 
     return 0;
 }
 
-Yolo11::~Yolo11()
-{
-    deinit();
-}
-
-int Yolo11::deinit()
-{
-    if(app_ctx_.rknn_ctx != 0) {
-        std::cout << "rknn_destroy" << std::endl;
-        rknn_destroy(app_ctx_.rknn_ctx);
-        app_ctx_.rknn_ctx = 0;
-    }
-    if(app_ctx_.input_attrs != nullptr) {
-        std::cout << "free input_attrs" << std::endl;
-        free(app_ctx_.input_attrs);
-    }
-    if(app_ctx_.output_attrs != nullptr) {
-        std::cout << "free output_attrs" << std::endl;
-        free(app_ctx_.output_attrs);
-    }
+// ================================================Yolo11============================================================
 
-    return 0;
-}
+Yolo11::Yolo11(std::unique_ptr<InferenceBackend> backend) : BaseModel(YOLO11_MODEL_PATH, std::move(backend), false)
+{}
 
-rknn_context * Yolo11::get_rknn_context()
+int Yolo11::init_post_process()
 {
-    return &(this->ctx_);
+    return init_yolo_workspace(&app_ctx_, &workspace_);
 }
 
-int Yolo11::inference(void * image_buf, yolo_result_list * results, letterbox_t letter_box)
+int Yolo11::inference(const cv::Mat & image, ImageProcess & image_process, yolo_result_list * results)
 {
-
-    inputs_[0].buf = image_buf;
-
-    int ret = rknn_inputs_set(app_ctx_.rknn_ctx, app_ctx_.io_num.n_input, inputs_.get());
-    if(ret < 0) {
-        std::cout << "rknn_input_set failed! error code = " << ret << std::endl;
-        return -1;
-    }
-
-    ret = rknn_run(app_ctx_.rknn_ctx, nullptr);
-    if(ret != RKNN_SUCC) {
-        std::cout << "rknn_run failed, error code = " << ret << std::endl;
+    if(submit(image, image_process) != 0) {
         return -1;
     }
+    return get_result(image_process, results);
+}
 
-    for(int i = 0; i < app_ctx_.io_num.n_output; i++) {
-        outputs_[i].index      = i;
-        outputs_[i].want_float = (!app_ctx_.is_quant);
-    }
-
-    outputs_lock_.lock();
-
-    ret = rknn_outputs_get(app_ctx_.rknn_ctx, app_ctx_.io_num.n_output, outputs_.get(), nullptr);
-
-    if(ret != RKNN_SUCC) {
-        std::cout << "rknn_outputs_get failed, error code = " << ret << std::endl;
+int Yolo11::get_result(ImageProcess & image_process, yolo_result_list * results)
+{
+    if(wait_outputs() != 0) {
         return -1;
     }
 
-    //
+    letterbox_t letter_box = image_process.get_letter_box();
 
     const float nms_threshold      = NMS_THRESH; // 默认的NMS阈值
     const float box_conf_threshold = BOX_THRESH; // 默认的置信度阈值
 
     // Post Process
-    yolo_post_process(&app_ctx_, outputs_.get(), &letter_box, box_conf_threshold, nms_threshold, results);
-
-    // Remeber to release rknn outputs_
-    rknn_outputs_release(app_ctx_.rknn_ctx, app_ctx_.io_num.n_output, outputs_.get());
-
-    outputs_lock_.unlock();
+    yolo_post_process(&app_ctx_, outputs_.get(), &letter_box, box_conf_threshold, nms_threshold, &workspace_, results);
 
     return 0;
 }
-
-int Yolo11::get_model_width()
-{
-    return app_ctx_.model_width;
-}
-
-int Yolo11::get_model_height()
-{
-    return app_ctx_.model_height;
-}
@@ -0,0 +1,67 @@
+#include "ModelRegistry.hpp"
+#include <cstdio>
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+ModelRegistry & ModelRegistry::instance()
+{
+    static ModelRegistry registry;
+    return registry;
+}
+
+static model_file_t * map_model_file(const char * path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        perror(path);
+        return nullptr;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) < 0 || st.st_size == 0) {
+        perror(path);
+        close(fd);
+        return nullptr;
+    }
+
+    // 私有映射: 运行时即使改写缓冲区也只复制被改写的页，不会影响文件
+    void * data = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    // 映射建立后文件描述符不再需要
+    close(fd);
+    if(data == MAP_FAILED) {
+        perror("mmap");
+        return nullptr;
+    }
+    // rknn_init 会读完整个模型，提前预读
+    madvise(data, st.st_size, MADV_WILLNEED);
+
+    return new model_file_t{data, (size_t)st.st_size};
+}
+
+std::shared_ptr<const model_file_t> ModelRegistry::acquire(const char * path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto & entry = files_[path];
+    if(auto file = entry.lock()) {
+        return file;
+    }
+
+    model_file_t * mapped = map_model_file(path);
+    if(mapped == nullptr) {
+        files_.erase(path);
+        return nullptr;
+    }
+
+    std::shared_ptr<const model_file_t> file(mapped, [](const model_file_t * file) {
+        munmap(file->data, file->size);
+        delete file;
+    });
+    entry = file;
+    return file;
+}
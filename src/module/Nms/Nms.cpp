@@ -0,0 +1,175 @@
+#include "Nms.hpp"
+#include <algorithm>
+#include <cmath>
+
+// 默认候选框数量达到该值时使用网格
+#define NMS_GRID_MIN_COUNT 256
+// 网格每个方向的最大格子数
+#define NMS_GRID_MAX_CELLS 64
+
+// 计算重叠区域，宽高按像素 +1
+static float calculate_overlap(const nms_candidate_t & a, const nms_candidate_t & b)
+{
+    float w = fmax(0.f, fmin(a.x2, b.x2) - fmax(a.x1, b.x1) + 1);
+    float h = fmax(0.f, fmin(a.y2, b.y2) - fmax(a.y1, b.y1) + 1);
+    float i = w * h;
+    float u = (a.x2 - a.x1 + 1) * (a.y2 - a.y1 + 1) + (b.x2 - b.x1 + 1) * (b.y2 - b.y1 + 1) - i;
+    return u <= 0.f ? 0.f : (i / u);
+}
+
+Nms::Nms(int capacity) : grid_min_count_(NMS_GRID_MIN_COUNT)
+{
+    candidates_.reserve(capacity);
+    order_.reserve(capacity);
+}
+
+void Nms::clear()
+{
+    candidates_.clear();
+}
+
+void Nms::push(const nms_candidate_t & candidate)
+{
+    candidates_.push_back(candidate);
+}
+
+int Nms::size() const
+{
+    return candidates_.size();
+}
+
+void Nms::set_grid_cell_size(float cell_size)
+{
+    grid_cell_size_ = cell_size;
+}
+
+void Nms::set_grid_min_count(int min_count)
+{
+    grid_min_count_ = min_count;
+}
+
+int Nms::run(float iou_threshold, int top_k, int * keep)
+{
+    int count = candidates_.size();
+    if(count == 0 || top_k <= 0) {
+        return 0;
+    }
+
+    order_.resize(count);
+    for(int i = 0; i < count; i++) {
+        order_[i] = i;
+    }
+    // 稳定排序，分数相同时保持候选框原来的顺序
+    std::stable_sort(order_.begin(), order_.end(),
+                     [this](int a, int b) { return candidates_[a].score > candidates_[b].score; });
+
+    bool is_grid = grid_min_count_ >= 0 && count >= grid_min_count_;
+    if(is_grid) {
+        init_grid();
+    }
+
+    kept_.clear();
+    for(int i = 0; i < count && (int)kept_.size() < top_k; i++) {
+        int n                             = order_[i];
+        const nms_candidate_t & candidate = candidates_[n];
+
+        bool suppressed =
+            is_grid ? is_suppressed_grid(candidate, iou_threshold) : is_suppressed(candidate, iou_threshold);
+        if(suppressed) {
+            continue;
+        }
+
+        kept_.push_back(n);
+        if(is_grid) {
+            insert_grid(kept_.size() - 1);
+        }
+    }
+
+    for(size_t i = 0; i < kept_.size(); i++) {
+        keep[i] = candidates_[kept_[i]].index;
+    }
+    return kept_.size();
+}
+
+bool Nms::is_suppressed(const nms_candidate_t & candidate, float iou_threshold)
+{
+    for(int k : kept_) {
+        const nms_candidate_t & kept = candidates_[k];
+        if(kept.class_id == candidate.class_id && calculate_overlap(kept, candidate) > iou_threshold) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Nms::init_grid()
+{
+    float x_min    = candidates_[0].x1;
+    float y_min    = candidates_[0].y1;
+    float x_max    = candidates_[0].x2;
+    float y_max    = candidates_[0].y2;
+    float size_sum = 0;
+    for(auto & c : candidates_) {
+        x_min = std::min(x_min, c.x1);
+        y_min = std::min(y_min, c.y1);
+        x_max = std::max(x_max, c.x2);
+        y_max = std::max(y_max, c.y2);
+        size_sum += std::max(c.x2 - c.x1, c.y2 - c.y1);
+    }
+
+    float cell = grid_cell_size_ > 0 ? grid_cell_size_ : size_sum / candidates_.size();
+    // 宽高 +1 的框在 1 像素间隔时仍然相交，范围向外扩 1
+    float extent = std::max(x_max - x_min, y_max - y_min) + 2;
+    cell         = std::max(cell, extent / NMS_GRID_MAX_CELLS);
+    cell         = std::max(cell, 1.f);
+
+    grid_x0_   = x_min - 1;
+    grid_y0_   = y_min - 1;
+    grid_cell_ = cell;
+    grid_w_    = std::min(NMS_GRID_MAX_CELLS, (int)((x_max - x_min + 2) / cell) + 1);
+    grid_h_    = std::min(NMS_GRID_MAX_CELLS, (int)((y_max - y_min + 2) / cell) + 1);
+
+    cell_heads_.assign(grid_w_ * grid_h_, -1);
+    entry_next_.clear();
+    entry_kept_.clear();
+}
+
+// 把已保留的框加入它覆盖的所有格子
+void Nms::insert_grid(int kept_index)
+{
+    const nms_candidate_t & c = candidates_[kept_[kept_index]];
+
+    int cx0 = std::max(0, (int)((c.x1 - grid_x0_) / grid_cell_));
+    int cy0 = std::max(0, (int)((c.y1 - grid_y0_) / grid_cell_));
+    int cx1 = std::min(grid_w_ - 1, (int)((c.x2 + 1 - grid_x0_) / grid_cell_));
+    int cy1 = std::min(grid_h_ - 1, (int)((c.y2 + 1 - grid_y0_) / grid_cell_));
+
+    for(int y = cy0; y <= cy1; y++) {
+        for(int x = cx0; x <= cx1; x++) {
+            int cell = y * grid_w_ + x;
+            entry_next_.push_back(cell_heads_[cell]);
+            entry_kept_.push_back(kept_index);
+            cell_heads_[cell] = entry_next_.size() - 1;
+        }
+    }
+}
+
+bool Nms::is_suppressed_grid(const nms_candidate_t & candidate, float iou_threshold)
+{
+    int cx0 = std::max(0, (int)((candidate.x1 - grid_x0_) / grid_cell_));
+    int cy0 = std::max(0, (int)((candidate.y1 - grid_y0_) / grid_cell_));
+    int cx1 = std::min(grid_w_ - 1, (int)((candidate.x2 + 1 - grid_x0_) / grid_cell_));
+    int cy1 = std::min(grid_h_ - 1, (int)((candidate.y2 + 1 - grid_y0_) / grid_cell_));
+
+    for(int y = cy0; y <= cy1; y++) {
+        for(int x = cx0; x <= cx1; x++) {
+            for(int e = cell_heads_[y * grid_w_ + x]; e != -1; e = entry_next_[e]) {
+                const nms_candidate_t & kept = candidates_[kept_[entry_kept_[e]]];
+                if(kept.class_id == candidate.class_id && calculate_overlap(kept, candidate) > iou_threshold) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,323 @@
+#include "NpuScheduler.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+NpuScheduler & NpuScheduler::instance()
+{
+    static NpuScheduler scheduler;
+    return scheduler;
+}
+
+NpuScheduler::NpuScheduler() : window_start_ns_(trace_now_ns()), last_report_ns_(window_start_ns_)
+{
+    const char * env = getenv(NPU_MULTI_CORE_MODELS_ENV);
+    if(env == nullptr) {
+        return;
+    }
+    std::stringstream models(env);
+    std::string model;
+    while(std::getline(models, model, ',')) {
+        if(!model.empty()) {
+            multi_core_models_.push_back(model);
+        }
+    }
+}
+
+// 按文件名匹配，不区分目录
+static bool match_model(const std::vector<std::string> & models, const char * model_path)
+{
+    const char * name = strrchr(model_path, '/');
+    name              = name ? name + 1 : model_path;
+    return std::find(models.begin(), models.end(), name) != models.end();
+}
+
+rknn_core_mask NpuScheduler::assign_core(const char * model_path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if(model_path != nullptr && match_model(multi_core_models_, model_path)) {
+        for(auto & core : cores_) {
+            core.contexts++;
+        }
+        return RKNN_NPU_CORE_0_1_2;
+    }
+
+    int core_id = 0;
+    for(int i = 1; i < NPU_CORE_NUM; i++) {
+        if(cores_[i].contexts < cores_[core_id].contexts) {
+            core_id = i;
+        }
+    }
+    cores_[core_id].contexts++;
+    return (rknn_core_mask)(RKNN_NPU_CORE_0 << core_id);
+}
+
+void NpuScheduler::release_core(rknn_core_mask core_mask)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(int i = 0; i < NPU_CORE_NUM; i++) {
+        if(core_mask & (RKNN_NPU_CORE_0 << i)) {
+            cores_[i].contexts--;
+        }
+    }
+}
+
+void NpuScheduler::begin_task(rknn_core_mask core_mask)
+{
+    for(int i = 0; i < NPU_CORE_NUM; i++) {
+        if(core_mask & (RKNN_NPU_CORE_0 << i)) {
+            cores_[i].tasks++;
+        }
+    }
+}
+
+void NpuScheduler::end_task(rknn_core_mask core_mask)
+{
+    for(int i = 0; i < NPU_CORE_NUM; i++) {
+        if(core_mask & (RKNN_NPU_CORE_0 << i)) {
+            cores_[i].tasks--;
+        }
+    }
+}
+
+int NpuScheduler::get_load(rknn_core_mask core_mask)
+{
+    int load = 0;
+    for(int i = 0; i < NPU_CORE_NUM; i++) {
+        if(core_mask & (RKNN_NPU_CORE_0 << i)) {
+            load += cores_[i].tasks;
+        }
+    }
+    return load;
+}
+
+void NpuScheduler::begin_run(rknn_core_mask core_mask)
+{
+    int64_t now_ns = trace_now_ns();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(int i = 0; i < NPU_CORE_NUM; i++) {
+        if(core_mask & (RKNN_NPU_CORE_0 << i)) {
+            auto & core = cores_[i];
+            if(core.running++ == 0) {
+                core.busy_since_ns = now_ns;
+            }
+        }
+    }
+}
+
+void NpuScheduler::end_run(rknn_core_mask core_mask)
+{
+    int64_t now_ns = trace_now_ns();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(int i = 0; i < NPU_CORE_NUM; i++) {
+        if(core_mask & (RKNN_NPU_CORE_0 << i)) {
+            auto & core = cores_[i];
+            core.runs++;
+            // 同一核心上的多个 rknn_run 在驱动中排队，只统计有推理在运行的时间
+            if(--core.running == 0) {
+                core.busy_ns += now_ns - std::max(core.busy_since_ns, window_start_ns_);
+            }
+        }
+    }
+}
+
+void NpuScheduler::get_stats(npu_core_stats_t stats[NPU_CORE_NUM])
+{
+    int64_t now_ns = trace_now_ns();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t window_ns = std::max<int64_t>(now_ns - window_start_ns_, 1);
+    for(int i = 0; i < NPU_CORE_NUM; i++) {
+        auto & core = cores_[i];
+
+        int64_t busy_ns = core.busy_ns;
+        if(core.running > 0) {
+            busy_ns += now_ns - std::max(core.busy_since_ns, window_start_ns_);
+        }
+        stats[i].contexts    = core.contexts;
+        stats[i].tasks       = core.tasks;
+        stats[i].runs        = core.runs;
+        stats[i].utilization = (double)busy_ns / window_ns;
+    }
+}
+
+void NpuScheduler::reset_window()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_start_ns_ = trace_now_ns();
+    for(auto & core : cores_) {
+        core.busy_ns = 0;
+        core.runs    = 0;
+    }
+}
+
+void NpuScheduler::print_stats()
+{
+    npu_core_stats_t stats[NPU_CORE_NUM];
+    get_stats(stats);
+    reset_window();
+
+    printf("%-8s %9s %6s %10s %6s\n", "core", "contexts", "tasks", "runs", "util");
+    for(int i = 0; i < NPU_CORE_NUM; i++) {
+        printf("core%-4d %9d %6d %10llu %5.1f%%\n", i, stats[i].contexts, stats[i].tasks,
+               (unsigned long long)stats[i].runs, stats[i].utilization * 100);
+    }
+}
+
+void NpuScheduler::report_if_due()
+{
+    static const int64_t interval_ns = [] {
+        const char * env = getenv(NPU_REPORT_INTERVAL_ENV);
+        return (int64_t)(env ? atoi(env) : 0) * 1000000;
+    }();
+    if(interval_ns <= 0) {
+        return;
+    }
+
+    int64_t now_ns = trace_now_ns();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(now_ns - last_report_ns_ < interval_ns) {
+            return;
+        }
+        last_report_ns_ = now_ns;
+    }
+    print_stats();
+}
+
+// ============================ NpuContextGroup ============================
+
+NpuContextGroup::NpuContextGroup(std::vector<rknn_core_mask> core_masks)
+    : core_masks_(std::move(core_masks)), list_ids_(core_masks_.size()),
+      next_(std::make_unique<std::atomic<uint32_t>[]>(core_masks_.size())),
+      free_lists_(std::make_unique<FreeList[]>(core_masks_.size()))
+{
+    // 相同 core_mask 的上下文共用一个空闲栈
+    for(size_t i = 0; i < core_masks_.size(); i++) {
+        int list_id = 0;
+        while(list_id < free_list_count_ && free_lists_[list_id].core_mask != core_masks_[i]) {
+            list_id++;
+        }
+        if(list_id == free_list_count_) {
+            free_lists_[free_list_count_++].core_mask = core_masks_[i];
+        }
+        list_ids_[i] = list_id;
+    }
+    // 倒序放入，序号小的上下文先被取出
+    for(int i = (int)core_masks_.size() - 1; i >= 0; i--) {
+        push(i);
+    }
+}
+
+int NpuContextGroup::pop(FreeList & free_list)
+{
+    uint64_t head = free_list.head.load(std::memory_order_acquire);
+    while((uint32_t)head != 0) {
+        uint32_t context_id = (uint32_t)head - 1;
+        uint32_t next       = next_[context_id].load(std::memory_order_relaxed);
+        uint64_t new_head   = ((head >> 32) + 1) << 32 | next;
+        if(free_list.head.compare_exchange_weak(head, new_head, std::memory_order_acquire,
+                                                std::memory_order_acquire)) {
+            return context_id;
+        }
+    }
+    return -1;
+}
+
+void NpuContextGroup::push(int context_id)
+{
+    auto & free_list = free_lists_[list_ids_[context_id]];
+    uint64_t head    = free_list.head.load(std::memory_order_relaxed);
+    uint64_t new_head;
+    do {
+        next_[context_id].store((uint32_t)head, std::memory_order_relaxed);
+        new_head = ((head >> 32) + 1) << 32 | (uint32_t)(context_id + 1);
+    } while(!free_list.head.compare_exchange_weak(head, new_head, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+}
+
+// 按核心负载从小到大依次尝试各空闲栈
+int NpuContextGroup::try_pop()
+{
+    auto & scheduler = NpuScheduler::instance();
+
+    uint32_t tried = 0;
+    while(true) {
+        int best_list = -1;
+        int min_load  = INT_MAX;
+        for(int i = 0; i < free_list_count_; i++) {
+            if((tried & (1u << i)) || (uint32_t)free_lists_[i].head.load(std::memory_order_relaxed) == 0) {
+                continue;
+            }
+            int load = scheduler.get_load(free_lists_[i].core_mask);
+            if(load < min_load) {
+                min_load  = load;
+                best_list = i;
+            }
+        }
+        if(best_list < 0) {
+            return -1;
+        }
+
+        int context_id = pop(free_lists_[best_list]);
+        if(context_id >= 0) {
+            return context_id;
+        }
+        // 被其他线程抢先取空，换下一个核心
+        tried |= 1u << best_list;
+    }
+}
+
+int NpuContextGroup::acquire()
+{
+    int context_id = try_pop();
+    if(context_id < 0) {
+        int64_t wait_start_ns = trace_now_ns();
+        for(int i = 0; i < NPU_LEASE_SPIN_COUNT && context_id < 0; i++) {
+            std::this_thread::yield();
+            context_id = try_pop();
+        }
+        if(context_id < 0) {
+            // 先登记等待再重试，release 放回后看到 waiters_ 会在锁内唤醒，不会丢失通知
+            waiters_++;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::unique_lock<std::mutex> lock(wait_mutex_);
+            while((context_id = try_pop()) < 0) {
+                wait_cond_.wait(lock);
+            }
+            waiters_--;
+        }
+        trace_record(TraceStage::NPU_LEASE_WAIT, wait_start_ns, trace_now_ns());
+    }
+
+    NpuScheduler::instance().begin_task(core_masks_[context_id]);
+    return context_id;
+}
+
+int NpuContextGroup::try_acquire()
+{
+    int context_id = try_pop();
+    if(context_id >= 0) {
+        NpuScheduler::instance().begin_task(core_masks_[context_id]);
+    }
+    return context_id;
+}
+
+void NpuContextGroup::release(int context_id)
+{
+    NpuScheduler::instance().end_task(core_masks_[context_id]);
+    push(context_id);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(waiters_ > 0) {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        wait_cond_.notify_one();
+    }
+}
@@ -1,18 +1,17 @@
 #include "PageManager.hpp"
 #include "UI.hpp"
 
-void PageManager::init(Camera & camera, FaceRknnPool & face_rknn_pool, ImageProcess & image_process)
+void PageManager::init(FrameSource & camera, FaceRknnPool & face_rknn_pool)
 {
-    pages_[PageType::ACCESS_CONTROL_PAGE] = std::make_unique<AccessControlPage>(camera, face_rknn_pool, image_process);
+    pages_[PageType::ACCESS_CONTROL_PAGE] = std::make_unique<AccessControlPage>(camera, face_rknn_pool);
     pages_[PageType::MAIN_PAGE]           = std::make_unique<MainPage>();
 
 }
 
-void PageManager::init(Camera & camera, SecurityRknnPool & security_rknn_pool, ImageProcess & image_process,
-                       FFmpeg & ffmpeg)
+void PageManager::init(CameraManager & camera_manager, SecurityRknnPool & security_rknn_pool, FFmpeg & ffmpeg)
 {
     pages_[PageType::SECURITY_CAMERA_PAGE] =
-        std::make_unique<SecurityCameraPage>(camera, image_process, security_rknn_pool, ffmpeg);
+        std::make_unique<SecurityCameraPage>(camera_manager, security_rknn_pool, ffmpeg);
 
     current_page_ = pages_[PageType::MAIN_PAGE].get();
 }
@@ -1,4 +1,6 @@
 #include "PostProcess.hpp"
+#include "Nms.hpp"
+#include "Trace.hpp"
 #include "rknn_box_priors.hpp"
 
 #include "Float16.h"
@@ -6,8 +8,12 @@
 #include "opencv2/imgproc.hpp"
 #include "opencv2/opencv.hpp"
 #include "rknn_matmul_api.h"
+#include <algorithm>
 #include <iostream>
-#include <set>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 // 非极大值抑制阈值
 #define NMS_THRESHOLD 0.4
@@ -26,177 +32,143 @@ static int clamp(int x, int min, int max)
     return x;
 }
 
-// 计算重叠区域
-static float CalculateOverlap(float xmin0, float ymin0, float xmax0, float ymax0, float xmin1, float ymin1, float xmax1,
-                              float ymax1)
-{
-    float w = fmax(0.f, fmin(xmax0, xmax1) - fmax(xmin0, xmin1) + 1);
-    float h = fmax(0.f, fmin(ymax0, ymax1) - fmax(ymin0, ymin1) + 1);
-    float i = w * h;
-    float u = (xmax0 - xmin0 + 1) * (ymax0 - ymin0 + 1) + (xmax1 - xmin1 + 1) * (ymax1 - ymin1 + 1) - i;
-    return u <= 0.f ? 0.f : (i / u);
-}
+// 先验框解码的方差
+static const float VARIANCES[2] = {0.1, 0.2};
 
-// 非极大值抑制
-static int nms(int validCount, float * outputLocations, int order[], float threshold)
+int init_retinaface_decoder(rknn_app_context_t * app_ctx, retinaface_decoder_t * decoder)
 {
-    for(int i = 0; i < validCount; ++i) {
-        if(order[i] == -1) {
-            continue;
-        }
-        int n = order[i];
-        for(int j = i + 1; j < validCount; ++j) {
-            int m = order[j];
-            if(m == -1) {
-                continue;
-            }
-            float xmin0 = outputLocations[n * 4 + 0] * WIDTH;
-            float ymin0 = outputLocations[n * 4 + 1] * HEIGHT;
-            float xmax0 = outputLocations[n * 4 + 2] * WIDTH;
-            float ymax0 = outputLocations[n * 4 + 3] * HEIGHT;
-
-            float xmin1 = outputLocations[m * 4 + 0] * WIDTH;
-            float ymin1 = outputLocations[m * 4 + 1] * HEIGHT;
-            float xmax1 = outputLocations[m * 4 + 2] * WIDTH;
-            float ymax1 = outputLocations[m * 4 + 3] * HEIGHT;
-
-            float iou = CalculateOverlap(xmin0, ymin0, xmax0, ymax0, xmin1, ymin1, xmax1, ymax1);
+    const float(*prior_ptr)[4];
+    int num_priors = 0;
+    if(app_ctx->model_height == 320) {
+        num_priors = 4200; // anchors box number
+        prior_ptr  = BOX_PRIORS_320;
+    } else if(app_ctx->model_height == 640) {
+        num_priors = 16800; // anchors box number
+        prior_ptr  = BOX_PRIORS_640;
+    } else {
+        printf("model_shape error!!!\n");
+        return -1;
+    }
 
-            if(iou > threshold) {
-                order[j] = -1;
-            }
-        }
+    decoder->num_priors = num_priors;
+    decoder->priors.resize(num_priors);
+    for(int i = 0; i < num_priors; i++) {
+        retinaface_prior_t & prior = decoder->priors[i];
+        prior.cx                   = prior_ptr[i][0];
+        prior.cy                   = prior_ptr[i][1];
+        prior.w                    = prior_ptr[i][2];
+        prior.h                    = prior_ptr[i][3];
+        prior.var_w                = prior_ptr[i][2] * VARIANCES[0];
+        prior.var_h                = prior_ptr[i][3] * VARIANCES[0];
     }
+    decoder->indices.resize(num_priors);
+    decoder->nms = Nms(num_priors);
     return 0;
 }
 
-static int retinaface_quick_sort_indice_inverse(float * input, int left, int right, int * indices)
+// 人脸分数筛选，scores 为 [背景, 人脸] 交错排列，返回通过阈值的先验框数量
+static int filter_face_scores(const float * scores, int num_priors, float threshold, int * indices)
 {
-    float key;
-    int key_index;
-    int low  = left;
-    int high = right;
-    if(left < right) {
-        key_index = indices[left];
-        key       = input[left];
-        while(low < high) {
-            while(low < high && input[high] <= key) {
-                high--;
-            }
-            input[low]   = input[high];
-            indices[low] = indices[high];
-            while(low < high && input[low] >= key) {
-                low++;
+    int count = 0;
+    int i     = 0;
+
+#if defined(__ARM_NEON)
+    float32x4_t v_threshold = vdupq_n_f32(threshold);
+    for(; i + 4 <= num_priors; i += 4) {
+        float32x4x2_t v = vld2q_f32(scores + i * 2);
+        uint32x4_t gt   = vcgtq_f32(v.val[1], v_threshold);
+        // 绝大多数先验框都不满足，整组跳过
+        uint32x2_t any = vorr_u32(vget_low_u32(gt), vget_high_u32(gt));
+        if((vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) == 0) {
+            continue;
+        }
+        for(int k = 0; k < 4; k++) {
+            if(scores[(i + k) * 2 + 1] > threshold) {
+                indices[count++] = i + k;
             }
-            input[high]   = input[low];
-            indices[high] = indices[low];
         }
-        input[low]   = key;
-        indices[low] = key_index;
-        retinaface_quick_sort_indice_inverse(input, left, low - 1, indices);
-        retinaface_quick_sort_indice_inverse(input, low + 1, right, indices);
     }
-    return low;
-}
+#endif
 
-// 筛选有效结果
-static int filterValidResult(float * scores, float * loc, float * landms, const float boxPriors[][4], int model_in_h,
-                             int model_in_w, int filter_indice[], float * props, float threshold, const int num_results)
-{
-    int validCount           = 0;
-    const float VARIANCES[2] = {0.1, 0.2};
-    // Scale them back to the input size.
-    for(int i = 0; i < num_results; ++i) {
-        float face_score = scores[i * 2 + 1];
-        if(face_score > threshold) {
-            filter_indice[validCount] = i;
-            props[validCount]         = face_score;
-            // decode location to origin position
-            float xcenter = loc[i * 4 + 0] * VARIANCES[0] * boxPriors[i][2] + boxPriors[i][0];
-            float ycenter = loc[i * 4 + 1] * VARIANCES[0] * boxPriors[i][3] + boxPriors[i][1];
-            float w       = (float)expf(loc[i * 4 + 2] * VARIANCES[1]) * boxPriors[i][2];
-            float h       = (float)expf(loc[i * 4 + 3] * VARIANCES[1]) * boxPriors[i][3];
-
-            float xmin = xcenter - w * 0.5f;
-            float ymin = ycenter - h * 0.5f;
-            float xmax = xmin + w;
-            float ymax = ymin + h;
-
-            loc[i * 4 + 0] = xmin;
-            loc[i * 4 + 1] = ymin;
-            loc[i * 4 + 2] = xmax;
-            loc[i * 4 + 3] = ymax;
-            for(int j = 0; j < 5; ++j) {
-                landms[i * 10 + 2 * j] = landms[i * 10 + 2 * j] * VARIANCES[0] * boxPriors[i][2] + boxPriors[i][0];
-                landms[i * 10 + 2 * j + 1] =
-                    landms[i * 10 + 2 * j + 1] * VARIANCES[0] * boxPriors[i][3] + boxPriors[i][1];
-            }
-            ++validCount;
+    for(; i < num_priors; i++) {
+        if(scores[i * 2 + 1] > threshold) {
+            indices[count++] = i;
         }
     }
+    return count;
+}
 
-    return validCount;
+// 解码先验框对应的人脸框，结果为归一化的左上右下坐标
+static inline void decode_face_box(const retinaface_prior_t & prior, const float * loc, float * box)
+{
+    float xcenter = loc[0] * prior.var_w + prior.cx;
+    float ycenter = loc[1] * prior.var_h + prior.cy;
+    float w       = expf(loc[2] * VARIANCES[1]) * prior.w;
+    float h       = expf(loc[3] * VARIANCES[1]) * prior.h;
+
+    box[0] = xcenter - w * 0.5f;
+    box[1] = ycenter - h * 0.5f;
+    box[2] = box[0] + w;
+    box[3] = box[1] + h;
 }
 
 int retinaface_post_process(rknn_app_context_t * app_ctx, rknn_output * outputs, letterbox_t * letter_box,
-                            retinaface_result * result)
+                            retinaface_decoder_t * decoder, retinaface_result * result)
 {
-    float * location = (float *)outputs[0].buf;
-    float * scores   = (float *)outputs[1].buf;
-    float * landms   = (float *)outputs[2].buf;
-    const float(*prior_ptr)[4];
-    int num_priors = 0;
-    if(app_ctx->model_height == 320) {
-        num_priors = 4200; // anchors box number
-        prior_ptr  = BOX_PRIORS_320;
-    } else if(app_ctx->model_height == 640) {
-        num_priors = 16800; // anchors box number
-        prior_ptr  = BOX_PRIORS_640;
-    } else {
-        printf("model_shape error!!!\n");
-        return -1;
-    }
+    TRACE_SCOPE(TraceStage::RETINAFACE_POST_PROCESS);
+
+    const float * location = (const float *)outputs[0].buf;
+    const float * scores   = (const float *)outputs[1].buf;
+    const float * landms   = (const float *)outputs[2].buf;
+    int * indices          = decoder->indices.data();
 
-    int filter_indices[num_priors];
-    float props[num_priors];
+    result->count = 0;
 
-    memset(filter_indices, 0, sizeof(int) * num_priors);
-    memset(props, 0, sizeof(float) * num_priors);
+    // 只解码通过阈值的先验框
+    int validCount = filter_face_scores(scores, decoder->num_priors, CONF_THRESHOLD, indices);
 
-    int validCount = filterValidResult(scores, location, landms, prior_ptr, app_ctx->model_height, app_ctx->model_width,
-                                       filter_indices, props, CONF_THRESHOLD, num_priors);
+    // 原实现按 3840x2160 计算像素 IoU，这里保持一致
+    Nms & nms = decoder->nms;
+    nms.clear();
+    for(int i = 0; i < validCount; ++i) {
+        int n = indices[i];
+        float box[4];
+        decode_face_box(decoder->priors[n], location + n * 4, box);
+        nms.push({box[0] * WIDTH, box[1] * HEIGHT, box[2] * WIDTH, box[3] * HEIGHT, scores[n * 2 + 1], 0, n});
+    }
 
-    retinaface_quick_sort_indice_inverse(props, 0, validCount - 1, filter_indices);
-    nms(validCount, location, filter_indices, NMS_THRESHOLD);
+    int keep[OBJ_NUMB_MAX_SIZE];
+    int keep_count = nms.run(NMS_THRESHOLD, OBJ_NUMB_MAX_SIZE, keep);
 
+    int model_in_w = app_ctx->model_width;
+    int model_in_h = app_ctx->model_height;
     int last_count = 0;
-    result->count  = 0;
-    for(int i = 0; i < validCount; ++i) {
-        if(last_count >= 128) {
-            printf("Warning: detected more than 128 faces, can not handle that");
-            break;
-        }
-        if(filter_indices[i] == -1 || props[i] < VIS_THRESHOLD) {
+    for(int k = 0; k < keep_count; ++k) {
+        int n       = keep[k];
+        float score = scores[n * 2 + 1];
+        if(score < VIS_THRESHOLD) {
             continue;
         }
 
-        int n = filter_indices[i];
+        const retinaface_prior_t & prior = decoder->priors[n];
+        float box[4];
+        decode_face_box(prior, location + n * 4, box);
 
-        float x1                              = location[n * 4 + 0] * app_ctx->model_width - letter_box->x_pad;
-        float y1                              = location[n * 4 + 1] * app_ctx->model_height - letter_box->y_pad;
-        float x2                              = location[n * 4 + 2] * app_ctx->model_width - letter_box->x_pad;
-        float y2                              = location[n * 4 + 3] * app_ctx->model_height - letter_box->y_pad;
-        int model_in_w                        = app_ctx->model_width;
-        int model_in_h                        = app_ctx->model_height;
+        float x1                              = box[0] * model_in_w - letter_box->x_pad;
+        float y1                              = box[1] * model_in_h - letter_box->y_pad;
+        float x2                              = box[2] * model_in_w - letter_box->x_pad;
+        float y2                              = box[3] * model_in_h - letter_box->y_pad;
         result->object[last_count].box.left   = (int)(clamp(x1, 0, model_in_w) / letter_box->scale); // Face box
         result->object[last_count].box.top    = (int)(clamp(y1, 0, model_in_h) / letter_box->scale);
         result->object[last_count].box.right  = (int)(clamp(x2, 0, model_in_w) / letter_box->scale);
         result->object[last_count].box.bottom = (int)(clamp(y2, 0, model_in_h) / letter_box->scale);
-        result->object[last_count].score      = props[i]; // Confidence
+        result->object[last_count].score      = score; // Confidence
 
+        // 关键点只对最终保留的人脸解码
+        const float * landm = landms + n * 10;
         for(int j = 0; j < 5; ++j) { // Facial feature points
-            float ponit_x = landms[n * 10 + 2 * j] * app_ctx->model_width - letter_box->x_pad;
-            float ponit_y = landms[n * 10 + 2 * j + 1] * app_ctx->model_height - letter_box->y_pad;
+            float ponit_x = (landm[2 * j] * prior.var_w + prior.cx) * model_in_w - letter_box->x_pad;
+            float ponit_y = (landm[2 * j + 1] * prior.var_h + prior.cy) * model_in_h - letter_box->y_pad;
             result->object[last_count].ponit[j].x = (int)(clamp(ponit_x, 0, model_in_w) / letter_box->scale);
             result->object[last_count].ponit[j].y = (int)(clamp(ponit_y, 0, model_in_h) / letter_box->scale);
         }
@@ -209,6 +181,17 @@ int retinaface_post_process(rknn_app_context_t * app_ctx, rknn_output * outputs,
 
 // ============================ yolo post process ============================
 
+// DFL 分布长度上限
+#define DFL_LEN_MAX 32
+// 类别扫描时一次处理的网格数
+#define CLASS_SCAN_BLOCK 16
+// 块内通过 score sum 过滤的网格数达到该值时整块扫描，否则逐个网格扫描
+#if defined(__ARM_NEON)
+#define CLASS_SCAN_MIN_CELLS 2
+#else
+#define CLASS_SCAN_MIN_CELLS 8
+#endif
+
 static char * labels[OBJ_CLASS_NUM];
 static int num_labels = 0;
 
@@ -323,173 +306,285 @@ static float deqnt_affine_to_f32(int8_t qnt, int32_t zp, float scale)
     return ((float)qnt - (float)zp) * scale;
 }
 
-void compute_dfl(float * tensor, int dfl_len, float * box)
+// fp32 DFL: 对每条边的 dfl_len 个分布求期望
+static void compute_dfl(const float * tensor, int grid_len, int dfl_len, float * box)
 {
+    float exp_t[DFL_LEN_MAX];
     for(int b = 0; b < 4; b++) {
-        float exp_t[dfl_len];
+        const float * p = tensor + b * dfl_len * grid_len;
+
+        // 减去最大值保证数值稳定，不影响 softmax 结果
+        float max_val = p[0];
+        for(int i = 1; i < dfl_len; i++) {
+            max_val = std::max(max_val, p[i * grid_len]);
+        }
+
         float exp_sum = 0;
         float acc_sum = 0;
         for(int i = 0; i < dfl_len; i++) {
-            exp_t[i] = exp(tensor[i + b * dfl_len]);
+            exp_t[i] = expf(p[i * grid_len] - max_val);
             exp_sum += exp_t[i];
+            acc_sum += exp_t[i] * i;
         }
+        box[b] = acc_sum / exp_sum;
+    }
+}
+
+// int8 DFL: 反量化后的差值 (q - q_max) * scale 只有 256 种取值，exp 直接查表
+static void compute_dfl_i8(const int8_t * tensor, int grid_len, int dfl_len, const float * lut, float * box)
+{
+    int8_t q[DFL_LEN_MAX];
+    for(int b = 0; b < 4; b++) {
+        const int8_t * p = tensor + b * dfl_len * grid_len;
 
+        int8_t q_max = p[0];
         for(int i = 0; i < dfl_len; i++) {
-            acc_sum += exp_t[i] / exp_sum * i;
+            q[i]  = p[i * grid_len];
+            q_max = std::max(q_max, q[i]);
         }
-        box[b] = acc_sum;
+
+        float exp_sum = 0;
+        float acc_sum = 0;
+        for(int i = 0; i < dfl_len; i++) {
+            float e = lut[q_max - q[i]];
+            exp_sum += e;
+            acc_sum += e * i;
+        }
+        box[b] = acc_sum / exp_sum;
     }
 }
 
-static int process_i8(int8_t * box_tensor, int32_t box_zp, float box_scale, int8_t * score_tensor, int32_t score_zp,
-                      float score_scale, int8_t * score_sum_tensor, int32_t score_sum_zp, float score_sum_scale,
-                      int grid_h, int grid_w, int stride, int dfl_len, std::vector<float> & boxes,
-                      std::vector<float> & objProbs, std::vector<int> & classId, float threshold)
+static void update_dfl_lut(yolo_workspace_t * workspace, float scale)
 {
-    int validCount            = 0;
-    int grid_len              = grid_h * grid_w;
-    int8_t score_thres_i8     = qnt_f32_to_affine(threshold, score_zp, score_scale);
-    int8_t score_sum_thres_i8 = qnt_f32_to_affine(threshold, score_sum_zp, score_sum_scale);
+    if(workspace->dfl_lut_scale == scale) {
+        return;
+    }
+    for(int d = 0; d < 256; d++) {
+        workspace->dfl_lut[d] = expf(-d * scale);
+    }
+    workspace->dfl_lut_scale = scale;
+}
 
-    for(int i = 0; i < grid_h; i++) {
-        for(int j = 0; j < grid_w; j++) {
-            int offset       = i * grid_w + j;
-            int max_class_id = -1;
+// 连续 n 个网格的最大类别分数和类别号，按类别逐行读取，内存访问连续
+static void class_max_i8(const int8_t * score_tensor, int grid_len, int num_class, int n, int8_t * max_score,
+                         uint8_t * max_class)
+{
+#if defined(__ARM_NEON)
+    if(n == CLASS_SCAN_BLOCK) {
+        const int8_t * p   = score_tensor;
+        int8x16_t v_max    = vld1q_s8(p);
+        uint8x16_t v_class = vdupq_n_u8(0);
+        for(int c = 1; c < num_class; c++) {
+            p += grid_len;
+            int8x16_t v   = vld1q_s8(p);
+            uint8x16_t gt = vcgtq_s8(v, v_max);
+            v_max         = vmaxq_s8(v_max, v);
+            v_class       = vbslq_u8(gt, vdupq_n_u8(c), v_class);
+        }
+        vst1q_s8(max_score, v_max);
+        vst1q_u8(max_class, v_class);
+        return;
+    }
+#endif
 
-            // 通过 score sum 起到快速过滤的作用
-            if(score_sum_tensor != nullptr) {
-                if(score_sum_tensor[offset] < score_sum_thres_i8) {
-                    continue;
-                }
+    for(int k = 0; k < n; k++) {
+        max_score[k] = score_tensor[k];
+        max_class[k] = 0;
+    }
+    const int8_t * p = score_tensor;
+    for(int c = 1; c < num_class; c++) {
+        p += grid_len;
+        for(int k = 0; k < n; k++) {
+            if(p[k] > max_score[k]) {
+                max_score[k] = p[k];
+                max_class[k] = c;
             }
+        }
+    }
+}
 
-            int8_t max_score = -score_zp;
-            for(int c = 0; c < num_labels; c++) {
-                if((score_tensor[offset] > score_thres_i8) && (score_tensor[offset] > max_score)) {
-                    max_score    = score_tensor[offset];
-                    max_class_id = c;
-                }
-                offset += grid_len;
+static void class_max_fp32(const float * score_tensor, int grid_len, int num_class, int n, float * max_score,
+                           uint32_t * max_class)
+{
+#if defined(__ARM_NEON)
+    if(n == CLASS_SCAN_BLOCK) {
+        float32x4_t v_max[4];
+        uint32x4_t v_class[4];
+        for(int q = 0; q < 4; q++) {
+            v_max[q]   = vld1q_f32(score_tensor + q * 4);
+            v_class[q] = vdupq_n_u32(0);
+        }
+        const float * p = score_tensor;
+        for(int c = 1; c < num_class; c++) {
+            p += grid_len;
+            uint32x4_t v_c = vdupq_n_u32(c);
+            for(int q = 0; q < 4; q++) {
+                float32x4_t v = vld1q_f32(p + q * 4);
+                uint32x4_t gt = vcgtq_f32(v, v_max[q]);
+                v_max[q]      = vmaxq_f32(v_max[q], v);
+                v_class[q]    = vbslq_u32(gt, v_c, v_class[q]);
             }
+        }
+        for(int q = 0; q < 4; q++) {
+            vst1q_f32(max_score + q * 4, v_max[q]);
+            vst1q_u32(max_class + q * 4, v_class[q]);
+        }
+        return;
+    }
+#endif
 
-            // compute box
-            if(max_score > score_thres_i8) {
-                offset = i * grid_w + j;
-                float box[4];
-                float before_dfl[dfl_len * 4];
-                for(int k = 0; k < dfl_len * 4; k++) {
-                    before_dfl[k] = deqnt_affine_to_f32(box_tensor[offset], box_zp, box_scale);
-                    offset += grid_len;
-                }
-                compute_dfl(before_dfl, dfl_len, box);
-
-                float x1, y1, x2, y2, w, h;
-                x1 = (-box[0] + j + 0.5) * stride;
-                y1 = (-box[1] + i + 0.5) * stride;
-                x2 = (box[2] + j + 0.5) * stride;
-                y2 = (box[3] + i + 0.5) * stride;
-                w  = x2 - x1;
-                h  = y2 - y1;
-                boxes.push_back(x1);
-                boxes.push_back(y1);
-                boxes.push_back(w);
-                boxes.push_back(h);
-
-                objProbs.push_back(deqnt_affine_to_f32(max_score, score_zp, score_scale));
-                classId.push_back(max_class_id);
-                validCount++;
+    for(int k = 0; k < n; k++) {
+        max_score[k] = score_tensor[k];
+        max_class[k] = 0;
+    }
+    const float * p = score_tensor;
+    for(int c = 1; c < num_class; c++) {
+        p += grid_len;
+        for(int k = 0; k < n; k++) {
+            if(p[k] > max_score[k]) {
+                max_score[k] = p[k];
+                max_class[k] = c;
             }
         }
     }
-    return validCount;
 }
 
-static int process_fp32(float * box_tensor, float * score_tensor, float * score_sum_tensor, int grid_h, int grid_w,
-                        int stride, int dfl_len, std::vector<float> & boxes, std::vector<float> & objProbs,
-                        std::vector<int> & classId, float threshold)
+static inline void emit_candidate(yolo_workspace_t * workspace, int offset, int grid_w, int stride, const float * box,
+                                  float prob, int class_id)
 {
-    int validCount = 0;
-    int grid_len   = grid_h * grid_w;
-    for(int i = 0; i < grid_h; i++) {
-        for(int j = 0; j < grid_w; j++) {
-            int offset       = i * grid_w + j;
-            int max_class_id = -1;
-
-            // 通过 score sum 起到快速过滤的作用
-            if(score_sum_tensor != nullptr) {
-                if(score_sum_tensor[offset] < threshold) {
-                    continue;
-                }
+    int n = workspace->count;
+    if(n >= workspace->capacity) {
+        return;
+    }
+
+    int i    = offset / grid_w;
+    int j    = offset % grid_w;
+    float x1 = (-box[0] + j + 0.5f) * stride;
+    float y1 = (-box[1] + i + 0.5f) * stride;
+    float x2 = (box[2] + j + 0.5f) * stride;
+    float y2 = (box[3] + i + 0.5f) * stride;
+
+    workspace->boxes[n * 4 + 0] = x1;
+    workspace->boxes[n * 4 + 1] = y1;
+    workspace->boxes[n * 4 + 2] = x2 - x1;
+    workspace->boxes[n * 4 + 3] = y2 - y1;
+    workspace->probs[n]         = prob;
+    workspace->class_ids[n]     = class_id;
+    workspace->count++;
+}
+
+static void process_i8(const int8_t * box_tensor, int32_t box_zp, float box_scale, const int8_t * score_tensor,
+                       int32_t score_zp, float score_scale, const int8_t * score_sum_tensor, int32_t score_sum_zp,
+                       float score_sum_scale, int grid_h, int grid_w, int stride, int dfl_len, int num_class,
+                       float threshold, yolo_workspace_t * workspace)
+{
+    int grid_len              = grid_h * grid_w;
+    int8_t score_thres_i8     = qnt_f32_to_affine(threshold, score_zp, score_scale);
+    int8_t score_sum_thres_i8 = qnt_f32_to_affine(threshold, score_sum_zp, score_sum_scale);
+    // 分数需要同时大于阈值和初始值 -zp
+    int8_t min_score = std::max(score_thres_i8, (int8_t)-score_zp);
+
+    update_dfl_lut(workspace, box_scale);
+
+    int8_t max_score[CLASS_SCAN_BLOCK];
+    uint8_t max_class[CLASS_SCAN_BLOCK];
+
+    for(int base = 0; base < grid_len; base += CLASS_SCAN_BLOCK) {
+        int n = std::min(CLASS_SCAN_BLOCK, grid_len - base);
+
+        // 通过 score sum 起到快速过滤的作用
+        bool is_pass[CLASS_SCAN_BLOCK];
+        int pass_count = n;
+        for(int k = 0; k < n; k++) {
+            is_pass[k] = true;
+        }
+        if(score_sum_tensor != nullptr) {
+            pass_count = 0;
+            for(int k = 0; k < n; k++) {
+                is_pass[k] = score_sum_tensor[base + k] >= score_sum_thres_i8;
+                pass_count += is_pass[k];
             }
+            if(pass_count == 0) {
+                continue;
+            }
+        }
 
-            float max_score = 0;
-            for(int c = 0; c < num_labels; c++) {
-                if((score_tensor[offset] > threshold) && (score_tensor[offset] > max_score)) {
-                    max_score    = score_tensor[offset];
-                    max_class_id = c;
+        if(pass_count >= CLASS_SCAN_MIN_CELLS) {
+            class_max_i8(score_tensor + base, grid_len, num_class, n, max_score, max_class);
+        } else {
+            for(int k = 0; k < n; k++) {
+                if(is_pass[k]) {
+                    class_max_i8(score_tensor + base + k, grid_len, num_class, 1, &max_score[k], &max_class[k]);
                 }
-                offset += grid_len;
             }
+        }
 
-            // compute box
-            if(max_score > threshold) {
-                offset = i * grid_w + j;
-                float box[4];
-                float before_dfl[dfl_len * 4];
-                for(int k = 0; k < dfl_len * 4; k++) {
-                    before_dfl[k] = box_tensor[offset];
-                    offset += grid_len;
-                }
-                compute_dfl(before_dfl, dfl_len, box);
-
-                float x1, y1, x2, y2, w, h;
-                x1 = (-box[0] + j + 0.5) * stride;
-                y1 = (-box[1] + i + 0.5) * stride;
-                x2 = (box[2] + j + 0.5) * stride;
-                y2 = (box[3] + i + 0.5) * stride;
-                w  = x2 - x1;
-                h  = y2 - y1;
-                boxes.push_back(x1);
-                boxes.push_back(y1);
-                boxes.push_back(w);
-                boxes.push_back(h);
-
-                objProbs.push_back(max_score);
-                classId.push_back(max_class_id);
-                validCount++;
+        for(int k = 0; k < n; k++) {
+            int offset = base + k;
+            if(!is_pass[k] || max_score[k] <= min_score) {
+                continue;
             }
+
+            float box[4];
+            compute_dfl_i8(box_tensor + offset, grid_len, dfl_len, workspace->dfl_lut, box);
+            emit_candidate(workspace, offset, grid_w, stride, box,
+                           deqnt_affine_to_f32(max_score[k], score_zp, score_scale), max_class[k]);
         }
     }
-    return validCount;
 }
 
-static int yolo_quick_sort_indice_inverse(std::vector<float> & input, int left, int right, std::vector<int> & indices)
+static void process_fp32(const float * box_tensor, const float * score_tensor, const float * score_sum_tensor,
+                         int grid_h, int grid_w, int stride, int dfl_len, int num_class, float threshold,
+                         yolo_workspace_t * workspace)
 {
-    float key;
-    int key_index;
-    int low  = left;
-    int high = right;
-    if(left < right) {
-        key_index = indices[left];
-        key       = input[left];
-        while(low < high) {
-            while(low < high && input[high] <= key) {
-                high--;
+    int grid_len = grid_h * grid_w;
+    // 分数需要同时大于阈值和初始值 0
+    float min_score = std::max(threshold, 0.f);
+
+    float max_score[CLASS_SCAN_BLOCK];
+    uint32_t max_class[CLASS_SCAN_BLOCK];
+
+    for(int base = 0; base < grid_len; base += CLASS_SCAN_BLOCK) {
+        int n = std::min(CLASS_SCAN_BLOCK, grid_len - base);
+
+        // 通过 score sum 起到快速过滤的作用
+        bool is_pass[CLASS_SCAN_BLOCK];
+        int pass_count = n;
+        for(int k = 0; k < n; k++) {
+            is_pass[k] = true;
+        }
+        if(score_sum_tensor != nullptr) {
+            pass_count = 0;
+            for(int k = 0; k < n; k++) {
+                is_pass[k] = score_sum_tensor[base + k] >= threshold;
+                pass_count += is_pass[k];
+            }
+            if(pass_count == 0) {
+                continue;
             }
-            input[low]   = input[high];
-            indices[low] = indices[high];
-            while(low < high && input[low] >= key) {
-                low++;
+        }
+
+        if(pass_count >= CLASS_SCAN_MIN_CELLS) {
+            class_max_fp32(score_tensor + base, grid_len, num_class, n, max_score, max_class);
+        } else {
+            for(int k = 0; k < n; k++) {
+                if(is_pass[k]) {
+                    class_max_fp32(score_tensor + base + k, grid_len, num_class, 1, &max_score[k], &max_class[k]);
+                }
             }
-            input[high]   = input[low];
-            indices[high] = indices[low];
         }
-        input[low]   = key;
-        indices[low] = key_index;
-        yolo_quick_sort_indice_inverse(input, left, low - 1, indices);
-        yolo_quick_sort_indice_inverse(input, low + 1, right, indices);
+
+        for(int k = 0; k < n; k++) {
+            int offset = base + k;
+            if(!is_pass[k] || max_score[k] <= min_score) {
+                continue;
+            }
+
+            float box[4];
+            compute_dfl(box_tensor + offset, grid_len, dfl_len, box);
+            emit_candidate(workspace, offset, grid_w, stride, box, max_score[k], max_class[k]);
+        }
     }
-    return low;
 }
 
 double rotatedRectIoU(const cv::RotatedRect & rect1, const cv::RotatedRect & rect2)
@@ -509,53 +604,38 @@ double rotatedRectIoU(const cv::RotatedRect & rect1, const cv::RotatedRect & rec
     return intersectionArea / unionArea;
 }
 
-static int yolo_nms(int validCount, std::vector<float> & outputLocations, std::vector<int> classIds,
-                    std::vector<int> & order, int filterId, float threshold)
+int init_yolo_workspace(rknn_app_context_t * app_ctx, yolo_workspace_t * workspace)
 {
-    for(int i = 0; i < validCount; ++i) {
-        if(order[i] == -1 || classIds[order[i]] != filterId) {
-            continue;
-        }
-        int n = order[i];
-        for(int j = i + 1; j < validCount; ++j) {
-            int m = order[j];
-            if(m == -1 || classIds[order[j]] != filterId) {
-                continue;
-            }
-            float xmin0 = outputLocations[n * 4 + 0];
-            float ymin0 = outputLocations[n * 4 + 1];
-            float xmax0 = outputLocations[n * 4 + 0] + outputLocations[n * 4 + 2];
-            float ymax0 = outputLocations[n * 4 + 1] + outputLocations[n * 4 + 3];
-
-            float xmin1 = outputLocations[m * 4 + 0];
-            float ymin1 = outputLocations[m * 4 + 1];
-            float xmax1 = outputLocations[m * 4 + 0] + outputLocations[m * 4 + 2];
-            float ymax1 = outputLocations[m * 4 + 1] + outputLocations[m * 4 + 3];
-
-            float iou = CalculateOverlap(xmin0, ymin0, xmax0, ymax0, xmin1, ymin1, xmax1, ymax1);
+    int output_per_branch = app_ctx->io_num.n_output / 3;
+    int capacity          = 0;
+    for(int i = 0; i < 3; i++) {
+        int box_idx = i * output_per_branch;
+        capacity += app_ctx->output_attrs[box_idx].dims[2] * app_ctx->output_attrs[box_idx].dims[3];
+    }
 
-            if(iou > threshold) {
-                order[j] = -1;
-            }
-        }
+    int dfl_len   = app_ctx->output_attrs[0].dims[1] / 4;
+    int num_class = app_ctx->output_attrs[1].dims[1];
+    if(dfl_len > DFL_LEN_MAX || num_class > 256) {
+        std::cout << "Unsupported yolo output, dfl_len=" << dfl_len << ", num_class=" << num_class << std::endl;
+        return -1;
     }
+
+    workspace->capacity = capacity;
+    workspace->count    = 0;
+    workspace->boxes.resize(capacity * 4);
+    workspace->probs.resize(capacity);
+    workspace->class_ids.resize(capacity);
+    workspace->nms = Nms(capacity);
+    workspace->dfl_lut_scale = 0;
     return 0;
 }
 
-int yolo_post_process(rknn_app_context_t * app_ctx, rknn_output * outputs, letterbox_t * letter_box,
-                      float conf_threshold, float nms_threshold, yolo_result_list * results)
+int yolo_generate_candidates(rknn_app_context_t * app_ctx, rknn_output * outputs, float conf_threshold,
+                             yolo_workspace_t * workspace)
 {
-    std::vector<float> filterBoxes;
-    std::vector<float> objProbs;
-    std::vector<int> classId;
-    int validCount = 0;
-    int stride     = 0;
-    int grid_h     = 0;
-    int grid_w     = 0;
-    int model_in_w = app_ctx->model_width;
     int model_in_h = app_ctx->model_height;
 
-    memset(results, 0, sizeof(yolo_result_list));
+    workspace->count = 0;
 
     // default 3 branch
     int dfl_len           = app_ctx->output_attrs[0].dims[1] / 4;
@@ -572,56 +652,70 @@ int yolo_post_process(rknn_app_context_t * app_ctx, rknn_output * outputs, lette
         int box_idx   = i * output_per_branch;
         int score_idx = i * output_per_branch + 1;
 
-        grid_h = app_ctx->output_attrs[box_idx].dims[2];
-        grid_w = app_ctx->output_attrs[box_idx].dims[3];
-        stride = model_in_h / grid_h;
+        int grid_h    = app_ctx->output_attrs[box_idx].dims[2];
+        int grid_w    = app_ctx->output_attrs[box_idx].dims[3];
+        int stride    = model_in_h / grid_h;
+        int num_class = app_ctx->output_attrs[score_idx].dims[1];
 
         if(app_ctx->is_quant) {
-            validCount += process_i8((int8_t *)outputs[box_idx].buf, app_ctx->output_attrs[box_idx].zp,
-                                     app_ctx->output_attrs[box_idx].scale, (int8_t *)outputs[score_idx].buf,
-                                     app_ctx->output_attrs[score_idx].zp, app_ctx->output_attrs[score_idx].scale,
-                                     (int8_t *)score_sum, score_sum_zp, score_sum_scale, grid_h, grid_w, stride,
-                                     dfl_len, filterBoxes, objProbs, classId, conf_threshold);
+            process_i8((int8_t *)outputs[box_idx].buf, app_ctx->output_attrs[box_idx].zp,
+                       app_ctx->output_attrs[box_idx].scale, (int8_t *)outputs[score_idx].buf,
+                       app_ctx->output_attrs[score_idx].zp, app_ctx->output_attrs[score_idx].scale,
+                       (int8_t *)score_sum, score_sum_zp, score_sum_scale, grid_h, grid_w, stride, dfl_len, num_class,
+                       conf_threshold, workspace);
         } else {
-            validCount +=
-                process_fp32((float *)outputs[box_idx].buf, (float *)outputs[score_idx].buf, (float *)score_sum, grid_h,
-                             grid_w, stride, dfl_len, filterBoxes, objProbs, classId, conf_threshold);
+            process_fp32((float *)outputs[box_idx].buf, (float *)outputs[score_idx].buf, (float *)score_sum, grid_h,
+                         grid_w, stride, dfl_len, num_class, conf_threshold, workspace);
         }
     }
 
+    return workspace->count;
+}
+
+int yolo_post_process(rknn_app_context_t * app_ctx, rknn_output * outputs, letterbox_t * letter_box,
+                      float conf_threshold, float nms_threshold, yolo_workspace_t * workspace,
+                      yolo_result_list * results)
+{
+    TRACE_SCOPE(TraceStage::YOLO_POST_PROCESS);
+
+    int model_in_w = app_ctx->model_width;
+    int model_in_h = app_ctx->model_height;
+
+    memset(results, 0, sizeof(yolo_result_list));
+
+    int validCount = yolo_generate_candidates(app_ctx, outputs, conf_threshold, workspace);
     if(validCount <= 0) {
         return 0;
     }
-    std::vector<int> indexArray;
 
+    std::vector<float> & filterBoxes = workspace->boxes;
+    std::vector<float> & objProbs    = workspace->probs;
+    std::vector<int> & classId       = workspace->class_ids;
+
+    // 按类别做非极大值抑制
+    Nms & nms = workspace->nms;
+    nms.clear();
     for(int i = 0; i < validCount; ++i) {
-        indexArray.push_back(i);
+        nms.push({filterBoxes[i * 4 + 0], filterBoxes[i * 4 + 1], filterBoxes[i * 4 + 0] + filterBoxes[i * 4 + 2],
+                  filterBoxes[i * 4 + 1] + filterBoxes[i * 4 + 3], objProbs[i], classId[i], i});
     }
-    yolo_quick_sort_indice_inverse(objProbs, 0, validCount - 1, indexArray);
 
-    std::set<int> class_set(std::begin(classId), std::end(classId));
-
-    for(auto c : class_set) {
-        yolo_nms(validCount, filterBoxes, classId, indexArray, c, nms_threshold);
-    }
+    int keep[OBJ_NUMB_MAX_SIZE];
+    int keep_count = nms.run(nms_threshold, OBJ_NUMB_MAX_SIZE, keep);
 
     int last_count = 0;
     results->count = 0;
 
     /* box valid detect target */
-    for(int i = 0; i < validCount; ++i) {
-
-        if(indexArray[i] == -1 || last_count >= OBJ_NUMB_MAX_SIZE) {
-            continue;
-        }
-        int n = indexArray[i];
+    for(int k = 0; k < keep_count; ++k) {
+        int n = keep[k];
 
         float x1       = filterBoxes[n * 4 + 0] - letter_box->x_pad;
         float y1       = filterBoxes[n * 4 + 1] - letter_box->y_pad;
         float x2       = x1 + filterBoxes[n * 4 + 2];
         float y2       = y1 + filterBoxes[n * 4 + 3];
         int id         = classId[n];
-        float obj_conf = objProbs[i];
+        float obj_conf = objProbs[n];
 
         results->results[last_count].box.left   = (int)(clamp(x1, 0, model_in_w) / letter_box->scale);
         results->results[last_count].box.top    = (int)(clamp(y1, 0, model_in_h) / letter_box->scale);
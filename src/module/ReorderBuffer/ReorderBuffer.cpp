@@ -0,0 +1,126 @@
+#include "ReorderBuffer.hpp"
+#include <algorithm>
+
+ReorderBuffer::ReorderBuffer(int window, int timeout_ms) : window_(window), timeout_(timeout_ms)
+{}
+
+void ReorderBuffer::submit(uint64_t sequence)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    order_.push_back({sequence, clock::now()});
+    // 队列为空时 pop 没有超时地等待，登记后唤醒它改为按该帧的超时时间等待
+    if(order_.size() == 1) {
+        cv_.notify_all();
+    }
+}
+
+void ReorderBuffer::push(Frame frame)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(!complete(std::move(frame))) {
+        stats_.late++;
+    }
+}
+
+void ReorderBuffer::skip(uint64_t sequence)
+{
+    Frame frame;
+    frame.sequence = sequence;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    complete(std::move(frame));
+}
+
+bool ReorderBuffer::complete(Frame frame)
+{
+    auto it = std::find_if(order_.begin(), order_.end(),
+                           [&](const Pending & pending) { return pending.sequence == frame.sequence; });
+    if(it == order_.end()) {
+        return false;
+    }
+
+    uint64_t sequence = frame.sequence;
+    done_[sequence]   = std::move(frame);
+    release(clock::now());
+    return true;
+}
+
+void ReorderBuffer::release(clock::time_point now)
+{
+    bool is_released = false;
+
+    while(!order_.empty()) {
+        auto & head = order_.front();
+        auto it     = done_.find(head.sequence);
+
+        if(it != done_.end()) {
+            if(it->second.image) {
+                ready_.push_back(std::move(it->second));
+                stats_.released++;
+                is_released = true;
+            } else {
+                stats_.skipped++;
+            }
+            done_.erase(it);
+        } else if((int)done_.size() >= window_ || now - head.submit_time >= timeout_) {
+            // 队首的帧等待太久，放弃它，之后到达的结果按 late 丢弃
+            stats_.missing++;
+        } else {
+            break;
+        }
+        order_.pop_front();
+    }
+
+    if(is_released) {
+        cv_.notify_all();
+    }
+}
+
+bool ReorderBuffer::pop(Frame & frame, bool is_wait)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    release(clock::now());
+
+    while(is_wait && ready_.empty()) {
+        if(order_.empty()) {
+            cv_.wait(lock);
+        } else {
+            // 队首超时后需要主动放弃，不能只等待新结果
+            cv_.wait_until(lock, order_.front().submit_time + timeout_);
+        }
+        release(clock::now());
+    }
+
+    if(ready_.empty()) {
+        return false;
+    }
+    frame = std::move(ready_.front());
+    ready_.pop_front();
+    return true;
+}
+
+bool ReorderBuffer::front(Frame & frame)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    release(clock::now());
+
+    if(ready_.empty()) {
+        return false;
+    }
+    frame = ready_.front();
+    return true;
+}
+
+void ReorderBuffer::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    order_.clear();
+    done_.clear();
+    ready_.clear();
+}
+
+reorder_stats_t ReorderBuffer::stats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -1,35 +1,82 @@
 #include "Common.hpp"
+#include "Executor.hpp"
 #include "Model.hpp"
 #include "Sensor.hpp"
 #include "RknnPool.hpp"
-#include <future>
+#include <algorithm>
 #include <iostream>
+#include <optional>
 
-// 获取欧几里得距离
-static float get_duclidean_distance(float * output1, float * output2)
+// 先初始化第一个上下文，其余上下文在线程池的工作线程中并行复制，每个上下文初始化后推理一次预热
+// model_file 第一次加载时获取，之后一直持有映射，失败时和原来一样直接退出
+template <class M>
+static void init_models(StealingThreadPool & thread_pool, std::vector<std::shared_ptr<M>> & models,
+                        std::shared_ptr<const model_file_t> & model_file)
 {
-    float sum = 0;
-    for(int i = 0; i < 128; i++) {
-        sum += (output1[i] - output2[i]) * (output1[i] - output2[i]);
+    if(model_file == nullptr && models[0]->get_backend()->require_model_data()) {
+        model_file = ModelRegistry::instance().acquire(models[0]->get_model_path());
+    }
+    if(models[0]->init(models[0]->get_backend(), false) != 0 || models[0]->warm_up() != 0) {
+        std::cout << "Init rknn model failed!" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // 优先通道不受队列容量限制，不会被丢弃
+    std::vector<std::future<int>> results;
+    for(size_t i = 1; i < models.size(); ++i) {
+        results.push_back(thread_pool.enqueue(TaskPriority::HIGH, [&models, i]() {
+            int ret = models[i]->init(models[0]->get_backend(), true);
+            return ret != 0 ? ret : models[i]->warm_up();
+        }));
+    }
+    for(auto & result : results) {
+        if(result.get() != 0) {
+            std::cout << "Init rknn model failed!" << std::endl;
+            exit(EXIT_FAILURE);
+        }
     }
-    float norm = std::sqrt(sum);
-    return norm;
+}
+
+// 各上下文初始化时已由 NpuScheduler 绑定核心
+template <class M>
+static std::unique_ptr<NpuContextGroup> make_context_group(std::vector<std::shared_ptr<M>> & models)
+{
+    std::vector<rknn_core_mask> core_masks;
+    for(auto & model : models) {
+        core_masks.push_back(model->get_core_mask());
+    }
+    return std::make_unique<NpuContextGroup>(std::move(core_masks));
 }
 
 // ============================ FaceRknnPool ============================
 
-// 构造函数，初始化线程池和模型
 FaceRknnPool::FaceRknnPool()
 {
+    lifecycle_ = std::make_unique<RknnPoolLifecycle>("FaceRknnPool", [this]() { load(); }, [this]() { unload(); });
+}
+
+FaceRknnPool::~FaceRknnPool()
+{
+    lifecycle_.reset();
+    unload();
+}
+
+// 创建线程池和模型并初始化，就绪后才允许提交任务
+void FaceRknnPool::load()
+{
+    std::call_once(face_store_once_, [this]() { face_store_.open(); });
+
+    std::unique_ptr<StealingThreadPool> thread_pool;
     try {
         // 配置线程池，使用指定数量的线程
-        thread_pool_ = std::make_unique<ThreadPool>(thread_num_);
+        thread_pool =
+            std::make_unique<StealingThreadPool>(thread_num_, RKNN_POOL_QUEUE_CAPACITY, OverflowPolicy::DROP_OLDEST);
 
         // 每个线程加载一个模型
         for(int i = 0; i < this->thread_num_; ++i) {
-            retinaface_models_.push_back(std::make_shared<Retinaface>()); // 使用模型路径初始化模型
+            retinaface_models_.push_back(std::make_shared<Retinaface>(create_inference_backend()));
 
-            facenet_models_.push_back(std::make_shared<Facenet>()); // 使用模型路径初始化模型
+            facenet_models_.push_back(std::make_shared<Facenet>(create_inference_backend()));
         }
 
     } catch(const std::bad_alloc & e) {
@@ -37,62 +84,113 @@ FaceRknnPool::FaceRknnPool()
         exit(EXIT_FAILURE);
     }
 
-    // 初始化每个模型
+    init_models(*thread_pool, retinaface_models_, retinaface_file_);
+    init_models(*thread_pool, facenet_models_, facenet_file_);
+    retinaface_group_ = make_context_group(retinaface_models_);
+    facenet_group_    = make_context_group(facenet_models_);
+
+    this->retinaface_model_size_ = this->retinaface_models_[0]->get_model_width();
+    this->facenet_model_size_    = this->facenet_models_[0]->get_model_width();
     for(int i = 0; i < this->thread_num_; ++i) {
+        facenet_image_processes_.push_back(
+            std::make_unique<ImageProcess>(facenet_model_size_, facenet_model_size_, facenet_model_size_));
+    }
 
-        auto ret = retinaface_models_[i]->init(retinaface_models_[0]->get_rknn_context(), i != 0);
-        if(ret != 0) {
-            std::cout << "Init rknn model failed!" << std::endl;
-            exit(EXIT_FAILURE);
-        }
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    thread_pool_ = std::move(thread_pool);
+}
 
-        ret = facenet_models_[i]->init(facenet_models_[0]->get_rknn_context(), i != 0);
-        if(ret != 0) {
-            std::cout << "Init rknn model failed!" << std::endl;
-            exit(EXIT_FAILURE);
-        }
+// 先执行完剩余任务再销毁模型，释放 NPU 内存
+void FaceRknnPool::unload()
+{
+    std::unique_ptr<StealingThreadPool> thread_pool;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        thread_pool = std::move(thread_pool_);
     }
+    thread_pool.reset();
+
+    retinaface_group_.reset();
+    facenet_group_.reset();
+    retinaface_models_.clear();
+    facenet_models_.clear();
+    facenet_image_processes_.clear();
+    this->image_results_.clear();
+}
 
-    this->retinaface_model_size_ = this->retinaface_models_[0]->get_model_width();
-    this->facenet_model_size_    = this->facenet_models_[0]->get_model_width();
+void FaceRknnPool::activate()
+{
+    lifecycle_->activate();
 }
 
-FaceRknnPool::~FaceRknnPool()
-{}
+void FaceRknnPool::release_after_idle()
+{
+    lifecycle_->release_after_idle();
+}
+
+bool FaceRknnPool::is_ready()
+{
+    return lifecycle_->is_ready();
+}
+
+void FaceRknnPool::wait_ready()
+{
+    lifecycle_->wait_ready();
+}
 
 // 向线程池添加推理任务
-void FaceRknnPool::add_inference_task(std::shared_ptr<cv::Mat> src, ImageProcess & retinaface_image_process,
+void FaceRknnPool::add_inference_task(Frame frame, ImageProcess & retinaface_image_process,
                                       bool is_generate_face_feature)
 {
+    // 模型还在后台加载或已释放时直接丢弃
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if(thread_pool_ == nullptr) {
+        return;
+    }
+
+    // 按提交顺序登记，结果由 image_results_ 恢复顺序后输出
+    this->image_results_.submit(frame.sequence);
+    ReorderTicket ticket(this->image_results_, frame.sequence);
 
-    // 将任务添加到线程池
+    // 将任务添加到线程池，人脸录入走优先通道，不会排在普通帧后面或被丢弃
     thread_pool_->enqueue(
-        [&](std::shared_ptr<cv::Mat> original_img, bool is_generate_face_feature) { // 线程池执行的任务
+        is_generate_face_feature ? TaskPriority::HIGH : TaskPriority::NORMAL,
+        [&, ticket = std::move(ticket)](Frame frame, bool is_generate_face_feature) mutable { // 线程池执行的任务
+            ticket.release();
+            auto & original_img = frame.image;
             try {
-                // 处理输入图像
-                auto convert_img = retinaface_image_process.convert(*original_img);
-
-                // 获取模型ID
-                auto mode_id = get_model_id();
-
-                // 创建一个新的图像来适配模型输入大小
-                cv::Mat rgb_img =
-                    cv::Mat::zeros(this->retinaface_models_[mode_id]->get_model_width(),
-                                   this->retinaface_models_[mode_id]->get_model_height(), convert_img->type());
-
-                // 将图像从BGR转换为RGB
-                cv::cvtColor(*convert_img, rgb_img, cv::COLOR_BGR2RGB);
-
-                retinaface_result results; // 存放推理结果
-                // 使用模型进行推理
-                this->retinaface_models_[mode_id]->inference(rgb_img.ptr(), &results,
-                                                             retinaface_image_process.get_letter_box());
+                retinaface_result results{}; // 存放推理结果
+                {
+                    // 选择所在核心最空闲的上下文，预处理直接写入模型输入内存并推理
+                    NpuLease lease(*retinaface_group_);
+                    int ret = this->retinaface_models_[lease.context_id()]->inference(
+                        *original_img, retinaface_image_process, &results);
+                    // 帧尺寸与预处理配置不符或推理失败时没有检测结果，原图照常输出，不识别也不画框
+                    if(ret != 0) {
+                        results.count = 0;
+                    }
+                }
 
-                // 是否是同一人脸
+                // 是否有已录入的人脸
                 bool is_check = false;
 
+                // 未识别或未匹配的人脸为白色，匹配的为绿色
+                cv::Scalar colors[OBJ_NUMB_MAX_SIZE];
+                std::fill(colors, colors + results.count, cv::Scalar{255, 255, 255});
+
                 if(results.count > 0 && is_face_recognition_) {
-                    is_check = this->face_recognition(mode_id, *original_img, results, is_generate_face_feature);
+                    if(is_generate_face_feature) {
+                        this->enroll_face(*original_img, results);
+                    } else {
+                        face_identity_t identities[FACE_RECOGNITION_MAX_FACES];
+                        int face_count = this->recognize_faces(*original_img, results, identities);
+                        for(int i = 0; i < face_count; i++) {
+                            if(identities[i].is_match) {
+                                colors[identities[i].index] = cv::Scalar{0, 255, 0};
+                                is_check                    = true;
+                            }
+                        }
+                    }
 
                     uint64_t current_timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
                                                      std::chrono::system_clock::now().time_since_epoch())
@@ -102,56 +200,34 @@ void FaceRknnPool::add_inference_task(std::shared_ptr<cv::Mat> src, ImageProcess
                        current_timestamp - this->pre_show_oled_timestamp_ > 500) {
                         this->pre_show_oled_timestamp_ = current_timestamp;
 
-                        // 异步显示OLED
-                        [[maybe_unused]] auto future = std::async(std::launch::async, [&]() { OLED::show(is_check); });
+                        // 在 UI 队列中刷新OLED，不阻塞推理线程
+                        Executor::instance().post(ExecutorQueue::UI, [is_check]() { OLED::show(is_check); });
                     }
                 } else if(results.count > 0 && is_generate_face_feature) {
-                    is_check = this->face_recognition(mode_id, *original_img, results, is_generate_face_feature);
-                    std::cout << "录入人脸成功" << std::endl;
+                    if(this->enroll_face(*original_img, results)) {
+                        std::cout << "录入人脸成功" << std::endl;
+                    }
+                    this->image_results_.skip(frame.sequence);
                     return;
                 }
 
-                cv::Scalar recognition_color{0, 255, 0};
-                cv::Scalar color{255, 255, 255};
-
                 // 进行图像后处理
-                retinaface_image_process.image_post_process(*original_img, results,
-                                                            is_check ? recognition_color : color);
+                retinaface_image_process.image_post_process(*original_img, results, colors);
 
-                // 锁住结果队列，将推理结果加入队列
-                std::lock_guard<std::mutex> lock_guard(this->image_results_mutex_);
-                this->image_results_.push(std::move(original_img));
-                this->image_results_cv_.notify_one();
+                // 将推理结果加入重排序缓冲区
+                this->image_results_.push(std::move(frame));
             } catch(std::exception & e) {
                 std::cout << "FaceRknnPool---add_inference_task: " << e.what() << std::endl;
+                this->image_results_.skip(frame.sequence);
             }
 
         },
-        std::move(src), is_generate_face_feature); // 向线程池添加任务
+        std::move(frame), is_generate_face_feature); // 向线程池添加任务
 }
 
-// 获取当前应该使用的模型ID
-int FaceRknnPool::get_model_id()
+bool FaceRknnPool::get_result(Frame & frame, bool is_wait)
 {
-    std::lock_guard<std::mutex> lock(id_mutex_); // 锁住ID生成过程
-    int mode_id = id_;                           // 获取当前模型ID
-    id_++;                                       // 自增ID
-    if(id_ == thread_num_) {                     // 如果ID达到线程数限制，重置为0
-        id_ = 0;
-    }
-    return mode_id; // 返回模型ID
-}
-
-// 从结果队列中获取图像结果
-std::shared_ptr<cv::Mat> FaceRknnPool::get_image_result_from_queue()
-{
-    std::unique_lock<std::mutex> lock(this->image_results_mutex_);
-    this->image_results_cv_.wait(lock, [this]() { return !this->image_results_.empty(); });
-
-    // 否则，获取队列中的第一个图像并移除它
-    auto res = this->image_results_.front();
-    this->image_results_.pop();
-    return std::move(res); // 返回结果图像
+    return this->image_results_.pop(frame, is_wait);
 }
 
 int FaceRknnPool::get_retinaface_model_size()
@@ -166,55 +242,114 @@ int FaceRknnPool::get_facenet_model_size()
 
 int FaceRknnPool::get_facenet_feature_vector_size()
 {
-    return this->facenet_feature_vector_.size();
+    return this->face_gallery_.size();
 }
 
 void FaceRknnPool::clean_image_results()
 {
-    std::lock_guard<std::mutex> lock(this->image_results_mutex_);
-    while(!this->image_results_.empty()) {
-        this->image_results_.pop();
-    }
+    this->image_results_.clear();
 }
 
-bool FaceRknnPool::face_recognition(int mode_id, cv::Mat & image, retinaface_result & results,
-                                    bool is_generate_face_feature)
+reorder_stats_t FaceRknnPool::get_reorder_stats()
 {
+    return this->image_results_.stats();
+}
 
-    retinaface_object * detect_result = &(results.object[0]);
-    cv::Mat crop_img                  = image(cv::Rect(detect_result->box.left, detect_result->box.top,
-                                                       detect_result->box.right - detect_result->box.left,
-                                                       detect_result->box.bottom - detect_result->box.top));
-
-    auto facenet_image_process =
-        std::make_unique<ImageProcess>(crop_img.cols, crop_img.rows, this->get_facenet_model_size());
+int FaceRknnPool::select_faces(const cv::Mat & image, const retinaface_result & results, int * indices,
+                               cv::Rect * rects, int max_count)
+{
+    int candidates[OBJ_NUMB_MAX_SIZE];
+    cv::Rect boxes[OBJ_NUMB_MAX_SIZE];
+    int count = 0;
+
+    cv::Rect bounds(0, 0, image.cols, image.rows);
+    for(int i = 0; i < results.count; i++) {
+        const box_rect_t & box = results.object[i].box;
+        cv::Rect rect          = cv::Rect(box.left, box.top, box.right - box.left, box.bottom - box.top) & bounds;
+        if(std::min(rect.width, rect.height) >= FACE_RECOGNITION_MIN_SIZE) {
+            boxes[i]            = rect;
+            candidates[count++] = i;
+        }
+    }
 
-    auto convert_img = facenet_image_process->convert(crop_img);
+    // 离摄像头越近的人脸越大，优先识别
+    std::sort(candidates, candidates + count, [&](int a, int b) { return boxes[a].area() > boxes[b].area(); });
 
-    cv::Mat rgb_img = cv::Mat::zeros(this->facenet_models_[mode_id]->get_model_width(),
-                                     this->facenet_models_[mode_id]->get_model_height(), convert_img->type());
+    count = std::min(count, max_count);
+    for(int i = 0; i < count; i++) {
+        indices[i] = candidates[i];
+        rects[i]   = boxes[candidates[i]];
+    }
+    return count;
+}
 
-    // 将图像从BGR转换为RGB
-    cv::cvtColor(*convert_img, rgb_img, cv::COLOR_BGR2RGB);
+// 按批处理人脸: 每批先阻塞取一个上下文，再尽量多取空闲上下文，批内所有人脸先依次预处理并提交，
+// 再依次等待结果，NPU 推理与后续人脸的预处理重叠，多个核心同时处理同一帧的不同人脸
+int FaceRknnPool::recognize_faces(cv::Mat & image, retinaface_result & results,
+                                  face_identity_t identities[FACE_RECOGNITION_MAX_FACES])
+{
+    int indices[FACE_RECOGNITION_MAX_FACES];
+    cv::Rect rects[FACE_RECOGNITION_MAX_FACES];
+    int count = this->select_faces(image, results, indices, rects, FACE_RECOGNITION_MAX_FACES);
+
+    thread_local std::vector<float> out_fp32(FACE_GALLERY_DIM);
+
+    for(int first = 0; first < count;) {
+        std::optional<NpuLease> leases[FACE_RECOGNITION_MAX_FACES];
+        leases[0].emplace(*facenet_group_);
+        int batch = 1;
+        while(first + batch < count) {
+            leases[batch].emplace(*facenet_group_, std::try_to_lock);
+            if(!leases[batch]->owns_context()) {
+                leases[batch].reset();
+                break;
+            }
+            batch++;
+        }
 
-    std::vector<float> out_fp32(128);
+        bool is_submitted[FACE_RECOGNITION_MAX_FACES];
+        for(int i = 0; i < batch; i++) {
+            int context_id = leases[i]->context_id();
+            auto & process = *facenet_image_processes_[context_id];
+            process.reset(rects[first + i].width, rects[first + i].height);
+            is_submitted[i] = facenet_models_[context_id]->submit(image(rects[first + i]), process) == 0;
+        }
 
-    this->facenet_models_[mode_id]->inference(rgb_img.ptr(), out_fp32, facenet_image_process->get_letter_box());
+        for(int i = 0; i < batch; i++) {
+            face_identity_t & identity = identities[first + i];
+            identity                   = {indices[first + i], -1, -1, false};
+            if(!is_submitted[i] || facenet_models_[leases[i]->context_id()]->get_result(out_fp32) != 0) {
+                continue;
+            }
+            // 取最相似的身份，而不是第一个低于阈值的
+            face_match_t match = this->face_gallery_.search(out_fp32.data());
+            identity.score     = match.score;
+            identity.is_match  = match.is_match;
+            identity.id        = match.is_match ? this->face_store_.get_id(match.id) : -1;
+        }
+        first += batch;
+    }
+    return count;
+}
 
-    if(is_generate_face_feature) {
-        this->facenet_feature_vector_.push_back(std::move(out_fp32));
+bool FaceRknnPool::enroll_face(cv::Mat & image, retinaface_result & results)
+{
+    int index;
+    cv::Rect rect;
+    if(this->select_faces(image, results, &index, &rect, 1) == 0) {
         return false;
-    } else {
-        if(this->is_face_recognition_) {
-            for(auto out : facenet_feature_vector_) {
-                float distance = get_duclidean_distance(out.data(), out_fp32.data());
-                if(distance < 0.6) {
-                    return true;
-                }
-            }
+    }
+
+    std::vector<float> out_fp32(FACE_GALLERY_DIM);
+    {
+        NpuLease lease(*facenet_group_);
+        auto & process = *facenet_image_processes_[lease.context_id()];
+        process.reset(rect.width, rect.height);
+        if(this->facenet_models_[lease.context_id()]->inference(image(rect), process, out_fp32) != 0) {
+            return false;
         }
     }
-    return false;
+    return this->face_store_.enroll(out_fp32.data()) >= 0;
 }
 
 void FaceRknnPool::change_face_recognition_status(bool status)
@@ -230,11 +365,26 @@ SecurityRknnPool::SecurityRknnPool()
 
     init_yolo_post_process(YOLO11_LABEL_PATH);
 
+    lifecycle_ =
+        std::make_unique<RknnPoolLifecycle>("SecurityRknnPool", [this]() { load(); }, [this]() { unload(); });
+}
+
+SecurityRknnPool::~SecurityRknnPool()
+{
+    lifecycle_.reset();
+    unload();
+    deinit_yolo_post_process();
+}
+
+void SecurityRknnPool::load()
+{
+    std::unique_ptr<StealingThreadPool> thread_pool;
     try {
-        this->thread_pool_ = std::make_unique<ThreadPool>(this->thread_num_);
+        thread_pool = std::make_unique<StealingThreadPool>(this->thread_num_, RKNN_POOL_QUEUE_CAPACITY,
+                                                           OverflowPolicy::DROP_OLDEST);
 
         for(int i = 0; i < this->thread_num_; ++i) {
-            models_.push_back(std::make_shared<Yolo11>());
+            models_.push_back(std::make_shared<Yolo11>(create_inference_backend()));
         }
 
     } catch(const std::bad_alloc & e) {
@@ -242,92 +392,132 @@ SecurityRknnPool::SecurityRknnPool()
         exit(EXIT_FAILURE);
     }
 
-    for(int i = 0; i < this->thread_num_; ++i) {
-        auto ret = models_[i]->init(models_[0]->get_rknn_context(), i != 0);
-        if(ret != 0) {
-            std::cout << "Init rknn model failed!" << std::endl;
-            exit(EXIT_FAILURE);
-        }
-    }
+    init_models(*thread_pool, models_, yolo_file_);
+    group_ = make_context_group(models_);
 
     this->yolo_model_size_ = this->models_[0]->get_model_width();
+
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    thread_pool_ = std::move(thread_pool);
 }
 
-SecurityRknnPool::~SecurityRknnPool()
+void SecurityRknnPool::unload()
 {
-    deinit_yolo_post_process();
+    std::unique_ptr<StealingThreadPool> thread_pool;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        thread_pool = std::move(thread_pool_);
+    }
+    thread_pool.reset();
+
+    group_.reset();
+    models_.clear();
+    for(auto & image_results : this->image_results_) {
+        image_results.clear();
+    }
 }
 
-void SecurityRknnPool::add_inference_task(std::shared_ptr<cv::Mat> src, ImageProcess & image_process)
+void SecurityRknnPool::activate()
 {
-    thread_pool_->enqueue(
-        [&](std::shared_ptr<cv::Mat> original_img) {
-
-            // 显示当前年月日时分秒
-            time_t now = time(nullptr);
-            strftime(this->time_str_, sizeof(this->time_str_), "%Y-%m-%d %H:%M:%S", localtime(&now));
-            std::string time_str_s(this->time_str_);
-            cv::putText(*original_img, time_str_s, cv::Point(original_img->cols - 1200, original_img->rows - 80),
-                        cv::FONT_HERSHEY_SIMPLEX, 3, cv::Scalar(255, 255, 255), 5, cv::LINE_8);
+    lifecycle_->activate();
+}
 
-            this->is_person = false;
+void SecurityRknnPool::release_after_idle()
+{
+    lifecycle_->release_after_idle();
+}
 
-            auto convert_img = image_process.convert(*original_img);
+bool SecurityRknnPool::is_ready()
+{
+    return lifecycle_->is_ready();
+}
 
-            auto mode_id = get_model_id();
+void SecurityRknnPool::wait_ready()
+{
+    lifecycle_->wait_ready();
+}
 
-            cv::Mat rgb_img = cv::Mat::zeros(this->models_[mode_id]->get_model_width(),
-                                             this->models_[mode_id]->get_model_height(), convert_img->type());
-            cv::cvtColor(*convert_img, rgb_img, cv::COLOR_BGR2RGB);
+void SecurityRknnPool::add_inference_task(Frame frame, ImageProcess & image_process)
+{
+    if(frame.stream_id < 0 || frame.stream_id >= RKNN_POOL_MAX_STREAMS) {
+        std::cout << "SecurityRknnPool---add_inference_task: invalid stream " << frame.stream_id << std::endl;
+        return;
+    }
 
-            yolo_result_list results;
-            this->models_[mode_id]->inference(rgb_img.ptr(), &results, image_process.get_letter_box());
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if(thread_pool_ == nullptr) {
+        return;
+    }
+    auto & image_results = this->image_results_[frame.stream_id];
+    image_results.submit(frame.sequence);
+    // 队列满时被丢弃的任务由 ticket 跳过该序号
+    ReorderTicket ticket(image_results, frame.sequence);
 
-            if(results.count > 0) {
-                for(int i = 0; i < results.count; ++i) {
-                    if(results.results[i].cls_id == 0) {
-                        this->is_person = true;
-                        break;
-                    }
-                }
+    thread_pool_->enqueue(
+        [&, ticket = std::move(ticket)](Frame frame) mutable {
+            ticket.release();
+            try {
+                process_frame(*frame.image, image_process);
+                image_results.push(std::move(frame));
+            } catch(std::exception & e) {
+                std::cout << "SecurityRknnPool---add_inference_task: " << e.what() << std::endl;
+                image_results.skip(frame.sequence);
             }
-
-            cv::Scalar color{255, 0, 255};
-            image_process.image_post_process(*original_img, results, color);
-
-            std::lock_guard<std::mutex> lock_guard(this->image_results_mutex_);
-
-            this->image_results_.push(std::move(original_img));
         },
-        std::move(src));
+        std::move(frame));
 }
 
-int SecurityRknnPool::get_model_id()
+void SecurityRknnPool::process_frame(cv::Mat & original_img, ImageProcess & image_process)
 {
-    std::lock_guard<std::mutex> lock(id_mutex_);
-    int mode_id = id_;
-    id_++;
-    if(id_ == thread_num_) {
-        id_ = 0;
+    this->is_person = false;
+
+    yolo_result_list results;
+    results.count = 0;
+    {
+        NpuLease lease(*group_);
+        auto & model = this->models_[lease.context_id()];
+
+        // 预处理完成后推理在 NPU 上异步执行，期间在原图上叠加时间，时间不会进入模型输入
+        int ret = model->submit(original_img, image_process);
+        draw_timestamp(original_img);
+        if(ret == 0) {
+            model->get_result(image_process, &results);
+        }
+    }
+
+    if(results.count > 0) {
+        for(int i = 0; i < results.count; ++i) {
+            if(results.results[i].cls_id == 0) {
+                this->is_person = true;
+                break;
+            }
+        }
     }
-    return mode_id;
+
+    cv::Scalar color{255, 0, 255};
+    image_process.image_post_process(original_img, results, color);
 }
 
-std::shared_ptr<cv::Mat> SecurityRknnPool::get_image_result_from_queue(bool is_pop)
+void SecurityRknnPool::draw_timestamp(cv::Mat & original_img)
 {
-    std::lock_guard<std::mutex> lock_guard(this->image_results_mutex_);
-
-    if(this->image_results_.empty()) {
-        return nullptr;
-    } else {
-        auto res = std::make_shared<cv::Mat>(*this->image_results_.front());
+    // 显示当前年月日时分秒，各工作线程同时调用，不能使用共享缓冲区
+    char time_str[20];
+    time_t now = time(nullptr);
+    struct tm local_time;
+    localtime_r(&now, &local_time);
+    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &local_time);
+    cv::putText(original_img, time_str, cv::Point(original_img.cols - 1200, original_img.rows - 80),
+                cv::FONT_HERSHEY_SIMPLEX, 3, cv::Scalar(255, 255, 255), 5, cv::LINE_8);
+}
 
-        if(is_pop) {
-            this->image_results_.pop();
-        }
+bool SecurityRknnPool::get_result(int stream_id, Frame & frame, bool is_wait)
+{
+    return this->image_results_[stream_id].pop(frame, is_wait);
+}
 
-        return std::move(res);
-    }
+reorder_stats_t SecurityRknnPool::get_reorder_stats(int stream_id)
+{
+    return this->image_results_[stream_id].stats();
 }
 
 int SecurityRknnPool::get_yolo_model_size()
@@ -0,0 +1,136 @@
+#include "RknnPoolLifecycle.hpp"
+#include "Executor.hpp"
+#include "StartupTimeline.hpp"
+#include <cstdlib>
+#include <iostream>
+
+RknnPoolLifecycle::RknnPoolLifecycle(const char * name, std::function<void()> load, std::function<void()> unload)
+    : name_(name), load_(std::move(load)), unload_(std::move(unload)), idle_release_ms_(idle_release_ms_from_env())
+{
+    if(idle_release_ms_ >= 0) {
+        release_thread_ = std::thread(&RknnPoolLifecycle::release_loop, this);
+    }
+}
+
+RknnPoolLifecycle::~RknnPoolLifecycle()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        is_stop_ = true;
+        cond_.notify_all();
+        // 加载任务在 IO 队列中执行，引用了 this
+        cond_.wait(lock, [this]() { return state_ != State::LOADING; });
+    }
+    if(release_thread_.joinable()) {
+        release_thread_.join();
+    }
+}
+
+int RknnPoolLifecycle::idle_release_ms_from_env()
+{
+    const char * env = getenv(RKNN_POOL_IDLE_RELEASE_ENV);
+    return env ? atoi(env) : RKNN_POOL_IDLE_RELEASE_MS;
+}
+
+void RknnPoolLifecycle::activate()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_active_          = true;
+    is_release_pending_ = false;
+    // 释放中时由 release_loop 在释放完成后重新加载
+    if(state_ == State::RELEASED) {
+        start_load();
+    }
+}
+
+void RknnPoolLifecycle::release_after_idle()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_active_ = false;
+    if(idle_release_ms_ < 0) {
+        return;
+    }
+    is_release_pending_ = true;
+    release_deadline_   = std::chrono::steady_clock::now() + std::chrono::milliseconds(idle_release_ms_);
+    cond_.notify_all();
+}
+
+bool RknnPoolLifecycle::is_ready()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_ == State::READY;
+}
+
+void RknnPoolLifecycle::wait_ready()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() { return state_ == State::READY; });
+}
+
+void RknnPoolLifecycle::start_load()
+{
+    state_ = State::LOADING;
+    Executor::instance().post(ExecutorQueue::IO, [this]() { load_task(); });
+}
+
+void RknnPoolLifecycle::load_task()
+{
+    auto start = std::chrono::steady_clock::now();
+    load_();
+    auto elapsed_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name_ << " loaded in " << elapsed_ms << "ms" << std::endl;
+
+    // 离开锁后析构函数可能已经返回，不能再访问成员
+    const char * name = name_;
+    bool is_first_ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        state_         = State::READY;
+        is_first_ready = !is_ever_ready_;
+        is_ever_ready_ = true;
+        cond_.notify_all();
+    }
+    // 第一次就绪计入启动时间线，之后释放再加载不再记录
+    if(is_first_ready) {
+        startup_mark(std::string(name) + ": models ready");
+        startup_report();
+    }
+}
+
+void RknnPoolLifecycle::release_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(!is_stop_) {
+        if(!is_release_pending_) {
+            cond_.wait(lock);
+            continue;
+        }
+        if(std::chrono::steady_clock::now() < release_deadline_) {
+            cond_.wait_until(lock, release_deadline_);
+            continue;
+        }
+        // 加载完成后再释放
+        if(state_ != State::READY) {
+            if(state_ == State::RELEASED) {
+                is_release_pending_ = false;
+            } else {
+                cond_.wait(lock);
+            }
+            continue;
+        }
+
+        is_release_pending_ = false;
+        state_              = State::UNLOADING;
+        lock.unlock();
+        unload_();
+        std::cout << name_ << " released after " << idle_release_ms_ << "ms idle" << std::endl;
+        lock.lock();
+
+        state_ = State::RELEASED;
+        if(is_active_ && !is_stop_) {
+            start_load();
+        }
+        cond_.notify_all();
+    }
+}
@@ -12,37 +12,59 @@ extern "C" {
 }
 
 std::atomic<bool> SR501::is_running = false;
+std::mutex SR501::listen_mutex;
+std::condition_variable SR501::listen_cond;
+// 定义在 listen_mutex、listen_cond 之后，静态析构时先于它们析构
+SR501::ListenThread SR501::listen_thread;
+
+SR501::ListenThread::~ListenThread()
+{
+    // 轮询线程内调用 exit 时不能 join 自己
+    if(thread.joinable() && thread.get_id() == std::this_thread::get_id()) {
+        is_running = false;
+        thread.detach();
+        return;
+    }
+    stop_listen_state();
+}
 
 void SR501::listen_state(std::function<void(bool state)> fn)
 {
+    // 页面快速切换时先结束上一次的轮询，始终只有一个轮询线程
+    stop_listen_state();
     is_running = true;
 
-    int status;
-    std::thread(
-        [&](std::function<void(bool state)> fn) {
-            try {
-                while(is_running) {
-                    int value = gpiod_ctxless_get_value("gpiochip3", 8, false, "sr501");
+    // 轮询线程独占，不占用 Executor 的共享队列，stop_listen_state 时唤醒并 join
+    listen_thread.thread = std::thread([fn = std::move(fn)]() {
+        try {
+            while(is_running) {
+                int value = gpiod_ctxless_get_value("gpiochip3", 8, false, "sr501");
 
-                    if(value == -1) {
-                        std::cout << "error" << std::endl;
-                    }
+                if(value == -1) {
+                    std::cout << "error" << std::endl;
+                }
 
-                    fn(value);
+                fn(value);
 
-                    std::this_thread::sleep_for(std::chrono::milliseconds(400));
-                }
-            } catch(std::exception & e) {
-                std::cout << "SR501---listen_state: " << e.what() << std::endl;
+                std::unique_lock<std::mutex> lock(listen_mutex);
+                listen_cond.wait_for(lock, std::chrono::milliseconds(400), []() { return !is_running; });
             }
-        },
-        fn)
-        .detach();
+        } catch(std::exception & e) {
+            std::cout << "SR501---listen_state: " << e.what() << std::endl;
+        }
+    });
 }
 
 void SR501::stop_listen_state()
 {
-    is_running = false;
+    {
+        std::lock_guard<std::mutex> lock(listen_mutex);
+        is_running = false;
+    }
+    listen_cond.notify_all();
+    if(listen_thread.thread.joinable()) {
+        listen_thread.thread.join();
+    }
 }
 
 void OLED::_i2c_init()
@@ -0,0 +1,29 @@
+#include "StartupTimeline.hpp"
+#include "Trace.hpp"
+#include <cstdio>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// 静态初始化在 main 之前执行，作为进程启动时间
+static const int64_t startup_origin_ns = trace_now_ns();
+
+static std::mutex startup_mutex;
+static std::vector<std::pair<int64_t, std::string>> startup_events;
+
+void startup_mark(const std::string & event)
+{
+    int64_t now_ns = trace_now_ns();
+
+    std::lock_guard<std::mutex> lock(startup_mutex);
+    startup_events.emplace_back(now_ns - startup_origin_ns, event);
+}
+
+void startup_report()
+{
+    std::lock_guard<std::mutex> lock(startup_mutex);
+    printf("startup timeline:\n");
+    for(auto & event : startup_events) {
+        printf("  %8.1fms  %s\n", event.first / 1e6, event.second.c_str());
+    }
+}
@@ -0,0 +1,235 @@
+#include "Trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+static const char * trace_stage_names[] = {
+    "camera_capture",          // TraceStage::CAMERA_CAPTURE
+    "preprocess",              // TraceStage::PREPROCESS
+    "npu_run",                 // TraceStage::NPU_RUN
+    "npu_output",              // TraceStage::NPU_OUTPUT
+    "yolo_post_process",       // TraceStage::YOLO_POST_PROCESS
+    "retinaface_post_process", // TraceStage::RETINAFACE_POST_PROCESS
+    "image_post_process",      // TraceStage::IMAGE_POST_PROCESS
+    "encode_send_frame",       // TraceStage::ENCODE_SEND_FRAME
+    "encode_write_frame",      // TraceStage::ENCODE_WRITE_FRAME
+    "model_init",              // TraceStage::MODEL_INIT
+    "model_warm_up",           // TraceStage::MODEL_WARM_UP
+    "npu_lease_wait",          // TraceStage::NPU_LEASE_WAIT
+};
+static_assert(sizeof(trace_stage_names) / sizeof(trace_stage_names[0]) == (size_t)TraceStage::COUNT,
+              "trace_stage_names does not match TraceStage");
+
+// 槽位按 seqlock 方式写入: sequence 为 0 表示正在写，写完后设置为 写入序号 + 1
+typedef struct {
+    std::atomic<uint64_t> sequence;
+    std::atomic<int64_t> start_ns;
+    std::atomic<int64_t> duration_ns;
+    std::atomic<int> stage;
+} trace_slot_t;
+
+typedef struct {
+    int tid;
+    std::atomic<uint64_t> head; // 下一次写入的序号，只有所属线程修改
+    trace_slot_t slots[TRACE_RING_SIZE];
+} trace_ring_t;
+
+typedef struct {
+    int tid;
+    int stage;
+    int64_t start_ns;
+    int64_t duration_ns;
+} trace_span_t;
+
+// 线程退出后环形缓冲区仍然保留，线程池中的线程都是常驻的，数量有限
+static std::mutex trace_rings_mutex;
+static std::vector<std::unique_ptr<trace_ring_t>> trace_rings;
+static thread_local trace_ring_t * trace_local_ring = nullptr;
+
+static trace_ring_t * get_local_ring()
+{
+    if(trace_local_ring == nullptr) {
+        auto ring = std::make_unique<trace_ring_t>();
+        ring->head.store(0, std::memory_order_relaxed);
+        for(auto & slot : ring->slots) {
+            slot.sequence.store(0, std::memory_order_relaxed);
+        }
+
+        std::lock_guard<std::mutex> lock(trace_rings_mutex);
+        ring->tid        = trace_rings.size() + 1;
+        trace_local_ring = ring.get();
+        trace_rings.push_back(std::move(ring));
+    }
+    return trace_local_ring;
+}
+
+bool trace_enabled()
+{
+    static const bool is_enabled = [] {
+        const char * env = getenv(TRACE_ENABLE_ENV);
+        return env == nullptr || atoi(env) != 0;
+    }();
+    return is_enabled;
+}
+
+int64_t trace_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void trace_record(TraceStage stage, int64_t start_ns, int64_t end_ns)
+{
+    if(!trace_enabled()) {
+        return;
+    }
+
+    trace_ring_t * ring = get_local_ring();
+    uint64_t index      = ring->head.load(std::memory_order_relaxed);
+    trace_slot_t & slot = ring->slots[index & (TRACE_RING_SIZE - 1)];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.start_ns.store(start_ns, std::memory_order_relaxed);
+    slot.duration_ns.store(end_ns - start_ns, std::memory_order_relaxed);
+    slot.stage.store((int)stage, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+
+    ring->head.store(index + 1, std::memory_order_release);
+}
+
+// 复制所有线程中仍保留的 span，跳过读取期间被覆盖的槽位
+static std::vector<trace_span_t> collect_spans()
+{
+    std::vector<trace_ring_t *> rings;
+    {
+        std::lock_guard<std::mutex> lock(trace_rings_mutex);
+        for(auto & ring : trace_rings) {
+            rings.push_back(ring.get());
+        }
+    }
+
+    std::vector<trace_span_t> spans;
+    for(auto ring : rings) {
+        uint64_t head  = ring->head.load(std::memory_order_acquire);
+        uint64_t first = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+
+        for(uint64_t index = first; index < head; index++) {
+            const trace_slot_t & slot = ring->slots[index & (TRACE_RING_SIZE - 1)];
+
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if(sequence != index + 1) {
+                continue;
+            }
+
+            trace_span_t span;
+            span.tid         = ring->tid;
+            span.start_ns    = slot.start_ns.load(std::memory_order_relaxed);
+            span.duration_ns = slot.duration_ns.load(std::memory_order_relaxed);
+            span.stage       = slot.stage.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                continue;
+            }
+            spans.push_back(span);
+        }
+    }
+    return spans;
+}
+
+void trace_get_stats(trace_stat_t stats[(int)TraceStage::COUNT])
+{
+    std::vector<double> durations[(int)TraceStage::COUNT];
+    for(auto & span : collect_spans()) {
+        durations[span.stage].push_back(span.duration_ns / 1000.0);
+    }
+
+    for(int i = 0; i < (int)TraceStage::COUNT; i++) {
+        auto & samples      = durations[i];
+        trace_stat_t & stat = stats[i];
+
+        stat.name   = trace_stage_names[i];
+        stat.count  = samples.size();
+        stat.avg_us = stat.p50_us = stat.p99_us = stat.max_us = 0;
+        if(samples.empty()) {
+            continue;
+        }
+
+        double sum = 0;
+        for(double sample : samples) {
+            sum += sample;
+        }
+        std::sort(samples.begin(), samples.end());
+
+        stat.avg_us = sum / stat.count;
+        stat.p50_us = samples[stat.count / 2];
+        stat.p99_us = samples[std::min(stat.count - 1, stat.count * 99 / 100)];
+        stat.max_us = samples[stat.count - 1];
+    }
+}
+
+void trace_print_stats()
+{
+    trace_stat_t stats[(int)TraceStage::COUNT];
+    trace_get_stats(stats);
+
+    printf("trace: stage latency (recent samples)\n");
+    for(auto & stat : stats) {
+        if(stat.count == 0) {
+            continue;
+        }
+        printf("  %-24s n=%-6d avg=%9.1fus p50=%9.1fus p99=%9.1fus max=%9.1fus\n", stat.name, stat.count,
+               stat.avg_us, stat.p50_us, stat.p99_us, stat.max_us);
+    }
+}
+
+int trace_dump_chrome(const char * path)
+{
+    auto spans = collect_spans();
+
+    FILE * fp = fopen(path, "w");
+    if(fp == nullptr) {
+        perror("trace_dump_chrome");
+        return -1;
+    }
+
+    fprintf(fp, "{\"traceEvents\":[\n");
+    for(size_t i = 0; i < spans.size(); i++) {
+        auto & span = spans[i];
+        fprintf(fp, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                trace_stage_names[span.stage], span.tid, span.start_ns / 1000.0, span.duration_ns / 1000.0,
+                i + 1 < spans.size() ? "," : "");
+    }
+    fprintf(fp, "],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(fp);
+    return 0;
+}
+
+void trace_report_if_due()
+{
+    static const char * dump_path = getenv(TRACE_DUMP_PATH_ENV);
+    static const int64_t interval_ns = [] {
+        const char * env = getenv(TRACE_REPORT_INTERVAL_ENV);
+        return (int64_t)(env ? atoi(env) : TRACE_REPORT_INTERVAL_DEFAULT) * 1000000;
+    }();
+    static int64_t last_report_ns = trace_now_ns();
+
+    if(dump_path == nullptr || !trace_enabled()) {
+        return;
+    }
+
+    int64_t now_ns = trace_now_ns();
+    if(now_ns - last_report_ns < interval_ns) {
+        return;
+    }
+    last_report_ns = now_ns;
+
+    trace_dump_chrome(dump_path);
+    trace_print_stats();
+}
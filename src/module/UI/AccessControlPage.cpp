@@ -1,3 +1,4 @@
+#include "Executor.hpp"
 #include "PageManager.hpp"
 #include "Sensor.hpp"
 #include "UI.hpp"
@@ -23,8 +24,8 @@ static LvImageDsc * video_frame_desc_ = new LvImageDsc;
 static LvImage * camera_display_;
 static LvLabel * registered_faces_label_;
 
-AccessControlPage::AccessControlPage(Camera & camera, FaceRknnPool & face_rknn_pool, ImageProcess & image_process)
-    : camera_(camera), face_rknn_pool_(face_rknn_pool), image_process_(image_process)
+AccessControlPage::AccessControlPage(FrameSource & camera, FaceRknnPool & face_rknn_pool)
+    : camera_(camera), face_rknn_pool_(face_rknn_pool)
 {
     primary_screen  = new LvObject(nullptr);
     standby_screen = new LvObject(nullptr);
@@ -129,18 +130,23 @@ void AccessControlPage::setup_face_registration_button()
         
     registration_button.add_event_cb(
         [&](lv_event_t * event, void * user_data) {
-            std::thread(
-                [&](LvLabel * label) {
-                    std::unique_lock<std::mutex> lock(capture_frame_mutex_);
+            Executor::instance().post(ExecutorQueue::NPU, [this]() {
+                if(!face_rknn_pool_.is_ready()) {
+                    return;
+                }
 
-                    auto current_frame = camera_.get_frame();
+                std::unique_lock<std::mutex> lock(capture_frame_mutex_);
 
-                    lock.unlock();
+                auto current_frame = camera_.get_frame();
 
-                    face_rknn_pool_.add_inference_task(std::move(current_frame), image_process_, true);
-                },
-                registered_faces_label_)
-                .detach();
+                lock.unlock();
+
+                if(!current_frame.image) {
+                    return;
+                }
+
+                face_rknn_pool_.add_inference_task(std::move(current_frame), get_image_process(), true);
+            });
 
             LvAsync::call([&]() {
                 registered_faces_label_->set_text(
@@ -150,12 +156,25 @@ void AccessControlPage::setup_face_registration_button()
         LV_EVENT_CLICKED, nullptr);
 }
 
+ImageProcess & AccessControlPage::get_image_process()
+{
+    std::call_once(image_process_once_, [this]() {
+        image_process_ = std::make_unique<ImageProcess>(camera_.get_width(), camera_.get_height(),
+                                                        face_rknn_pool_.get_retinaface_model_size());
+    });
+    return *image_process_;
+}
+
 void AccessControlPage::initialize_display_timer()
 {
     display_timer = new LvTimer(
         [&](lv_timer_t * timer_handle, void * user_data) {
-
-            std::shared_ptr<cv::Mat> processed_frame = face_rknn_pool_.get_image_result_from_queue();
+            // 在 LVGL 线程中运行，不能等待推理结果，没有可显示的帧时直接跳过本次刷新
+            Frame frame;
+            if(!face_rknn_pool_.get_result(frame, false)) {
+                return;
+            }
+            std::shared_ptr<cv::Mat> processed_frame = std::move(frame.image);
 
             if(processed_frame) {
 
@@ -179,6 +198,8 @@ void AccessControlPage::initialize_display_timer()
 
 void AccessControlPage::show()
 {
+    // 模型在后台加载，处理线程等待就绪后再开始推理
+    face_rknn_pool_.activate();
     activate_normal_display();
 
     SR501::listen_state([&](bool person_detected) {
@@ -219,6 +240,7 @@ void AccessControlPage::hide()
     display_timer->pause();
     processing_active = false;
     SR501::stop_listen_state();
+    face_rknn_pool_.release_after_idle();
 }
 
 void AccessControlPage::activate_normal_display()
@@ -227,12 +249,28 @@ void AccessControlPage::activate_normal_display()
 
     processing_active = true;
 
-    display_timer->resume();
-
     camera_display_->remove_flag(LV_OBJ_FLAG_HIDDEN);
 
     std::thread([&]() {
         try {
+            // 模型还在后台加载时等待，期间离开页面则直接退出
+            while(!face_rknn_pool_.is_ready()) {
+                if(!processing_active) {
+                    return;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(PAGE_MODEL_WAIT_INTERVAL_MS));
+            }
+
+            // 模型就绪后才开始刷新画面，在 LVGL 线程中恢复定时器，期间离开页面则保持暂停
+            lv_async_call(
+                [](void * page) {
+                    auto self = static_cast<AccessControlPage *>(page);
+                    if(self->processing_active) {
+                        self->display_timer->resume();
+                    }
+                },
+                this);
+
             camera_.start();
 
             while(processing_active) {
@@ -242,7 +280,11 @@ void AccessControlPage::activate_normal_display()
 
                 frame_lock.unlock();
 
-                face_rknn_pool_.add_inference_task(std::move(captured_frame), image_process_);
+                if(!captured_frame.image) {
+                    break;
+                }
+
+                face_rknn_pool_.add_inference_task(std::move(captured_frame), get_image_process());
             }
 
             face_rknn_pool_.clean_image_results();
@@ -1,3 +1,4 @@
+#include "Executor.hpp"
 #include "Font.hpp"
 #include "Lvgl.hpp"
 #include "UI.hpp"
@@ -28,9 +29,9 @@ static void opacity_animation_callback_(void * target, int32_t opacity_value)
     lv_obj_set_style_bg_opa((lv_obj_t *)target, opacity_value, 0);
 }
 
-SecurityCameraPage::SecurityCameraPage(Camera & camera, ImageProcess & image_process,
-                                       SecurityRknnPool & security_rknn_pool, FFmpeg & ffmpeg)
-    : camera_(camera), image_process_(image_process), security_rknn_pool_(security_rknn_pool), ffmpeg_(ffmpeg)
+SecurityCameraPage::SecurityCameraPage(CameraManager & camera_manager, SecurityRknnPool & security_rknn_pool,
+                                       FFmpeg & ffmpeg)
+    : camera_manager_(camera_manager), security_rknn_pool_(security_rknn_pool), ffmpeg_(ffmpeg)
 {
     surveillance_screen = new LvObject(nullptr);
     surveillance_screen->set_style_bg_image_src(&background, 0).set_style_text_font(Font16::get_font(), 0);
@@ -203,28 +204,24 @@ void SecurityCameraPage::initialize_video_timer()
 {
     refresh_timer = new LvTimer(
         [&](lv_timer_t * timer_handle, void * user_data) {
-            std::unique_lock<std::mutex> sync_lock(video_sync_mutex_);
-            sync_condition_.wait(sync_lock, [this]() { return !stream_processing_turn_ || !surveillance_active_; });
-
-            if(!surveillance_active_) {
-                return;
+            // 在 LVGL 线程中运行，只取处理线程交出的最新一帧，没有新帧时跳过本次刷新
+            std::shared_ptr<cv::Mat> processed_result;
+            {
+                std::lock_guard<std::mutex> display_lock(display_mutex_);
+                processed_result = std::move(display_image_);
             }
 
-            auto processed_result = security_rknn_pool_.get_image_result_from_queue();
-
-            stream_processing_turn_ = true;
-            sync_condition_.notify_one();
-
             if(processed_result) {
 
-                cv::resize(*processed_result, *processed_result, cv::Size(800, 450));
+                // 原图同时在推流队列中，缩放到页面自己的缓冲区
+                cv::resize(*processed_result, display_mat_, cv::Size(800, 450));
 
                 memset(video_stream_desc_, 0, sizeof(LvImageDsc));
 
-                video_stream_desc_->raw()->data      = processed_result->data;
-                video_stream_desc_->raw()->data_size = processed_result->total() * processed_result->elemSize();
-                video_stream_desc_->raw()->header.w  = processed_result->cols;
-                video_stream_desc_->raw()->header.h  = processed_result->rows;
+                video_stream_desc_->raw()->data      = display_mat_.data;
+                video_stream_desc_->raw()->data_size = display_mat_.total() * display_mat_.elemSize();
+                video_stream_desc_->raw()->header.w  = display_mat_.cols;
+                video_stream_desc_->raw()->header.h  = display_mat_.rows;
                 video_stream_desc_->raw()->header.cf = LV_COLOR_FORMAT_RGB888;
 
                 monitor_display_->set_src(video_stream_desc_->raw());
@@ -239,37 +236,64 @@ void SecurityCameraPage::show()
 
     surveillance_active_ = true;
 
+    // 模型在后台加载，处理线程等待就绪后再开始推理
+    security_rknn_pool_.activate();
+
     refresh_timer->resume();
 
     ffmpeg_.start_process_frame();
 
     std::thread([this]() {
+        std::lock_guard<std::mutex> processing_lock(processing_mutex_);
         try {
-            camera_.start();
-            while(surveillance_active_) {
-                auto captured_frame = camera_.get_frame();
-                security_rknn_pool_.add_inference_task(std::move(captured_frame), image_process_);
-                {
-                    std::unique_lock<std::mutex> sync_lock(video_sync_mutex_);
-                    // 等待直到轮到流处理线程取帧
-                    sync_condition_.wait(sync_lock, [this]() { return stream_processing_turn_; });
-                    auto detection_result = security_rknn_pool_.get_image_result_from_queue(true);
+            // 模型还在后台加载时等待，期间离开页面则直接退出
+            while(!security_rknn_pool_.is_ready()) {
+                if(!surveillance_active_) {
+                    return;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(PAGE_MODEL_WAIT_INTERVAL_MS));
+            }
+            camera_manager_.init_image_process(security_rknn_pool_.get_yolo_model_size());
 
-                    stream_processing_turn_ = false;
-                    sync_condition_.notify_one();
+            camera_manager_.start();
+            while(surveillance_active_) {
+                // 各路轮流取帧，超时后重新检查是否退出
+                Frame captured_frame;
+                if(!camera_manager_.next_frame(captured_frame)) {
+                    continue;
+                }
+                int stream_id = captured_frame.stream_id;
+                security_rknn_pool_.add_inference_task(std::move(captured_frame),
+                                                       camera_manager_.get_image_process(stream_id));
+
+                // 其他路的结果不参与显示和推流
+                camera_manager_.drain_results(security_rknn_pool_);
+
+                // 主路结果不等待，已完成的依次推流并处理录像和报警，最新一帧交给显示定时器
+                Frame detection_result;
+                while(security_rknn_pool_.get_result(CAMERA_MANAGER_PRIMARY_STREAM, detection_result)) {
+                    camera_manager_.record_result(detection_result);
+                    // 直接交出 frame.image，编码线程用完后才归还零拷贝帧的驱动缓冲区
+                    ffmpeg_.push_frame(detection_result.image);
+                    {
+                        std::lock_guard<std::mutex> display_lock(display_mutex_);
+                        display_image_ = detection_result.image;
+                    }
 
-                    if(detection_result) {
-                        ffmpeg_.push_frame(std::move(detection_result));
+                    // 自动录像逻辑处理
+                    handle_auto_recording_logic();
 
-                        // 自动录像逻辑处理
-                        handle_auto_recording_logic();
+                    // 报警处理逻辑
+                    handle_alert_logic();
 
-                        // 报警处理逻辑
-                        handle_alert_logic();
-                    }
+                    detection_result = Frame();
                 }
             }
-            camera_.stop();
+            {
+                std::lock_guard<std::mutex> display_lock(display_mutex_);
+                display_image_.reset();
+            }
+            camera_manager_.stop();
         } catch(std::exception & error) {
             std::cerr << "Error: " << error.what() << std::endl;
         }
@@ -313,14 +337,27 @@ void SecurityCameraPage::handle_alert_logic()
 {
     if(alert_enabled_ && security_rknn_pool_.is_person && !alert_processing_) {
         alert_processing_ = true;
-        std::thread([this]() {
-            lv_async_call([](void *) { detection_alert_label->remove_flag(LV_OBJ_FLAG_HIDDEN); }, nullptr);
+
+        // 在 LVGL 线程中显示提示，一次性定时器到时后隐藏并允许下一次报警
+        lv_async_call(
+            [](void * page) {
+                detection_alert_label->remove_flag(LV_OBJ_FLAG_HIDDEN);
+                lv_timer_t * timer = lv_timer_create(
+                    [](lv_timer_t * timer) {
+                        auto self = static_cast<SecurityCameraPage *>(lv_timer_get_user_data(timer));
+                        detection_alert_label->add_flag(LV_OBJ_FLAG_HIDDEN);
+                        self->alert_processing_ = false;
+                    },
+                    SECURITY_CAMERA_PAGE_ALERT_DURATION_MS, page);
+                lv_timer_set_repeat_count(timer, 1);
+            },
+            this);
+
+        // paplay 阻塞到播放结束，放在 IO 队列中，不占用刷新 OLED 的 UI 队列
+        Executor::instance().post(ExecutorQueue::IO, []() {
             execute_command("sudo -u elf env XDG_RUNTIME_DIR=/run/user/$(id -u elf) "
                         "PULSE_SERVER=unix:/run/user/$(id -u elf)/pulse/native paplay /home/elf/Downloads/alert.wav");
-            std::this_thread::sleep_for(std::chrono::seconds(2));
-            alert_processing_ = false;
-            lv_async_call([](void *) { detection_alert_label->add_flag(LV_OBJ_FLAG_HIDDEN); }, nullptr);
-        }).detach();
+        });
     }
 }
 
@@ -331,6 +368,8 @@ void SecurityCameraPage::hide()
     surveillance_active_ = false;
 
     refresh_timer->pause();
+
+    security_rknn_pool_.release_after_idle();
 }
 
 void SecurityCameraPage::start_manual_recording()